@@ -52,6 +52,7 @@ static MonoClass* class_TimestampSubHeader = 0;
 static MonoClass* class_TimestampSubData = 0;
 static MonoClass* class_ParserResult = 0;
 static MonoClass* class_Utils = 0;
+static MonoClass* class_Log = 0;
 static MonoClass* class_MaybeBuilder = 0;
 static MonoClass* class_DateTime = 0;
 static MonoClass* class_Result = 0;
@@ -65,6 +66,55 @@ static MonoClass* class_Convert = 0;
 static MonoClass* class_Option = 0;
 static MonoClass* class_ActivePatterns = 0;
 
+static void __lookup_class_Parser();
+static void __lookup_class_DataTableFLUMORE();
+static void __lookup_class_DataRowFLUMORE();
+static void __lookup_class_Log();
+
+/* The methods called by the FME reader. They are resolved through one
+ * table, so ImportSimulationData_warmUp can resolve and compile all of
+ * them before the first dataset is parsed. */
+enum
+{
+    __method_Parser_getSimulationFileData,
+    __method_Parser_lastStatistics,
+    __method_Parser_setMaxThreads,
+    __method_DataTableFLUMORE_get_data,
+    __method_DataTableFLUMORE_get_time,
+    __method_Log_setLevel,
+    __method_Log_drain,
+    __method_Log_lastSeverities,
+    __method_count
+};
+
+static const struct
+{
+    const char* name;
+    void (*lookup_class)();
+    MonoClass** klass;
+} __method_table[__method_count] = {
+    { "Parser:getSimulationFileData(string)", __lookup_class_Parser, &class_Parser },
+    { "Parser:lastStatistics()", __lookup_class_Parser, &class_Parser },
+    { "Parser:setMaxThreads(int)", __lookup_class_Parser, &class_Parser },
+    { "Definitions/DataTableFLUMORE:get_data()", __lookup_class_DataTableFLUMORE, &class_DataTableFLUMORE },
+    { "Definitions/DataTableFLUMORE:get_time()", __lookup_class_DataTableFLUMORE, &class_DataTableFLUMORE },
+    { "Log:setLevel(int)", __lookup_class_Log, &class_Log },
+    { "Log:drain()", __lookup_class_Log, &class_Log },
+    { "Log:lastSeverities()", __lookup_class_Log, &class_Log },
+};
+
+static MonoMethod* __methods[__method_count];
+
+static MonoMethod* __lookup_method(int index)
+{
+    if (!__methods[index])
+    {
+        __method_table[index].lookup_class();
+        __methods[index] = mono_embeddinator_lookup_method(__method_table[index].name, *__method_table[index].klass);
+    }
+    return __methods[index];
+}
+
 static void __initialize_mono()
 {
     if (__mono_context.domain)
@@ -119,14 +169,7 @@ void Parser_testUnicodeNameaeae()
 
 _DataTableFLUMOREArray Parser_getSimulationFileData(const char* path)
 {
-    const char __method_name[] = "Parser:getSimulationFileData(string)";
-    static MonoMethod *__method = 0;
-
-    if (!__method)
-    {
-        __lookup_class_Parser();
-        __method = mono_embeddinator_lookup_method(__method_name, class_Parser);
-    }
+    MonoMethod* __method = __lookup_method(__method_Parser_getSimulationFileData);
 
     void* __args[1];
     MonoString* __path_0 = (path) ? mono_string_new(__mono_context.domain, path) : 0;
@@ -145,11 +188,12 @@ _DataTableFLUMOREArray Parser_getSimulationFileData(const char* path)
     class_DataTableFLUMORE = mono_class_from_name(__ImportSimulationData_dll_image, "", "Definitions/DataTableFLUMORE");
     MonoClass* ____result_element_class = mono_class_get_element_class(class_DataTableFLUMORE);
     gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    DataTableFLUMORE** ____result_native_elements = (DataTableFLUMORE**) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
     for (int __i = 0; __i < ____result_array_size; __i++)
     {
         MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
         DataTableFLUMORE* ____result_array_element_obj = ____result_array_element ? (DataTableFLUMORE*) mono_embeddinator_create_object(____result_array_element) : 0;
-        g_array_append_val(____result_native_array.array, ____result_array_element_obj);
+        ____result_native_elements[__i] = ____result_array_element_obj;
     }
 
     return ____result_native_array;
@@ -178,15 +222,70 @@ _Int32Array Parser_test()
     ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/TRUE, sizeof(int32_t), ____result_array_size);
     MonoClass* ____result_element_class = mono_class_get_element_class(mono_get_int32_class());
     gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
-    for (int __i = 0; __i < ____result_array_size; __i++)
+    if (____result_array_size > 0 && ____result_array_element_size == sizeof(int32_t))
+    {
+        /* The managed elements are contiguous, copied in one go. */
+        g_array_append_vals(____result_native_array.array, mono_array_addr_with_size(____result_array, ____result_array_element_size, 0), (guint)____result_array_size);
+    }
+    else
+    {
+        for (int __i = 0; __i < ____result_array_size; __i++)
+        {
+            char* ____result_array_element = mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
+            g_array_append_val(____result_native_array.array, *((int32_t*)____result_array_element));
+        }
+    }
+
+    return ____result_native_array;
+}
+
+_Int64Array Parser_lastStatistics()
+{
+    MonoMethod* __method = __lookup_method(__method_Parser_lastStatistics);
+
+    MonoObject* __exception = 0;
+    MonoObject* __result = mono_runtime_invoke(__method, 0, 0, &__exception);
+
+    if (__exception)
+        mono_embeddinator_throw_exception(__exception);
+
+    MonoArray* ____result_array = (MonoArray*) __result;
+    uintptr_t ____result_array_size = mono_array_length(____result_array);
+    _Int64Array ____result_native_array;
+    ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/TRUE, sizeof(int64_t), ____result_array_size);
+    MonoClass* ____result_element_class = mono_class_get_element_class(mono_get_int64_class());
+    gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    if (____result_array_size > 0 && ____result_array_element_size == sizeof(int64_t))
     {
-        char* ____result_array_element = mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
-        g_array_append_val(____result_native_array.array, *((int32_t*)____result_array_element));
+        /* The managed elements are contiguous, copied in one go. */
+        g_array_append_vals(____result_native_array.array, mono_array_addr_with_size(____result_array, ____result_array_element_size, 0), (guint)____result_array_size);
+    }
+    else
+    {
+        for (int __i = 0; __i < ____result_array_size; __i++)
+        {
+            char* ____result_array_element = mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
+            g_array_append_val(____result_native_array.array, *((int64_t*)____result_array_element));
+        }
     }
 
     return ____result_native_array;
 }
 
+void Parser_setMaxThreads(int32_t value)
+{
+    MonoMethod* __method = __lookup_method(__method_Parser_setMaxThreads);
+
+    void* __args[1];
+    __args[0] = &value;
+
+    MonoObject* __exception = 0;
+    MonoObject* __result = mono_runtime_invoke(__method, 0, __args, &__exception);
+
+    if (__exception)
+        mono_embeddinator_throw_exception(__exception);
+}
+
 _FooArray Parser_foo()
 {
     const char __method_name[] = "Parser:foo()";
@@ -211,11 +310,12 @@ _FooArray Parser_foo()
     class_Foo = mono_class_from_name(__ImportSimulationData_dll_image, "", "Parser/Foo");
     MonoClass* ____result_element_class = mono_class_get_element_class(class_Foo);
     gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    Foo** ____result_native_elements = (Foo**) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
     for (int __i = 0; __i < ____result_array_size; __i++)
     {
         MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
         Foo* ____result_array_element_obj = ____result_array_element ? (Foo*) mono_embeddinator_create_object(____result_array_element) : 0;
-        g_array_append_val(____result_native_array.array, ____result_array_element_obj);
+        ____result_native_elements[__i] = ____result_array_element_obj;
     }
 
     return ____result_native_array;
@@ -291,11 +391,12 @@ _DataRowFLUMOREArray DataTableFLUMORE_get_data(DataTableFLUMORE* object)
     class_DataRowFLUMORE = mono_class_from_name(__ImportSimulationData_dll_image, "", "Definitions/DataRowFLUMORE");
     MonoClass* ____result_element_class = mono_class_get_element_class(class_DataRowFLUMORE);
     gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    DataRowFLUMORE** ____result_native_elements = (DataRowFLUMORE**) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
     for (int __i = 0; __i < ____result_array_size; __i++)
     {
         MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
         DataRowFLUMORE* ____result_array_element_obj = ____result_array_element ? (DataRowFLUMORE*) mono_embeddinator_create_object(____result_array_element) : 0;
-        g_array_append_val(____result_native_array.array, ____result_array_element_obj);
+        ____result_native_elements[__i] = ____result_array_element_obj;
     }
 
     return ____result_native_array;
@@ -303,14 +404,7 @@ _DataRowFLUMOREArray DataTableFLUMORE_get_data(DataTableFLUMORE* object)
 
 const char* DataTableFLUMORE_get_time(DataTableFLUMORE* object)
 {
-    const char __method_name[] = "Definitions/DataTableFLUMORE:get_time()";
-    static MonoMethod *__method = 0;
-
-    if (!__method)
-    {
-        __lookup_class_DataTableFLUMORE();
-        __method = mono_embeddinator_lookup_method(__method_name, class_DataTableFLUMORE);
-    }
+    MonoMethod* __method = __lookup_method(__method_DataTableFLUMORE_get_time);
 
     MonoObject* __instance = mono_gchandle_get_target(object->_handle);
     MonoObject* __exception = 0;
@@ -733,6 +827,88 @@ bool DataRowFLUMORE_Equals_1(DataRowFLUMORE* object, DataRowFLUMORE* obj)
     return *((bool*)__unbox);
 }
 
+/* The backing fields of the record fields, in the order of DataRowFLUMOREValue. */
+static const char* const __DataRowFLUMORE_field_names[7] = { "id@", "x@", "y@", "z@", "wsp@", "h@", "vres@" };
+static const char* const __DataRowFLUMORE_getter_names[7] = {
+    "Definitions/DataRowFLUMORE:get_id()", "Definitions/DataRowFLUMORE:get_x()", "Definitions/DataRowFLUMORE:get_y()",
+    "Definitions/DataRowFLUMORE:get_z()", "Definitions/DataRowFLUMORE:get_wsp()", "Definitions/DataRowFLUMORE:get_h()",
+    "Definitions/DataRowFLUMORE:get_vres()" };
+static const size_t __DataRowFLUMOREValue_offsets[7] = {
+    offsetof(DataRowFLUMOREValue, id), offsetof(DataRowFLUMOREValue, x), offsetof(DataRowFLUMOREValue, y),
+    offsetof(DataRowFLUMOREValue, z), offsetof(DataRowFLUMOREValue, wsp), offsetof(DataRowFLUMOREValue, h),
+    offsetof(DataRowFLUMOREValue, vres) };
+
+/* Offsets of the fields within a row object, -1 if the field wasn't
+ * found and the getter is called instead. */
+static int32_t __DataRowFLUMORE_field_offsets[7];
+static MonoMethod* __DataRowFLUMORE_getters[7];
+static bool __DataRowFLUMORE_fields_resolved = false;
+
+static void __lookup_fields_DataRowFLUMORE()
+{
+    if (__DataRowFLUMORE_fields_resolved)
+        return;
+    __lookup_class_DataRowFLUMORE();
+    for (int __f = 0; __f < 7; __f++)
+    {
+        MonoClassField* __field = mono_class_get_field_from_name(class_DataRowFLUMORE, __DataRowFLUMORE_field_names[__f]);
+        __DataRowFLUMORE_field_offsets[__f] = __field ? (int32_t) mono_field_get_offset(__field) : -1;
+        __DataRowFLUMORE_getters[__f] = __field ? 0 : mono_embeddinator_lookup_method(__DataRowFLUMORE_getter_names[__f], class_DataRowFLUMORE);
+    }
+    __DataRowFLUMORE_fields_resolved = true;
+}
+
+_DataRowFLUMOREValueArray DataTableFLUMORE_get_data_values(DataTableFLUMORE* object)
+{
+    MonoMethod* __method = __lookup_method(__method_DataTableFLUMORE_get_data);
+    __lookup_fields_DataRowFLUMORE();
+
+    MonoObject* __instance = mono_gchandle_get_target(object->_handle);
+    MonoObject* __exception = 0;
+    MonoObject* __result = mono_runtime_invoke(__method, __instance, 0, &__exception);
+
+    if (__exception)
+        mono_embeddinator_throw_exception(__exception);
+
+    /* __result stays on the stack, so the array and its rows are kept
+     * alive by the conservative stack scan while they are copied. */
+    MonoArray* ____result_array = (MonoArray*) __result;
+    uintptr_t ____result_array_size = mono_array_length(____result_array);
+    _DataRowFLUMOREValueArray ____result_native_array;
+    ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/FALSE, sizeof(DataRowFLUMOREValue), ____result_array_size);
+    DataRowFLUMOREValue* ____result_native_elements = (DataRowFLUMOREValue*) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
+    for (uintptr_t __i = 0; __i < ____result_array_size; __i++)
+    {
+        MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, sizeof(MonoObject*), __i);
+        DataRowFLUMOREValue* __value = &____result_native_elements[__i];
+        if (!____result_array_element)
+        {
+            __value->id = -1;
+            __value->x = __value->y = __value->z = __value->wsp = __value->h = __value->vres = -1.0;
+            continue;
+        }
+        for (int __f = 0; __f < 7; __f++)
+        {
+            const size_t __size = (__f == 0) ? sizeof(int32_t) : sizeof(double);
+            const char* __source;
+            if (__DataRowFLUMORE_field_offsets[__f] >= 0)
+            {
+                __source = (const char*) ____result_array_element + __DataRowFLUMORE_field_offsets[__f];
+            }
+            else
+            {
+                MonoObject* __boxed = mono_runtime_invoke(__DataRowFLUMORE_getters[__f], ____result_array_element, 0, &__exception);
+                if (__exception)
+                    mono_embeddinator_throw_exception(__exception);
+                __source = (const char*) mono_object_unbox(__boxed);
+            }
+            memcpy((char*) __value + __DataRowFLUMOREValue_offsets[__f], __source, __size);
+        }
+    }
+
+    return ____result_native_array;
+}
+
 static void __lookup_class_Foo()
 {
     if (class_Foo == 0)
@@ -4951,11 +5127,12 @@ _StringArray ParserResult_get_AllLines(ParserResult* object)
     ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/TRUE, sizeof(const char*), ____result_array_size);
     MonoClass* ____result_element_class = mono_class_get_element_class(mono_get_string_class());
     gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    const char** ____result_native_elements = (const char**) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
     for (int __i = 0; __i < ____result_array_size; __i++)
     {
         MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
         char* __string = mono_string_to_utf8((MonoString*) ____result_array_element);
-        g_array_append_val(____result_native_array.array, __string);
+        ____result_native_elements[__i] = __string;
     }
 
     return ____result_native_array;
@@ -5297,11 +5474,12 @@ _StringArray Regex_Split(const char* pattern, const char* input)
     ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/TRUE, sizeof(const char*), ____result_array_size);
     MonoClass* ____result_element_class = mono_class_get_element_class(mono_get_string_class());
     gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    const char** ____result_native_elements = (const char**) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
     for (int __i = 0; __i < ____result_array_size; __i++)
     {
         MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
         char* __string = mono_string_to_utf8((MonoString*) ____result_array_element);
-        g_array_append_val(____result_native_array.array, __string);
+        ____result_native_elements[__i] = __string;
     }
 
     return ____result_native_array;
@@ -5366,3 +5544,105 @@ static void __lookup_class_ActivePatterns()
         class_ActivePatterns = mono_class_from_name(__ImportSimulationData_dll_image, "", "Utils/ActivePatterns");
     }
 }
+
+static void __lookup_class_Log()
+{
+    if (class_Log == 0)
+    {
+        __initialize_mono();
+        __lookup_assembly_ImportSimulationData_dll();
+        class_Log = mono_class_from_name(__ImportSimulationData_dll_image, "", "Log");
+    }
+}
+
+void Log_setLevel(int32_t value)
+{
+    MonoMethod* __method = __lookup_method(__method_Log_setLevel);
+
+    void* __args[1];
+    __args[0] = &value;
+
+    MonoObject* __exception = 0;
+    MonoObject* __result = mono_runtime_invoke(__method, 0, __args, &__exception);
+
+    if (__exception)
+        mono_embeddinator_throw_exception(__exception);
+}
+
+_StringArray Log_drain()
+{
+    MonoMethod* __method = __lookup_method(__method_Log_drain);
+
+    MonoObject* __exception = 0;
+    MonoObject* __result = mono_runtime_invoke(__method, 0, 0, &__exception);
+
+    if (__exception)
+        mono_embeddinator_throw_exception(__exception);
+
+    MonoArray* ____result_array = (MonoArray*) __result;
+    uintptr_t ____result_array_size = mono_array_length(____result_array);
+    _StringArray ____result_native_array;
+    ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/TRUE, sizeof(const char*), ____result_array_size);
+    MonoClass* ____result_element_class = mono_class_get_element_class(mono_get_string_class());
+    gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    const char** ____result_native_elements = (const char**) g_array_append_uninitialized(____result_native_array.array, (guint)____result_array_size);
+    for (int __i = 0; __i < ____result_array_size; __i++)
+    {
+        MonoObject* ____result_array_element = *(MonoObject**) mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
+        char* __string = mono_string_to_utf8((MonoString*) ____result_array_element);
+        ____result_native_elements[__i] = __string;
+    }
+
+    return ____result_native_array;
+}
+
+_Int32Array Log_lastSeverities()
+{
+    MonoMethod* __method = __lookup_method(__method_Log_lastSeverities);
+
+    MonoObject* __exception = 0;
+    MonoObject* __result = mono_runtime_invoke(__method, 0, 0, &__exception);
+
+    if (__exception)
+        mono_embeddinator_throw_exception(__exception);
+
+    MonoArray* ____result_array = (MonoArray*) __result;
+    uintptr_t ____result_array_size = mono_array_length(____result_array);
+    _Int32Array ____result_native_array;
+    ____result_native_array.array = g_array_sized_new(/*zero_terminated=*/FALSE, /*clear_=*/TRUE, sizeof(int32_t), ____result_array_size);
+    MonoClass* ____result_element_class = mono_class_get_element_class(mono_get_int32_class());
+    gint32 ____result_array_element_size = mono_class_array_element_size(____result_element_class);
+    if (____result_array_size > 0 && ____result_array_element_size == sizeof(int32_t))
+    {
+        /* The managed elements are contiguous, copied in one go. */
+        g_array_append_vals(____result_native_array.array, mono_array_addr_with_size(____result_array, ____result_array_element_size, 0), (guint)____result_array_size);
+    }
+    else
+    {
+        for (int __i = 0; __i < ____result_array_size; __i++)
+        {
+            char* ____result_array_element = mono_array_addr_with_size(____result_array, ____result_array_element_size, __i);
+            g_array_append_val(____result_native_array.array, *((int32_t*)____result_array_element));
+        }
+    }
+
+    return ____result_native_array;
+}
+
+void ImportSimulationData_warmUp()
+{
+    static bool __warm = false;
+    if (__warm)
+        return;
+    __initialize_mono();
+    __lookup_assembly_ImportSimulationData_dll();
+    __lookup_fields_DataRowFLUMORE();
+    for (int __i = 0; __i < __method_count; __i++)
+    {
+        /* Compiling here moves the JIT cost of the entry points out of
+         * the first read. With an AOT image of the assembly next to it
+         * this only looks up the precompiled code. */
+        mono_compile_method(__lookup_method(__i));
+    }
+    __warm = true;
+}
@@ -53,6 +53,7 @@ typedef MonoEmbedObject TimestampSubHeader;
 typedef MonoEmbedObject TimestampSubData;
 typedef MonoEmbedObject ParserResult;
 typedef MonoEmbedObject Utils;
+typedef MonoEmbedObject Log;
 typedef MonoEmbedObject MaybeBuilder;
 typedef MonoEmbedObject DateTime;
 typedef MonoEmbedObject Result;
@@ -68,6 +69,8 @@ typedef MonoEmbedObject ActivePatterns;
 MONO_EMBEDDINATOR_API void Parser_testUnicodeNameaeae();
 MONO_EMBEDDINATOR_API _DataTableFLUMOREArray Parser_getSimulationFileData(const char* path);
 MONO_EMBEDDINATOR_API _Int32Array Parser_test();
+MONO_EMBEDDINATOR_API _Int64Array Parser_lastStatistics();
+MONO_EMBEDDINATOR_API void Parser_setMaxThreads(int32_t value);
 MONO_EMBEDDINATOR_API _FooArray Parser_foo();
 
 MONO_EMBEDDINATOR_API DataTableFLUMORE* DataTableFLUMORE_NewTable(_DataRowFLUMOREArray _data, const char* _time);
@@ -91,6 +94,24 @@ MONO_EMBEDDINATOR_API int32_t DataRowFLUMORE_CompareTo(DataRowFLUMORE* object, D
 MONO_EMBEDDINATOR_API DataRowFLUMORE* DataRowFLUMORE_get_Invalid();
 MONO_EMBEDDINATOR_API bool DataRowFLUMORE_Equals_1(DataRowFLUMORE* object, DataRowFLUMORE* obj);
 
+/* The fields of a DataRowFLUMORE copied out of the managed record. */
+typedef struct
+{
+    int32_t id;
+    double x;
+    double y;
+    double z;
+    double wsp;
+    double h;
+    double vres;
+} DataRowFLUMOREValue;
+typedef MonoEmbedArray _DataRowFLUMOREValueArray;
+
+/* Like DataTableFLUMORE_get_data, but the rows are copied into an array
+ * of DataRowFLUMOREValue in one pass, without a MonoEmbedObject or GC
+ * handle per row. Null rows get the values of DataRowFLUMORE.Invalid. */
+MONO_EMBEDDINATOR_API _DataRowFLUMOREValueArray DataTableFLUMORE_get_data_values(DataTableFLUMORE* object);
+
 MONO_EMBEDDINATOR_API Foo* Foo_NewBar(int32_t item);
 MONO_EMBEDDINATOR_API int32_t Foo_get_Item(Foo* object);
 MONO_EMBEDDINATOR_API int32_t Foo_get_Tag(Foo* object);
@@ -306,4 +327,13 @@ MONO_EMBEDDINATOR_API bool Regex_isMatch(const char* pattern, const char* input)
 MONO_EMBEDDINATOR_API _StringArray Regex_Split(const char* pattern, const char* input);
 MONO_EMBEDDINATOR_API const char* Regex_Replace(const char* pattern, const char* replacement, const char* input);
 
+MONO_EMBEDDINATOR_API void Log_setLevel(int32_t value);
+MONO_EMBEDDINATOR_API _StringArray Log_drain();
+MONO_EMBEDDINATOR_API _Int32Array Log_lastSeverities();
+
+/* Starts the runtime, loads ImportSimulationData.dll and resolves and
+ * compiles the methods the FME reader calls. Later calls return at
+ * once; concurrent calls have to be serialized by the caller. */
+MONO_EMBEDDINATOR_API void ImportSimulationData_warmUp();
+
 MONO_EMBEDDINATOR_END_DECLS
@@ -84,6 +84,14 @@ g_assertion_message (const gchar *format, ...)
 
 #define INITIAL_CAPACITY 16
 
+/*
+ * The elements start on a 64 byte boundary, so bulk numeric data can be
+ * read with aligned vector loads. Memory is only cleared where clear_
+ * makes elements visible without a value, i.e. in g_array_set_size;
+ * appended elements are copied over uninitialized memory.
+ */
+#define G_ARRAY_ALIGNMENT 64
+
 #define element_offset(p,i) ((p)->array.data + (i) * (p)->element_size)
 #define element_length(p,i) ((i) * (p)->element_size)
 
@@ -93,42 +101,57 @@ typedef struct {
   guint element_size;
   gboolean zero_terminated;
   guint capacity;
+  /* the block holding array.data, as returned by g_malloc */
+  gchar *allocation;
 } GArrayPriv;
 
 static void
 ensure_capacity (GArrayPriv *priv, guint capacity)
 {
   guint new_capacity;
-  
+  gchar *allocation;
+  gchar *data;
+
   if (capacity <= priv->capacity)
     return;
-  
-  new_capacity = (capacity + 63) & ~63;
-  
-  priv->array.data = g_realloc (priv->array.data, element_length (priv, new_capacity));
-  
-  if (priv->clear_) {
-    memset (element_offset (priv, priv->capacity),
-      0,
-      element_length (priv, new_capacity - priv->capacity));
+
+  /* Grow geometrically, so appending one element at a time stays linear. */
+  new_capacity = priv->capacity + priv->capacity / 2;
+  if (new_capacity < capacity)
+    new_capacity = capacity;
+  new_capacity = (new_capacity + 63) & ~63;
+
+  allocation = g_malloc (element_length (priv, new_capacity) + G_ARRAY_ALIGNMENT - 1);
+  data = (gchar*) (((uintptr_t) allocation + G_ARRAY_ALIGNMENT - 1) & ~(uintptr_t) (G_ARRAY_ALIGNMENT - 1));
+
+  if (priv->array.data != NULL) {
+    memcpy (data,
+      priv->array.data,
+      element_length (priv, priv->array.len + (priv->zero_terminated ? 1 : 0)));
   }
-  
+  g_free (priv->allocation);
+
+  priv->allocation = allocation;
+  priv->array.data = data;
   priv->capacity = new_capacity;
 }
 
+static void
+terminate (GArrayPriv *priv)
+{
+  if (priv->zero_terminated) {
+    memset (element_offset (priv, priv->array.len),
+      0,
+      priv->element_size);
+  }
+}
+
 GArray *
 g_array_new (gboolean zero_terminated,
        gboolean clear_,
        guint element_size)
 {
-  GArrayPriv *rv = g_new0 (GArrayPriv, 1);
-  rv->zero_terminated = zero_terminated;
-  rv->clear_ = clear_;
-  rv->element_size = element_size;
-
-  ensure_capacity (rv, INITIAL_CAPACITY);
-
-  return (GArray*)rv;
+  return g_array_sized_new (zero_terminated, clear_, element_size, INITIAL_CAPACITY);
 }
 
 GArray *
@@ -142,7 +165,8 @@ g_array_sized_new (gboolean zero_terminated,
   rv->clear_ = clear_;
   rv->element_size = element_size;
 
-  ensure_capacity (rv, reserved_size);
+  ensure_capacity (rv, reserved_size + (zero_terminated ? 1 : 0));
+  terminate (rv);
 
   return (GArray*)rv;
 }
@@ -151,41 +175,71 @@ gchar*
 g_array_free (GArray *array,
         gboolean free_segment)
 {
+  GArrayPriv *priv = (GArrayPriv*)array;
   gchar* rv = NULL;
 
   g_return_val_if_fail (array != NULL, NULL);
 
-  if (free_segment)
-    g_free (array->data);
-  else
-    rv = array->data;
+  if (free_segment) {
+    g_free (priv->allocation);
+  } else {
+    /* The caller frees the segment with g_free, so it has to start at
+     * the allocation. It is big enough to hold the elements there. */
+    rv = priv->allocation;
+    if (rv != array->data) {
+      memmove (rv,
+        array->data,
+        element_length (priv, array->len + (priv->zero_terminated ? 1 : 0)));
+    }
+  }
 
   g_free (array);
 
   return rv;
 }
 
-GArray *
-g_array_append_vals (GArray *array,
-         gconstpointer data,
+void
+g_array_reserve (GArray *array,
+     guint len)
+{
+  GArrayPriv *priv = (GArrayPriv*)array;
+
+  g_return_if_fail (array != NULL);
+
+  ensure_capacity (priv, priv->array.len + len + (priv->zero_terminated ? 1 : 0));
+}
+
+gpointer
+g_array_append_uninitialized (GArray *array,
          guint len)
 {
   GArrayPriv *priv = (GArrayPriv*)array;
+  gchar *rv;
 
   g_return_val_if_fail (array != NULL, NULL);
 
   ensure_capacity (priv, priv->array.len + len + (priv->zero_terminated ? 1 : 0));
-  
-  memmove (element_offset (priv, priv->array.len),
-     data,
-     element_length (priv, len));
 
+  rv = element_offset (priv, priv->array.len);
   priv->array.len += len;
+  terminate (priv);
 
-  if (priv->zero_terminated) {
-    memset (element_offset (priv, priv->array.len),
-      0,
-      priv->element_size);
+  return rv;
+}
+
+GArray *
+g_array_append_vals (GArray *array,
+         gconstpointer data,
+         guint len)
+{
+  GArrayPriv *priv = (GArrayPriv*)array;
+
+  g_return_val_if_fail (array != NULL, NULL);
+
+  if (len > 0) {
+    memcpy (g_array_append_uninitialized (array, len),
+      data,
+      element_length (priv, len));
   }
 
   return array;
@@ -216,11 +270,7 @@ g_array_insert_vals (GArray *array,
 
   array->len += len;
 
-  if (priv->zero_terminated) {
-    memset (element_offset (priv, priv->array.len),
-      0,
-      priv->element_size);
-  }
+  terminate (priv);
 
   return array;
 }
@@ -235,15 +285,11 @@ g_array_remove_index (GArray *array,
 
   memmove (element_offset (priv, index_),
      element_offset (priv, index_ + 1),
-     element_length (priv, array->len - index_));
+     element_length (priv, array->len - index_ - 1));
 
   array->len --;
 
-  if (priv->zero_terminated) {
-    memset (element_offset (priv, priv->array.len),
-      0,
-      priv->element_size);
-  }
+  terminate (priv);
 
   return array;
 }
@@ -262,11 +308,7 @@ g_array_remove_index_fast (GArray *array,
 
   array->len --;
 
-  if (priv->zero_terminated) {
-    memset (element_offset (priv, priv->array.len),
-      0,
-      priv->element_size);
-  }
+  terminate (priv);
 
   return array;
 }
@@ -279,15 +321,19 @@ g_array_set_size (GArray *array, gint length)
   g_return_if_fail (array != NULL);
   g_return_if_fail (length >= 0);
 
-  if (length == priv->capacity)
-    return; // nothing to be done
+  if (length > array->len) {
+    ensure_capacity (priv, length + (priv->zero_terminated ? 1 : 0));
 
-  if (length > priv->capacity) {
-    // grow the array
-    ensure_capacity (priv, length);
+    /* Only the elements becoming visible are cleared. */
+    if (priv->clear_) {
+      memset (element_offset (priv, array->len),
+        0,
+        element_length (priv, length - array->len));
+    }
   }
 
   array->len = length;
+  terminate (priv);
 }
 
 #define GROW_IF_NECESSARY(s,l) { \
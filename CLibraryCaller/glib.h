@@ -160,6 +160,8 @@ GArray* g_array_insert_vals       (GArray *array, guint index_, gconstpointer da
 GArray* g_array_remove_index      (GArray *array, guint index_);
 GArray* g_array_remove_index_fast (GArray *array, guint index_);
 void    g_array_set_size          (GArray *array, gint length);
+void    g_array_reserve           (GArray *array, guint len);
+gpointer g_array_append_uninitialized (GArray *array, guint len);
 
 #define g_array_append_val(a,v)   (g_array_append_vals((a),&(v),1))
 #define g_array_insert_val(a,i,v) (g_array_insert_vals((a),(i),&(v),1))
@@ -0,0 +1,71 @@
+/*=============================================================================
+
+   Name     : flumoreallocations.cpp
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : Replacements of the global operator new and delete counting
+              the heap allocations
+
+=============================================================================*/
+
+// Include Files
+#include "flumoreallocations.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+   std::atomic<uint64_t> gHeapAllocations(0);
+}
+
+//===========================================================================
+// Heap Allocations
+uint64_t heapAllocations()
+{
+   return gHeapAllocations.load(std::memory_order_relaxed);
+}
+
+//===========================================================================
+// The replaceable allocation functions. They are kept in their own file
+// so the compiler doesn't see malloc() and free() paired with new and
+// delete of the standard library. The nothrow forms call these.
+void* operator new(size_t size)
+{
+   gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+   void* p = malloc(size > 0 ? size : 1);
+   if (p == NULL)
+   {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void* operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+   free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+   free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+   free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+   free(p);
+}
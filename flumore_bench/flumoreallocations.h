@@ -0,0 +1,24 @@
+#ifndef FLUMORE_ALLOCATIONS_H
+#define FLUMORE_ALLOCATIONS_H
+/*=============================================================================
+
+   Name     : flumoreallocations.h
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : Counting of the heap allocations of the benchmark
+
+=============================================================================*/
+
+#include <cstdint>
+
+// -----------------------------------------------------------------------
+// heapAllocations()
+// The number of allocations through operator new so far. The benchmark
+// replaces the global operator new to count them; malloc() is not
+// counted.
+uint64_t heapAllocations();
+
+#endif
@@ -0,0 +1,997 @@
+/*=============================================================================
+
+   Name     : flumorebench.cpp
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : flumore_bench, times the stages of the native FLUMORE parser,
+              the feature builder and the writer on generated or given files
+
+=============================================================================*/
+
+// Include Files
+#include "flumoreallocations.h"
+#include "flumoregenerator.h"
+#include "flumorematchercheck.h"
+
+#include <flumorearena.h>
+#include <flumorecache.h>
+#include <flumorecompactrows.h>
+#include <flumorefeaturebuilder.h>
+#include <flumorefilewriter.h>
+#include <flumoreparser.h>
+#include <flumorepriv.h>
+#include <flumorereprojector.h>
+#include <flumorestats.h>
+#include <flumorethreadpool.h>
+#include <headlessfeature.h>
+#include <headlesssession.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+   typedef FLUMOREStats::Clock Clock;
+
+   double secondsSince(Clock::time_point start);
+
+   //------------------------------------------------------------------------
+   // Command line options.
+   struct Options
+   {
+      Options()
+      :
+         readMethod(kFLUMOREReadAuto), queueDepth(int32_t(FLUMOREFileReader::kDefaultQueueDepth)),
+         memoryLimit(0), threads(1), scanThreads(0), poolThreads(0), partitions(0), repeat(5), checkMatchers(0),
+         compact(false), structureAttributes(false),
+         reproject(false),
+         generateOnly(false)
+      {
+      }
+
+      FLUMOREGeneratorOptions generator;
+      // The file to benchmark, generated if it was not given.
+      string input;
+      // Where a generated file is written.
+      string output;
+      // Optional JSON file with the counters of the fastest run.
+      string json;
+      // If set the parsed rows are written to this file with
+      // FLUMOREFileWriter and read back.
+      string written;
+      // If set the decoded rows are written to this binary cache with
+      // FLUMORECache and read back.
+      string cache;
+      // How the file is read and the chunks in flight with io_uring.
+      FLUMOREReadMethod readMethod;
+      int32_t queueDepth;
+      // The time zone the dates are converted from.
+      FLUMORETimeZone timeZone;
+      // Megabytes the writer keeps in memory before it spills, 0 for
+      // no limit.
+      int32_t memoryLimit;
+      // Threads the writer formats the rows with.
+      int32_t threads;
+      // Threads of the scan, 0 for all of the shared pool.
+      int32_t scanThreads;
+      // Workers of the shared pool and the cpus they run on, as the
+      // reader's THREADS and CPU_SET.
+      int32_t poolThreads;
+      string cpuSet;
+      // Partitions the blocks are split into for the partition check, 0
+      // for none.
+      int32_t partitions;
+      int32_t repeat;
+      // Lines of the matcher check, 0 to run the benchmark instead.
+      int32_t checkMatchers;
+      // If set the decoded rows are packed with FLUMORECompactRows and
+      // unpacked again.
+      bool compact;
+      // If set the features get the flumore_* structure attributes.
+      bool structureAttributes;
+      // If set the decoded x and y are reprojected to UTM zone 32N, with
+      // the NTv2 grid datumGrid if it is not empty.
+      bool reproject;
+      string datumGrid;
+      bool generateOnly;
+   };
+
+   //------------------------------------------------------------------------
+   // The seconds of every run of one stage and the heap allocations of
+   // the last run.
+   struct StageTimes
+   {
+      StageTimes() : allocations(0) {}
+
+      vector<double> seconds;
+      uint64_t allocations;
+
+      void record(Clock::time_point start, uint64_t allocationsAtStart)
+      {
+         seconds.push_back(secondsSince(start));
+         allocations = heapAllocations() - allocationsAtStart;
+      }
+
+      double best() const
+      {
+         return seconds.empty() ? 0.0 : *std::min_element(seconds.begin(), seconds.end());
+      }
+
+      double median() const
+      {
+         if (seconds.empty())
+         {
+            return 0.0;
+         }
+         vector<double> sorted(seconds);
+         std::sort(sorted.begin(), sorted.end());
+         return sorted[sorted.size() / 2];
+      }
+   };
+
+   //------------------------------------------------------------------------
+   void usage()
+   {
+      cerr << "usage: flumore_bench [options] [file]\n"
+              "\n"
+              "Times the stages of the native FLUMORE parser on the given file. Without a\n"
+              "file a synthetic one is generated first.\n"
+              "\n"
+              "  -t <n>         timesteps of the generated file (24)\n"
+              "  -s <n>         situations per timestep (3)\n"
+              "  -b <n>         Teilbereich blocks per situation (2)\n"
+              "  -r <n>         rows per Teilbereich block (5000)\n"
+              "  --seed <n>     seed of the generator (1)\n"
+              "  -o <file>      where the generated file is written ("
+           << FLUMOREGenerator::fileName() << ")\n"
+              "  --generate     only write the file\n"
+              "  --repeat <n>   runs per stage, the best and the median are reported (5)\n"
+              "  --json <file>  write the counters of the fastest run as JSON\n"
+              "  --read <method>\n"
+              "                 AUTO, BUFFERED or URING, how the file is read (AUTO)\n"
+              "  --queue-depth <n>\n"
+              "                 chunks in flight when reading with io_uring ("
+           << FLUMOREFileReader::kDefaultQueueDepth << ")\n"
+              "  --time-zone <zone>\n"
+              "                 LOCAL, UTC, CET or an offset such as +01:00, the zone of\n"
+              "                 the dates (LOCAL)\n"
+              "  --write <file> also time writing the rows to file and check that they\n"
+              "                 read back unchanged\n"
+              "  --memory-limit <mb>\n"
+              "                 spill the rows of --write to a temporary file beyond mb\n"
+              "  --threads <n>  threads formatting the rows of --write (1)\n"
+              "  --scan-threads <n>\n"
+              "                 threads of the scan, checked against a sequential scan\n"
+              "                 (all threads of the shared pool)\n"
+              "  --pool-threads <n>\n"
+              "                 workers of the shared thread pool (FLUMORE_THREADS or all\n"
+              "                 cpus)\n"
+              "  --cpu-set <list>\n"
+              "                 pin the workers to these cpus, e.g. 0-3,8\n"
+              "  --cache <file> also time writing the rows to a binary cache and reading\n"
+              "                 them back, checking that they are unchanged\n"
+              "  --reproject    also time reprojecting x and y from GK3 to UTM zone 32N\n"
+              "  --datum-grid <file>\n"
+              "                 shift the datum of --reproject with this NTv2 grid\n"
+              "  --partitions <n>\n"
+              "                 check that the blocks and the timesteps split into n\n"
+              "                 partitions are read exactly once and report the balance\n"
+              "  --structure-attributes\n"
+              "                 build the features with the flumore_* attributes of their\n"
+              "                 block, as SOURCE_STRUCTURE_ATTRIBUTES YES does\n"
+              "  --compact      also time packing the rows of every block into their compact\n"
+              "                 form and unpacking them, checking that they are unchanged\n"
+              "  --check-matchers <n>\n"
+              "                 instead of timing, compare the header matchers with the\n"
+              "                 regular expressions of the F# parser on n edited lines\n";
+   }
+
+   //------------------------------------------------------------------------
+   // Reads the value following argument i as a positive number.
+   bool numberArgument(int argc, char** argv, int& i, int32_t& value)
+   {
+      if (i + 1 >= argc)
+      {
+         return false;
+      }
+      const long parsed = strtol(argv[++i], NULL, 10);
+      if (parsed <= 0)
+      {
+         return false;
+      }
+      value = int32_t(parsed);
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   bool parseArguments(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         const string arg(argv[i]);
+         int32_t seed = 0;
+         bool ok = true;
+         if (arg == "-t")            ok = numberArgument(argc, argv, i, options.generator.timesteps);
+         else if (arg == "-s")       ok = numberArgument(argc, argv, i, options.generator.situations);
+         else if (arg == "-b")       ok = numberArgument(argc, argv, i, options.generator.blocks);
+         else if (arg == "-r")       ok = numberArgument(argc, argv, i, options.generator.rows);
+         else if (arg == "--repeat") ok = numberArgument(argc, argv, i, options.repeat);
+         else if (arg == "--memory-limit") ok = numberArgument(argc, argv, i, options.memoryLimit);
+         else if (arg == "--threads") ok = numberArgument(argc, argv, i, options.threads);
+         else if (arg == "--scan-threads") ok = numberArgument(argc, argv, i, options.scanThreads);
+         else if (arg == "--pool-threads") ok = numberArgument(argc, argv, i, options.poolThreads);
+         else if (arg == "--cpu-set" && i + 1 < argc) options.cpuSet = argv[++i];
+         else if (arg == "--partitions") ok = numberArgument(argc, argv, i, options.partitions);
+         else if (arg == "--queue-depth") ok = numberArgument(argc, argv, i, options.queueDepth);
+         else if (arg == "--read" && i + 1 < argc) ok = FLUMOREFileReader::parseMethod(argv[++i], options.readMethod);
+         else if (arg == "--time-zone" && i + 1 < argc) ok = FLUMOREFormat::parseTimeZone(argv[++i], options.timeZone);
+         else if (arg == "--check-matchers") ok = numberArgument(argc, argv, i, options.checkMatchers);
+         else if (arg == "--seed")
+         {
+            ok = numberArgument(argc, argv, i, seed);
+            options.generator.seed = uint64_t(seed);
+         }
+         else if (arg == "-o" && i + 1 < argc)      options.output = argv[++i];
+         else if (arg == "--json" && i + 1 < argc)  options.json = argv[++i];
+         else if (arg == "--write" && i + 1 < argc) options.written = argv[++i];
+         else if (arg == "--cache" && i + 1 < argc) options.cache = argv[++i];
+         else if (arg == "--compact")               options.compact = true;
+         else if (arg == "--structure-attributes")  options.structureAttributes = true;
+         else if (arg == "--reproject")             options.reproject = true;
+         else if (arg == "--datum-grid" && i + 1 < argc)
+         {
+            options.datumGrid = argv[++i];
+            options.reproject = true;
+         }
+         else if (arg == "--generate")              options.generateOnly = true;
+         else if (!arg.empty() && arg[0] != '-' && options.input.empty()) options.input = arg;
+         else ok = false;
+
+         if (!ok)
+         {
+            return false;
+         }
+      }
+      if (options.output.empty())
+      {
+         options.output = FLUMOREGenerator::fileName();
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   double secondsSince(Clock::time_point start)
+   {
+      return std::chrono::duration<double>(Clock::now() - start).count();
+   }
+
+   //------------------------------------------------------------------------
+   // Starts a block of the builder the way FLUMOREReader::readNative() does.
+   void beginBlock(FLUMOREFeatureBuilder& builder, const FLUMOREParser& parser, const FLUMOREBlock& block)
+   {
+      builder.beginBlock(block.timestamp < 0 ? NULL : &parser.timestamps()[block.timestamp],
+                         block.situation < 0 ? NULL : &parser.situations()[block.situation], block);
+   }
+
+   //------------------------------------------------------------------------
+   // Prints one line of the result table.
+   void report(const char* stage, const StageTimes& times, uint64_t bytes, uint64_t rows)
+   {
+      const double best = times.best();
+      char line[256];
+      snprintf(line, sizeof(line), "%-16s %10.4f %10.4f %10.1f %12.0f %10.1f %12.6f\n",
+               stage, best, times.median(),
+               (best > 0.0 && bytes) ? double(bytes) / best / 1e6 : 0.0,
+               (best > 0.0) ? double(rows) / best : 0.0,
+               rows ? best * 1e9 / double(rows) : 0.0,
+               rows ? double(times.allocations) / double(rows) : 0.0);
+      cout << line;
+   }
+
+   //------------------------------------------------------------------------
+   // Adds the rows of all blocks to the writer, keeping their timestamps,
+   // situations and Teilbereich ids.
+   bool collectRows(const FLUMOREParser& parser, const vector<FLUMOREColumns>& columns,
+                    FLUMOREFileWriter& writer)
+   {
+      const vector<FLUMOREBlock>& blocks = parser.blocks();
+      double values[6];
+      for (size_t b = 0; b < blocks.size(); ++b)
+      {
+         const FLUMOREBlock& block = blocks[b];
+         if (block.timestamp < 0)
+         {
+            continue;
+         }
+         const FLUMORESituation* situation =
+            (block.situation < 0) ? NULL : &parser.situations()[block.situation];
+         if (!writer.selectBlock(parser.timestamps()[block.timestamp], situation, block.id, block.version))
+         {
+            return false;
+         }
+         const FLUMOREColumns& rows = columns[b];
+         for (size_t r = 0; r < rows.size(); ++r)
+         {
+            values[0] = rows.x[r];
+            values[1] = rows.y[r];
+            values[2] = rows.z[r];
+            values[3] = rows.wsp[r];
+            values[4] = rows.h[r];
+            values[5] = rows.vres[r];
+            if (!writer.addRow(rows.id[r], values))
+            {
+               return false;
+            }
+         }
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Reads the written file and counts the rows which differ from the
+   // columns they were written from. Differences in the number of rows
+   // count as well.
+   bool compareWritten(const string& path, const vector<FLUMOREColumns>& columns, uint64_t& differences)
+   {
+      FLUMOREParser parser;
+      if (!parser.load(path) || !parser.scan())
+      {
+         cerr << "flumore_bench: " << parser.error() << "\n";
+         return false;
+      }
+      FLUMOREColumns expected, actual;
+      for (size_t b = 0; b < columns.size(); ++b)
+      {
+         expected.id.insert(expected.id.end(), columns[b].id.begin(), columns[b].id.end());
+         expected.x.insert(expected.x.end(), columns[b].x.begin(), columns[b].x.end());
+         expected.y.insert(expected.y.end(), columns[b].y.begin(), columns[b].y.end());
+         expected.z.insert(expected.z.end(), columns[b].z.begin(), columns[b].z.end());
+         expected.wsp.insert(expected.wsp.end(), columns[b].wsp.begin(), columns[b].wsp.end());
+         expected.h.insert(expected.h.end(), columns[b].h.begin(), columns[b].h.end());
+         expected.vres.insert(expected.vres.end(), columns[b].vres.begin(), columns[b].vres.end());
+      }
+      differences = 0;
+      for (size_t b = 0; b < parser.blocks().size(); ++b)
+      {
+         differences += parser.decode(parser.blocks()[b], actual);
+      }
+      const size_t rows = std::min(expected.size(), actual.size());
+      differences += uint64_t(std::max(expected.size(), actual.size()) - rows);
+      for (size_t r = 0; r < rows; ++r)
+      {
+         if (expected.id[r] != actual.id[r] || expected.x[r] != actual.x[r] ||
+             expected.y[r] != actual.y[r] || expected.z[r] != actual.z[r] ||
+             expected.wsp[r] != actual.wsp[r] || expected.h[r] != actual.h[r] ||
+             expected.vres[r] != actual.vres[r])
+         {
+            ++differences;
+         }
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Scans the file with threads threads and again with one and counts
+   // the headers, blocks and warnings which differ.
+   bool compareScan(const string& path, size_t threads, uint64_t& differences)
+   {
+      FLUMOREParser parser;
+      if (!parser.load(path) || !parser.scan(threads))
+      {
+         cerr << "flumore_bench: " << parser.error() << "\n";
+         return false;
+      }
+      const vector<FLUMORETimestamp> timestamps = parser.timestamps();
+      const vector<FLUMORESituation> situations = parser.situations();
+      const vector<FLUMOREBlock> blocks = parser.blocks();
+      const vector<string> warnings = parser.warnings();
+      const size_t warningCount = parser.warningCount();
+      parser.scan(1);
+
+      differences = 0;
+      const auto count = [&differences](size_t expected, size_t actual)
+      {
+         differences += (expected > actual) ? expected - actual : actual - expected;
+      };
+      count(parser.timestamps().size(), timestamps.size());
+      count(parser.situations().size(), situations.size());
+      count(parser.blocks().size(), blocks.size());
+      count(parser.warnings().size(), warnings.size());
+      count(parser.warningCount(), warningCount);
+      for (size_t i = 0; i < std::min(timestamps.size(), parser.timestamps().size()); ++i)
+      {
+         const FLUMORETimestamp& a = timestamps[i];
+         const FLUMORETimestamp& b = parser.timestamps()[i];
+         if (a.date != b.date || a.fmeDate != b.fmeDate || a.kind != b.kind ||
+             a.subspanCount != b.subspanCount || a.count2D != b.count2D)
+         {
+            ++differences;
+         }
+      }
+      for (size_t i = 0; i < std::min(situations.size(), parser.situations().size()); ++i)
+      {
+         const FLUMORESituation& a = situations[i];
+         const FLUMORESituation& b = parser.situations()[i];
+         if (a.kind != b.kind || a.nlp != b.nlp || a.hasLocation != b.hasLocation ||
+             memcmp(&a.rw, &b.rw, sizeof(double)) != 0 || memcmp(&a.hw, &b.hw, sizeof(double)) != 0 ||
+             a.valueCount != b.valueCount ||
+             memcmp(a.values, b.values, sizeof(double) * size_t(a.valueCount)) != 0)
+         {
+            ++differences;
+         }
+      }
+      for (size_t i = 0; i < std::min(blocks.size(), parser.blocks().size()); ++i)
+      {
+         const FLUMOREBlock& a = blocks[i];
+         const FLUMOREBlock& b = parser.blocks()[i];
+         if (a.timestamp != b.timestamp || a.situation != b.situation || a.count != b.count ||
+             a.id != b.id || a.version != b.version || a.line != b.line ||
+             a.begin != b.begin || a.end != b.end)
+         {
+            ++differences;
+         }
+      }
+      for (size_t i = 0; i < std::min(warnings.size(), parser.warnings().size()); ++i)
+      {
+         if (warnings[i] != parser.warnings()[i])
+         {
+            ++differences;
+         }
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Splits the blocks of the file into count partitions by blocks and by
+   // timesteps the way the reader does and counts the blocks which are in
+   // no or more than one partition, and the timesteps split between
+   // partitions. Prints the rows of the largest and the smallest one.
+   bool checkPartitions(const string& path, size_t count, uint64_t& differences)
+   {
+      FLUMOREParser parser;
+      if (!parser.load(path) || !parser.scan())
+      {
+         cerr << "flumore_bench: " << parser.error() << "\n";
+         return false;
+      }
+      const vector<FLUMOREBlock>& blocks = parser.blocks();
+      const char* const names[] = { "block", "timestep" };
+      const FLUMOREPartitionUnit units[] = { kFLUMOREPartitionBlock, kFLUMOREPartitionTimestep };
+
+      differences = 0;
+      for (int u = 0; u < 2; ++u)
+      {
+         vector<size_t> owners(blocks.size(), count);
+         vector<size_t> selected;
+         uint64_t largest = 0;
+         uint64_t smallest = UINT64_MAX;
+         for (size_t k = 0; k < count; ++k)
+         {
+            FLUMOREParser::partition(blocks, units[u], k, count, selected);
+            uint64_t rows = 0;
+            for (size_t i = 0; i < selected.size(); ++i)
+            {
+               differences += owners[selected[i]] != count ? 1 : 0;
+               owners[selected[i]] = k;
+               rows += uint64_t(std::max(blocks[selected[i]].count, 0));
+            }
+            largest = std::max(largest, rows);
+            smallest = std::min(smallest, rows);
+         }
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            differences += owners[b] == count ? 1 : 0;
+            if (units[u] == kFLUMOREPartitionTimestep && b > 0 &&
+                blocks[b].timestamp == blocks[b - 1].timestamp && owners[b] != owners[b - 1])
+            {
+               ++differences;
+            }
+         }
+         cout << count << " partitions by " << names[u] << ": " << smallest << " to " << largest << " rows\n";
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Counts the rows read back from the cache or the compact form which
+   // differ from the decoded columns.
+   uint64_t compareColumns(const vector<FLUMOREColumns>& cached, const vector<FLUMOREColumns>& columns)
+   {
+      uint64_t differences = 0;
+      for (size_t b = 0; b < std::max(cached.size(), columns.size()); ++b)
+      {
+         if (b >= cached.size() || b >= columns.size())
+         {
+            differences += (b < cached.size() ? cached[b] : columns[b]).size();
+            continue;
+         }
+         const FLUMOREColumns& expected = columns[b];
+         const FLUMOREColumns& actual = cached[b];
+         const size_t rows = std::min(expected.size(), actual.size());
+         differences += uint64_t(std::max(expected.size(), actual.size()) - rows);
+         for (size_t r = 0; r < rows; ++r)
+         {
+            // Bitwise, so a lost sign of zero counts as well.
+            if (expected.id[r] != actual.id[r] ||
+                memcmp(&expected.x[r], &actual.x[r], sizeof(double)) != 0 ||
+                memcmp(&expected.y[r], &actual.y[r], sizeof(double)) != 0 ||
+                memcmp(&expected.z[r], &actual.z[r], sizeof(double)) != 0 ||
+                memcmp(&expected.wsp[r], &actual.wsp[r], sizeof(double)) != 0 ||
+                memcmp(&expected.h[r], &actual.h[r], sizeof(double)) != 0 ||
+                memcmp(&expected.vres[r], &actual.vres[r], sizeof(double)) != 0)
+            {
+               ++differences;
+            }
+         }
+      }
+      return differences;
+   }
+}
+
+//===========================================================================
+// Main
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!parseArguments(argc, argv, options))
+   {
+      usage();
+      return 2;
+   }
+
+   if (options.poolThreads > 0 || !options.cpuSet.empty())
+   {
+      string error;
+      if (!FLUMOREThreadPool::configureShared(size_t(options.poolThreads), options.cpuSet, error))
+      {
+         cerr << "flumore_bench: " << error << "\n";
+         return 1;
+      }
+   }
+
+   if (options.checkMatchers > 0)
+   {
+      return checkMatchers(options.generator.seed, options.checkMatchers) == 0 ? 0 : 1;
+   }
+
+   if (options.input.empty())
+   {
+      FLUMOREGenerator generator(options.generator);
+      const Clock::time_point start = Clock::now();
+      if (!generator.write(options.output))
+      {
+         cerr << "flumore_bench: could not write " << options.output << "\n";
+         return 1;
+      }
+      cout << "generated " << options.output << ": " << generator.bytes() << " bytes, "
+           << generator.rows() << " rows in " << secondsSince(start) << " s\n";
+      if (options.generateOnly)
+      {
+         return 0;
+      }
+      options.input = options.output;
+   }
+
+   StageTimes read, scan, decode, reproject, build, clone, attributes, stream, write, cacheWrite, cacheRead, pack,
+              unpack;
+   FLUMOREStats fastest;
+   double fastestTotal = 0.0;
+   uint64_t bytes = 0, rows = 0, rejected = 0, checksum = 0, bytesWritten = 0, bytesSpilled = 0;
+   uint64_t cacheBytes = 0, bytesHeld = 0, packedBytes = 0, outsideDatumGrid = 0;
+   string readWith;
+
+   HeadlessSession session;
+   HeadlessFeature feature;
+   vector<FLUMOREColumns> columns;
+   vector<FLUMOREColumns> cached;
+   vector<FLUMORECompactRows> packed;
+   vector<FLUMOREColumns> unpacked;
+   FLUMOREColumns blockColumns;
+   FLUMOREArena blockArena;
+   FLUMOREReprojector reprojector;
+   vector<vector<double> > reprojectedX, reprojectedY;
+   if (!options.datumGrid.empty() && !reprojector.loadGrid(options.datumGrid))
+   {
+      cerr << "flumore_bench: " << reprojector.error() << "\n";
+      return 1;
+   }
+
+   for (int32_t run = 0; run < options.repeat; ++run)
+   {
+      FLUMOREParser parser;
+      FLUMOREStats stats;
+      Clock::time_point start = Clock::now();
+      uint64_t allocations = heapAllocations();
+
+      // Read
+      parser.fileReader().setMethod(options.readMethod);
+      parser.fileReader().setQueueDepth(size_t(options.queueDepth));
+      parser.setTimeZone(options.timeZone);
+      {
+         FLUMOREStats::Timer timer(stats, kFLUMOREPhaseRead);
+         if (!parser.load(options.input))
+         {
+            cerr << "flumore_bench: " << parser.error() << "\n";
+            return 1;
+         }
+      }
+      read.record(start, allocations);
+      bytes = parser.size();
+      readWith = FLUMOREFileReader::methodName(parser.fileReader().used());
+      if (run == 0 && !parser.fileReader().fallback().empty())
+      {
+         cerr << "flumore_bench: io_uring is not used: " << parser.fileReader().fallback() << "\n";
+      }
+
+      // Scan
+      start = Clock::now();
+      allocations = heapAllocations();
+      {
+         FLUMOREStats::Timer timer(stats, kFLUMOREPhaseScan);
+         if (!parser.scan(size_t(options.scanThreads)))
+         {
+            cerr << "flumore_bench: " << parser.error() << "\n";
+            return 1;
+         }
+      }
+      scan.record(start, allocations);
+      const vector<FLUMOREBlock>& blocks = parser.blocks();
+
+      // Decode, the rows of every block end up in columns.
+      start = Clock::now();
+      allocations = heapAllocations();
+      {
+         FLUMOREStats::Timer timer(stats, kFLUMOREPhaseDecode);
+         columns.resize(blocks.size());
+         rejected = 0;
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            columns[b].clear();
+            rejected += parser.decode(blocks[b], columns[b]);
+         }
+      }
+      decode.record(start, allocations);
+
+      // Reproject, the way FLUMOREReader::readNative() does with REPROJECT
+      // UTM32: block by block on the shared pool, here on copies of
+      // the coordinates so the later stages see the decoded ones.
+      if (options.reproject)
+      {
+         reprojectedX.resize(blocks.size());
+         reprojectedY.resize(blocks.size());
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            reprojectedX[b] = columns[b].x;
+            reprojectedY[b] = columns[b].y;
+         }
+         start = Clock::now();
+         allocations = heapAllocations();
+         {
+            FLUMOREStats::Timer timer(stats, kFLUMOREPhaseReproject);
+            outsideDatumGrid = 0;
+            for (size_t b = 0; b < blocks.size(); ++b)
+            {
+               if (!reprojectedX[b].empty())
+               {
+                  outsideDatumGrid += reprojector.transform(&reprojectedX[b][0], &reprojectedY[b][0],
+                                                            reprojectedX[b].size(), 0);
+               }
+            }
+         }
+         reproject.record(start, allocations);
+      }
+
+      // Feature build, the way FLUMOREReader::read() fills its features.
+      start = Clock::now();
+      allocations = heapAllocations();
+      rows = 0;
+      checksum = 0;
+      {
+         FLUMOREStats::Timer timer(stats, kFLUMOREPhaseFeatureBuild);
+         FLUMOREFeatureBuilder builder;
+         builder.open(&session);
+         builder.setStructureAttributes(options.structureAttributes);
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            const FLUMOREColumns& block = columns[b];
+            beginBlock(builder, parser, blocks[b]);
+            for (size_t r = 0; r < block.size(); ++r)
+            {
+               builder.build(feature, block.id[r], block.x[r], block.y[r], block.z[r],
+                             block.wsp[r], block.h[r], block.vres[r]);
+               checksum += feature.numAttributes();
+            }
+            rows += block.size();
+         }
+         builder.close();
+      }
+      build.record(start, allocations);
+      stats.addRows(rows);
+      stats.addBytes(bytes);
+      stats.addRowsFiltered(rejected);
+
+      // The two parts of a feature build on their own.
+      HeadlessFeature prototype;
+      prototype.setFeatureType(kFeatureTypeFLUMORE);
+      prototype.setAttribute(kAttrDate, "20170301130000");
+      start = Clock::now();
+      allocations = heapAllocations();
+      for (uint64_t r = 0; r < rows; ++r)
+      {
+         prototype.clone(feature);
+      }
+      clone.record(start, allocations);
+
+      start = Clock::now();
+      allocations = heapAllocations();
+      for (size_t b = 0; b < blocks.size(); ++b)
+      {
+         const FLUMOREColumns& block = columns[b];
+         for (size_t r = 0; r < block.size(); ++r)
+         {
+            feature.setAttribute(kAttrId, block.id[r]);
+            feature.setAttribute(kAttrH, block.h[r]);
+            feature.setAttribute(kAttrVres, block.vres[r]);
+            feature.setAttribute(kAttrWsp, block.wsp[r]);
+            feature.setAttribute(kAttrX, block.x[r]);
+            feature.setAttribute(kAttrY, block.y[r]);
+            feature.setAttribute(kAttrZ, block.z[r]);
+         }
+      }
+      attributes.record(start, allocations);
+
+      // Stream, the way FLUMOREReader::readNative() decodes one block at a
+      // time into the same columns and builds its features. Once the
+      // columns and the arena have grown to the largest block, which the
+      // previous run did, no row allocates.
+      start = Clock::now();
+      allocations = heapAllocations();
+      {
+         FLUMOREFeatureBuilder builder;
+         builder.open(&session);
+         builder.setStructureAttributes(options.structureAttributes);
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            blockArena.reset();
+            blockColumns.clear();
+            parser.decode(blocks[b], blockColumns);
+            beginBlock(builder, parser, blocks[b]);
+            for (size_t r = 0; r < blockColumns.size(); ++r)
+            {
+               builder.build(feature, blockColumns.id[r], blockColumns.x[r], blockColumns.y[r],
+                             blockColumns.z[r], blockColumns.wsp[r], blockColumns.h[r], blockColumns.vres[r]);
+            }
+         }
+         builder.close();
+      }
+      stream.record(start, allocations);
+
+      // Write, the way FLUMOREWriter collects and writes the rows.
+      if (!options.written.empty())
+      {
+         start = Clock::now();
+         allocations = heapAllocations();
+         FLUMOREFileWriter writer;
+         writer.setMemoryLimit(uint64_t(options.memoryLimit) << 20, "");
+         writer.setThreads(size_t(options.threads));
+         if (!collectRows(parser, columns, writer))
+         {
+            cerr << "flumore_bench: " << writer.error() << "\n";
+            return 1;
+         }
+         bytesHeld = writer.bytesInMemory();
+         if (!writer.write(options.written, parser.header()))
+         {
+            cerr << "flumore_bench: " << writer.error() << "\n";
+            return 1;
+         }
+         write.record(start, allocations);
+         bytesWritten = writer.bytesWritten();
+         bytesSpilled = writer.bytesSpilled();
+      }
+
+      // Cache, written the way FLUMOREReader writes it while decoding and
+      // read back as a later run of the reader would.
+      if (!options.cache.empty())
+      {
+         start = Clock::now();
+         allocations = heapAllocations();
+         {
+            FLUMORECache cache;
+            bool ok = cache.create(options.cache, options.input);
+            for (size_t b = 0; ok && b < blocks.size(); ++b)
+            {
+               ok = cache.addBlock(columns[b], 0);
+            }
+            if (!ok || !cache.finish(parser))
+            {
+               cerr << "flumore_bench: " << cache.error() << "\n";
+               return 1;
+            }
+            cacheBytes = cache.size();
+         }
+         cacheWrite.record(start, allocations);
+
+         start = Clock::now();
+         allocations = heapAllocations();
+         FLUMORECache cache;
+         if (!cache.open(options.cache, options.input, options.timeZone))
+         {
+            cerr << "flumore_bench: " << cache.error() << "\n";
+            return 1;
+         }
+         cached.resize(cache.blocks().size());
+         for (size_t b = 0; b < cached.size(); ++b)
+         {
+            size_t blockRejected = 0;
+            blockArena.reset();
+            cached[b].clear();
+            if (!cache.decode(b, cached[b], blockRejected, blockArena))
+            {
+               cerr << "flumore_bench: could not decode block " << b << " of " << options.cache << "\n";
+               return 1;
+            }
+         }
+         cacheRead.record(start, allocations);
+      }
+
+      // Compact rows, the way a mode holding a whole run keeps them.
+      if (options.compact)
+      {
+         start = Clock::now();
+         allocations = heapAllocations();
+         packed.resize(blocks.size());
+         packedBytes = 0;
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            packed[b].pack(columns[b]);
+            packedBytes += packed[b].bytes();
+         }
+         pack.record(start, allocations);
+
+         start = Clock::now();
+         allocations = heapAllocations();
+         unpacked.resize(blocks.size());
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            unpacked[b].clear();
+            packed[b].unpack(unpacked[b]);
+         }
+         unpack.record(start, allocations);
+      }
+
+      if (run == 0 || stats.totalSeconds() < fastestTotal)
+      {
+         fastest = stats;
+         fastestTotal = stats.totalSeconds();
+      }
+
+      if (run == 0 && parser.warningCount() > 0)
+      {
+         cerr << "flumore_bench: " << parser.warningCount() << " warnings, the first: "
+              << parser.warnings()[0] << "\n";
+      }
+   }
+
+   cout << options.input << ": " << bytes << " bytes, " << rows << " rows, "
+        << rejected << " rejected, " << options.repeat << " runs, checksum " << checksum << "\n";
+   cout << "stage            best [s] median [s]       MB/s       rows/s     ns/row   allocs/row\n";
+   report("read", read, bytes, rows);
+   cout << "  read " << readWith << "\n";
+   report("scan", scan, bytes, rows);
+   report("decode", decode, bytes, rows);
+   if (options.reproject)
+   {
+      report("reproject", reproject, 0, rows);
+      if (reprojector.hasGrid())
+      {
+         cout << "  outside the datum grid: " << outsideDatumGrid << " points\n";
+      }
+   }
+   report("feature_build", build, 0, rows);
+   report("  clone", clone, 0, rows);
+   report("  attributes", attributes, 0, rows);
+   report("stream", stream, bytes, rows);
+   if (!options.written.empty())
+   {
+      report("write", write, bytesWritten, rows);
+      cout << "  held " << bytesHeld << " bytes, " << (rows ? double(bytesHeld) / double(rows) : 0.0)
+           << " bytes/row\n";
+      if (bytesSpilled > 0)
+      {
+         cout << "  spilled " << bytesSpilled << " bytes\n";
+      }
+   }
+   if (!options.cache.empty())
+   {
+      report("cache_write", cacheWrite, cacheBytes, rows);
+      report("cache_read", cacheRead, cacheBytes, rows);
+      cout << "  cache " << cacheBytes << " bytes, " << double(cacheBytes) / double(bytes)
+           << " of the text\n";
+   }
+   if (options.compact)
+   {
+      report("pack", pack, 0, rows);
+      report("unpack", unpack, 0, rows);
+      cout << "  packed " << packedBytes << " bytes, " << (rows ? double(packedBytes) / double(rows) : 0.0)
+           << " bytes/row\n";
+   }
+   cout << "peak memory " << FLUMOREStats::peakResidentBytes() << " bytes\n";
+
+   if (!options.written.empty())
+   {
+      uint64_t differences = 0;
+      if (!compareWritten(options.written, columns, differences))
+      {
+         return 1;
+      }
+      cout << "read back " << options.written << ": " << differences << " rows differ\n";
+      if (differences > 0)
+      {
+         return 1;
+      }
+   }
+
+   if (options.scanThreads != 1)
+   {
+      uint64_t differences = 0;
+      if (!compareScan(options.input, size_t(options.scanThreads), differences))
+      {
+         return 1;
+      }
+      cout << "sequential scan: " << differences << " differences\n";
+      if (differences > 0)
+      {
+         return 1;
+      }
+   }
+
+   if (options.partitions > 0)
+   {
+      uint64_t differences = 0;
+      if (!checkPartitions(options.input, size_t(options.partitions), differences))
+      {
+         return 1;
+      }
+      cout << "partitions: " << differences << " differences\n";
+      if (differences > 0)
+      {
+         return 1;
+      }
+   }
+
+   if (!options.cache.empty())
+   {
+      const uint64_t differences = compareColumns(cached, columns);
+      cout << "read back " << options.cache << ": " << differences << " rows differ\n";
+      if (differences > 0)
+      {
+         return 1;
+      }
+   }
+
+   if (options.compact)
+   {
+      const uint64_t differences = compareColumns(unpacked, columns);
+      cout << "unpacked rows: " << differences << " differ\n";
+      if (differences > 0)
+      {
+         return 1;
+      }
+   }
+
+   if (!options.json.empty() && !fastest.writeJson(options.json, options.input))
+   {
+      cerr << "flumore_bench: could not write " << options.json << "\n";
+      return 1;
+   }
+   return 0;
+}
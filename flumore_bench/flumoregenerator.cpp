@@ -0,0 +1,267 @@
+/*=============================================================================
+
+   Name     : flumoregenerator.cpp
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : FLUMOREGenerator method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumoregenerator.h"
+
+#include <cstdio>
+
+namespace
+{
+   // Data is flushed to the file in pieces of this size.
+   const size_t kFlushSize = 1 << 20;
+
+   // The situation kinds in the order they are cycled through.
+   const char* const kSituationKinds[] =
+   {
+      "Ueberstr.", "Bresche", "Deichentl.", "Folgebruch", "Innere Entl.", "Linien-SM", "Punkt-SM"
+   };
+   const int32_t kSituationKindCount = sizeof(kSituationKinds) / sizeof(kSituationKinds[0]);
+
+   // The column definition line following every Teilbereich line.
+   const char* const kColumnLine = "     ID,          RW,          HW,       Z,     WSP,      H,   VRES\n";
+
+   // Origin of the generated grid in DHDN / Gauss-Krueger zone 3, in mm.
+   const int64_t kOriginX = 3512000000LL;
+   const int64_t kOriginY = 5401000000LL;
+
+   // Distance between two grid points, in mm.
+   const int64_t kCellSize = 5000;
+
+   //------------------------------------------------------------------------
+   // Appends value / 10^scale right aligned in width characters.
+   void appendFixed(string& out, int64_t value, int scale, int width)
+   {
+      char digits[32];
+      int length = 0;
+      const bool negative = value < 0;
+      uint64_t magnitude = negative ? uint64_t(-value) : uint64_t(value);
+      for (int i = 0; i < scale; ++i)
+      {
+         digits[length++] = char('0' + magnitude % 10);
+         magnitude /= 10;
+      }
+      if (scale > 0)
+      {
+         digits[length++] = '.';
+      }
+      do
+      {
+         digits[length++] = char('0' + magnitude % 10);
+         magnitude /= 10;
+      }
+      while (magnitude != 0);
+      if (negative)
+      {
+         digits[length++] = '-';
+      }
+      for (int i = length; i < width; ++i)
+      {
+         out += ' ';
+      }
+      while (length > 0)
+      {
+         out += digits[--length];
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // Appends dd.MM.yyyy-HH:mm for the given hours after 01.03.2017 12:00.
+   void appendDate(string& out, int32_t hoursAfterStart)
+   {
+      static const int32_t kDaysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+      int32_t year = 2017, month = 3, day = 1;
+      int32_t hour = 12 + hoursAfterStart;
+      day += hour / 24;
+      hour %= 24;
+      for (;;)
+      {
+         const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+         const int32_t days = kDaysInMonth[month - 1] + ((month == 2 && leap) ? 1 : 0);
+         if (day <= days)
+         {
+            break;
+         }
+         day -= days;
+         if (++month > 12)
+         {
+            month = 1;
+            ++year;
+         }
+      }
+      char buffer[64];
+      snprintf(buffer, sizeof(buffer), "%02d.%02d.%04d-%02d:00", day, month, year, hour);
+      out += buffer;
+   }
+
+   //------------------------------------------------------------------------
+   // Writes the buffer if it is large enough or if force is set.
+   bool flush(FILE* file, string& buffer, uint64_t& bytes, bool force)
+   {
+      if (buffer.size() < kFlushSize && !force)
+      {
+         return true;
+      }
+      const bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+      bytes += buffer.size();
+      buffer.clear();
+      return ok;
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMOREGenerator::FLUMOREGenerator(const FLUMOREGeneratorOptions& options)
+:
+   options_(options),
+   state_(options.seed ? options.seed : 1),
+   bytes_(0),
+   rowsWritten_(0)
+{
+}
+
+//===========================================================================
+// Random
+uint64_t FLUMOREGenerator::random()
+{
+   state_ ^= state_ >> 12;
+   state_ ^= state_ << 25;
+   state_ ^= state_ >> 27;
+   return state_ * 0x2545F4914F6CDD1DULL;
+}
+
+//===========================================================================
+// File Name
+string FLUMOREGenerator::fileName()
+{
+   return "V-2017-03-01-12.N001-P001.txt";
+}
+
+//===========================================================================
+// Write
+bool FLUMOREGenerator::write(const string& path)
+{
+   FILE* file = fopen(path.c_str(), "wb");
+   if (file == NULL)
+   {
+      return false;
+   }
+
+   state_ = options_.seed ? options_.seed : 1;
+   bytes_ = 0;
+   rowsWritten_ = 0;
+
+   string out;
+   out.reserve(kFlushSize + 4096);
+   bool ok = true;
+
+   out += "FLUMORE ";
+   appendDate(out, 0);
+   out += ' ';
+   appendFixed(out, options_.timesteps % 1000, 0, 3);
+   out += " N001-P001\n";
+
+   int32_t teilbereich = 0;
+   for (int32_t t = 0; t < options_.timesteps && ok; ++t)
+   {
+      // The first half is simulated, the rest is a forecast.
+      out += ' ';
+      appendDate(out, t + 1);
+      out += (t < options_.timesteps / 2) ? " SIM " : " VHS ";
+      appendFixed(out, options_.situations, 0, 3);
+      out += ' ';
+      appendFixed(out, options_.situations * options_.blocks, 0, 3);
+      out += '\n';
+
+      for (int32_t s = 0; s < options_.situations && ok; ++s)
+      {
+         const int32_t kind = (t * options_.situations + s) % kSituationKindCount;
+         const bool located = (kind != 0 && kind != 5);
+
+         // Line 1: kind and nlp, line 2: location if nlp is 1, line 3: values.
+         out += "  ";
+         out += kSituationKinds[kind];
+         appendFixed(out, located ? 1 : 2 + uniform(8), 0, 6);
+         out += '\n';
+         if (located)
+         {
+            appendFixed(out, (kOriginX + uniform(20000000)) / 100, 1, 12);
+            appendFixed(out, (kOriginY + uniform(20000000)) / 100, 1, 12);
+         }
+         out += '\n';
+         if (kind == 0)
+         {
+            appendFixed(out, uniform(200), 2, 8);
+            appendFixed(out, uniform(500000), 3, 10);
+         }
+         else if (kind >= 5)
+         {
+            appendFixed(out, 9000 + uniform(3000), 2, 8);
+         }
+         else
+         {
+            appendFixed(out, 500 + uniform(20000), 2, 8);
+            appendFixed(out, 9000 + uniform(3000), 2, 8);
+            appendFixed(out, uniform(500000), 3, 10);
+         }
+         out += '\n';
+
+         for (int32_t b = 0; b < options_.blocks && ok; ++b)
+         {
+            out += "Teilbereich ";
+            appendFixed(out, options_.rows, 0, 8);
+            out += " TB";
+            teilbereich = teilbereich % 999 + 1;
+            char id[16];
+            snprintf(id, sizeof(id), "%03d-V%02d\n", teilbereich, 1 + b % 99);
+            out += id;
+            out += kColumnLine;
+
+            // A square patch of the grid per block with the points jittered
+            // inside their cells, about a third of the cells is dry.
+            int32_t columns = 1;
+            while (columns * columns < options_.rows)
+            {
+               ++columns;
+            }
+            const int64_t blockX = kOriginX + uniform(100) * kCellSize * columns;
+            const int64_t blockY = kOriginY + uniform(100) * kCellSize * columns;
+            for (int32_t r = 0; r < options_.rows; ++r)
+            {
+               const int64_t z = 9000 + uniform(3000);
+               const int64_t depth = (uniform(3) == 0) ? 0 : uniform(250);
+               const int64_t velocity = depth ? uniform(2500) : 0;
+
+               appendFixed(out, r + 1, 0, 7);
+               out += ',';
+               appendFixed(out, blockX + (r % columns) * kCellSize + uniform(kCellSize), 3, 12);
+               out += ',';
+               appendFixed(out, blockY + (r / columns) * kCellSize + uniform(kCellSize), 3, 12);
+               out += ',';
+               appendFixed(out, z, 2, 8);
+               out += ',';
+               appendFixed(out, z + depth, 2, 8);
+               out += ',';
+               appendFixed(out, depth * 10, 3, 7);
+               out += ',';
+               appendFixed(out, velocity, 3, 7);
+               out += '\n';
+               ok = flush(file, out, bytes_, false);
+            }
+            rowsWritten_ += uint64_t(options_.rows);
+         }
+      }
+   }
+
+   ok = ok && flush(file, out, bytes_, true);
+   return (fclose(file) == 0) && ok;
+}
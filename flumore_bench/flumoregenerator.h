@@ -0,0 +1,99 @@
+#ifndef FLUMORE_GENERATOR_H
+#define FLUMORE_GENERATOR_H
+/*=============================================================================
+
+   Name     : flumoregenerator.h
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREGenerator
+
+=============================================================================*/
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+//=====================================================================
+// The size of a generated file.
+struct FLUMOREGeneratorOptions
+{
+   FLUMOREGeneratorOptions()
+   : timesteps(24), situations(3), blocks(2), rows(5000), seed(1)
+   {}
+
+   // Number of timestamp headers.
+   int32_t timesteps;
+   // Situation headers per timestamp, cycling through all kinds.
+   int32_t situations;
+   // Teilbereich blocks per situation.
+   int32_t blocks;
+   // Rows per Teilbereich block.
+   int32_t rows;
+   // The same seed always produces the same file.
+   uint64_t seed;
+};
+
+//=====================================================================
+// FLUMOREGenerator
+//
+// Writes synthetic FLUMORE files for benchmarks: the package header,
+// timestamps of the kinds SIM and VHS, all seven situation kinds and
+// Teilbereich blocks whose rows look like real Gauss-Krueger
+// coordinates, heights, water levels and velocities.
+class FLUMOREGenerator
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   explicit FLUMOREGenerator(const FLUMOREGeneratorOptions& options);
+
+   // -----------------------------------------------------------------------
+   // write()
+   // Writes the file, returns false if it could not be written.
+   bool write(const string& path);
+
+   // -----------------------------------------------------------------------
+   // fileName()
+   // A file name the F# parser accepts, V-yyyy-mm-dd-hh.N001-P001.
+   static string fileName();
+
+   // -----------------------------------------------------------------------
+   // Accessors, valid after write()
+   uint64_t bytes() const { return bytes_; }
+   uint64_t rows() const { return rowsWritten_; }
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREGenerator(const FLUMOREGenerator&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREGenerator &operator=(const FLUMOREGenerator&);
+
+   // -----------------------------------------------------------------------
+   // random()
+   // xorshift64*, identical on all platforms unlike <random> distributions.
+   uint64_t random();
+
+   // -----------------------------------------------------------------------
+   // uniform()
+   // A value in [0, range).
+   int64_t uniform(int64_t range) { return int64_t(random() % uint64_t(range)); }
+
+   // Data members
+
+   FLUMOREGeneratorOptions options_;
+   uint64_t state_;
+   uint64_t bytes_;
+   uint64_t rowsWritten_;
+};
+
+#endif
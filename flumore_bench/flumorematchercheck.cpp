@@ -0,0 +1,536 @@
+/*=============================================================================
+
+   Name     : flumorematchercheck.cpp
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : checkMatchers, compares the native header matchers with the
+              regular expressions of Patterns.fs
+
+=============================================================================*/
+
+// Include Files
+#include "flumorematchercheck.h"
+
+#include <flumoreformat.h>
+#include <flumoreparser.h>
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+   // Differences reported in detail, further ones are only counted.
+   const uint64_t kMaxReported = 20;
+
+   //------------------------------------------------------------------------
+   // The patterns of Patterns.fs in ECMAScript syntax. The conditional
+   // groups of the situation pattern are spelled out as alternatives:
+   // a kind is followed by its own number of values, and the location
+   // follows exactly if nlp is "1", as \d{1,5} followed by \s can only
+   // end behind the last digit.
+   const char* const kHeaderPattern =
+      "FLUMORE\\s+(\\d{2}\\.\\d{2}\\.\\d{4}-\\d{2}:\\d{2})\\s+(\\d{1,3})\\s+N(\\d{3})-P(\\d{3})";
+
+   const char* const kTimestampPattern =
+      "\\s?([0-9]{2}.[0-9]{2}.[0-9]{4}-[0-9]{2}:[0-9]{2})\\s+([SIM|VHS|SZO]{3})\\s+(\\d{1,5})\\s+(\\d{1,5})";
+
+   const char* const kTeilbereichPattern =
+      "\\bTeilbereich\\s+(\\d{1,10})\\s+TB(\\d{3})-V(\\d{2})";
+
+   string situationPattern()
+   {
+      const string value = "(\\d{1,10}\\.\\d*)";
+      const string location = "\\s+(?:(1)\\s+(\\d{1,10}\\.\\d)\\s+(\\d{1,10}\\.\\d)|(?!1\\s)(\\d{1,5}))";
+      return "\\s+(?:(Ueberstr\\.)" + location + "\\s+" + value + "\\s+" + value +
+             "|(Bresche|Deichentl\\.|Folgebruch|Innere Entl\\.)" + location +
+             "\\s+" + value + "\\s+" + value + "\\s+" + value +
+             "|(Linien-SM|Punkt-SM)" + location + "\\s+" + value + ")";
+   }
+
+   // The first group of each alternative of situationPattern() and the
+   // number of values it has.
+   const struct
+   {
+      size_t group;
+      int32_t values;
+   }
+   kSituationAlternatives[] = { { 1, 2 }, { 8, 3 }, { 16, 1 } };
+
+   //------------------------------------------------------------------------
+   // The well formed lines the corpus starts from.
+   const char* const kHeaders[] =
+   {
+      "FLUMORE 01.03.2017-12:00   4 N001-P001",
+      "FLUMORE\t29.02.2016-23:59 120 N999-P000"
+   };
+
+   const char* const kTimestamps[] =
+   {
+      " 01.03.2017-13:00 SIM   3   6",
+      "01.03.2017-13:00 VHS 12345 1",
+      " 31.12.2017-00:00 SZO 1 99999"
+   };
+
+   const char* const kTeilbereiche[] =
+   {
+      "Teilbereich     3000 TB001-V01",
+      "  Teilbereich 7 TB123-V99"
+   };
+
+   const char* const kSituations[][3] =
+   {
+      { "  Ueberstr.     7", "", "    1.17   370.103" },
+      { "  Ueberstr.     1", "  3515579.6  5408700.9", "    1.17   370.103" },
+      { "  Bresche     1", "  3515579.6  5408700.9", "  12.5  3.25  100.0" },
+      { "  Deichentl.  1", "  1.1  2.2", "  1.0 2.0 3.0" },
+      { "  Folgebruch  3", "", "  4.0 5.0 6.0" },
+      { "  Innere Entl.  2", "", " 1. 2. 3." },
+      { "  Linien-SM 1", " 1.5 2.5", " 0.75" },
+      { "  Punkt-SM  12", "", "  8.5" }
+   };
+
+   // Characters the edits insert, everything the patterns care about.
+   const char kAlphabet[] = " \t0123456789.-:,|SIMVHZOTBNPFLUREeilbrchstDnItkx";
+
+   //------------------------------------------------------------------------
+   // xorshift, so the corpus only depends on the seed.
+   class Random
+   {
+   public:
+      explicit Random(uint64_t seed) : state_(seed ? seed : 1) {}
+
+      uint64_t next()
+      {
+         state_ ^= state_ >> 12;
+         state_ ^= state_ << 25;
+         state_ ^= state_ >> 27;
+         return state_ * 0x2545F4914F6CDD1DULL;
+      }
+
+      size_t below(size_t n)
+      {
+         return n ? size_t(next() % n) : 0;
+      }
+
+   private:
+      uint64_t state_;
+   };
+
+   //------------------------------------------------------------------------
+   // Applies one to three random deletions, insertions or replacements.
+   string edit(const string& line, Random& random)
+   {
+      string result(line);
+      const size_t edits = 1 + random.below(3);
+      for (size_t i = 0; i < edits; ++i)
+      {
+         const char c = kAlphabet[random.below(sizeof(kAlphabet) - 1)];
+         const size_t at = random.below(result.size() + 1);
+         switch (random.below(3))
+         {
+         case 0:
+            if (at < result.size())
+            {
+               result.erase(at, 1);
+            }
+            break;
+         case 1:
+            result.insert(at, 1, c);
+            break;
+         default:
+            if (at < result.size())
+            {
+               result[at] = c;
+            }
+         }
+      }
+      return result;
+   }
+
+   //------------------------------------------------------------------------
+   // The values a matcher extracted, or why a line was rejected, as text.
+   string headerText(bool matched, const FLUMOREPackageHeader& header)
+   {
+      ostringstream text;
+      if (matched)
+      {
+         text << header.created << " " << header.timesteps << " " << header.variant << " " << header.counter;
+      }
+      else
+      {
+         text << "no match";
+      }
+      return text.str();
+   }
+
+   string timestampText(bool matched, const FLUMORETimestamp& timestamp)
+   {
+      ostringstream text;
+      if (matched)
+      {
+         text << timestamp.date << " " << timestamp.kind << " "
+              << timestamp.subspanCount << " " << timestamp.count2D;
+      }
+      else
+      {
+         text << "no match";
+      }
+      return text.str();
+   }
+
+   string teilbereichText(bool matched, const FLUMOREBlock& block)
+   {
+      ostringstream text;
+      if (matched)
+      {
+         text << block.count << " " << block.id << " " << block.version;
+      }
+      else
+      {
+         text << "no match";
+      }
+      return text.str();
+   }
+
+   string situationText(bool matched, const FLUMORESituation& situation)
+   {
+      ostringstream text;
+      if (matched)
+      {
+         text.precision(17);
+         text << situation.kind << " " << situation.nlp;
+         if (situation.hasLocation)
+         {
+            text << " at " << situation.rw << " " << situation.hw;
+         }
+         for (int32_t i = 0; i < situation.valueCount; ++i)
+         {
+            text << " " << situation.values[i];
+         }
+      }
+      else
+      {
+         text << "no match";
+      }
+      return text.str();
+   }
+
+   //------------------------------------------------------------------------
+   int32_t toInt(const string& digits)
+   {
+      return int32_t(strtol(digits.c_str(), NULL, 10));
+   }
+
+   double toDouble(const string& digits)
+   {
+      return strtod(digits.c_str(), NULL);
+   }
+
+   //------------------------------------------------------------------------
+   // Splits dd?MM?yyyy-HH:mm, returns false if it is no valid date.
+   bool splitDate(const string& date, int32_t& day, int32_t& month, int32_t& year,
+                  int32_t& hour, int32_t& minute)
+   {
+      day = toInt(date.substr(0, 2));
+      month = toInt(date.substr(3, 2));
+      year = toInt(date.substr(6, 4));
+      hour = toInt(date.substr(11, 2));
+      minute = toInt(date.substr(14, 2));
+      return FLUMOREFormat::validDate(day, month, year, hour, minute);
+   }
+
+   //------------------------------------------------------------------------
+   // The regular expressions together with the conversions the F# parser
+   // applies to the groups. Like the native matchers, a match whose date
+   // is no valid date doesn't count and the search goes on behind its
+   // start.
+   class Reference
+   {
+   public:
+      Reference()
+      :
+         header_(kHeaderPattern),
+         timestamp_(kTimestampPattern),
+         teilbereich_(kTeilbereichPattern),
+         situation_(situationPattern())
+      {
+      }
+
+      bool matchHeader(const string& line, FLUMOREPackageHeader& header) const
+      {
+         smatch m;
+         for (size_t start = 0; start < line.size(); ++start)
+         {
+            if (!searchAt(line, start, header_, m))
+            {
+               continue;
+            }
+            int32_t day, month, year, hour, minute;
+            if (!splitDate(m.str(1), day, month, year, hour, minute))
+            {
+               continue;
+            }
+            header.created = m.str(1);
+            header.timesteps = toInt(m.str(2));
+            header.variant = toInt(m.str(3));
+            header.counter = toInt(m.str(4));
+            return true;
+         }
+         return false;
+      }
+
+      bool matchTimestamp(const string& line, FLUMORETimestamp& timestamp) const
+      {
+         smatch m;
+         for (size_t start = 0; start < line.size(); ++start)
+         {
+            if (!searchAt(line, start, timestamp_, m))
+            {
+               continue;
+            }
+            int32_t day, month, year, hour, minute;
+            if (!splitDate(m.str(1), day, month, year, hour, minute))
+            {
+               continue;
+            }
+            const string kind = m.str(2);
+            if (kind == "SIM")
+            {
+               timestamp.kind = kFLUMORETimestampSimulation;
+            }
+            else if (kind == "VHS")
+            {
+               timestamp.kind = kFLUMORETimestampPrediction;
+            }
+            else if (kind == "SZO")
+            {
+               timestamp.kind = kFLUMORETimestampScenario;
+            }
+            else
+            {
+               return false;
+            }
+            timestamp.date = m.str(1);
+            timestamp.subspanCount = toInt(m.str(3));
+            timestamp.count2D = toInt(m.str(4));
+            return true;
+         }
+         return false;
+      }
+
+      bool matchTeilbereich(const string& line, FLUMOREBlock& block) const
+      {
+         smatch m;
+         if (!regex_search(line, m, teilbereich_))
+         {
+            return false;
+         }
+         const long long count = strtoll(m.str(1).c_str(), NULL, 10);
+         if (count > INT_MAX)
+         {
+            return false;
+         }
+         block.count = int32_t(count);
+         block.id = toInt(m.str(2));
+         block.version = toInt(m.str(3));
+         return true;
+      }
+
+      bool matchSituation(const string& lines, FLUMORESituation& situation) const
+      {
+         smatch m;
+         if (!regex_search(lines, m, situation_))
+         {
+            return false;
+         }
+         for (size_t a = 0; a < sizeof(kSituationAlternatives) / sizeof(kSituationAlternatives[0]); ++a)
+         {
+            const size_t g = kSituationAlternatives[a].group;
+            if (!m[g].matched)
+            {
+               continue;
+            }
+            const string kind = m.str(g);
+            static const char* const kNames[] =
+            {
+               "Ueberstr.", "Bresche", "Deichentl.", "Folgebruch", "Innere Entl.", "Linien-SM", "Punkt-SM"
+            };
+            for (int32_t k = 0; k < 7; ++k)
+            {
+               if (kind == kNames[k])
+               {
+                  situation.kind = FLUMORESituationKind(k);
+               }
+            }
+            situation.hasLocation = m[g + 1].matched;
+            situation.nlp = situation.hasLocation ? 1 : toInt(m.str(g + 4));
+            situation.rw = situation.hasLocation ? toDouble(m.str(g + 2)) : 0.0;
+            situation.hw = situation.hasLocation ? toDouble(m.str(g + 3)) : 0.0;
+            situation.valueCount = kSituationAlternatives[a].values;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+               situation.values[i] = (i < situation.valueCount) ? toDouble(m.str(g + 5 + size_t(i))) : 0.0;
+            }
+            return true;
+         }
+         return false;
+      }
+
+   private:
+      // The match of re starting exactly at start.
+      static bool searchAt(const string& line, size_t start, const regex& re, smatch& m)
+      {
+         regex_constants::match_flag_type flags = regex_constants::match_continuous;
+         if (start > 0)
+         {
+            flags |= regex_constants::match_prev_avail;
+         }
+         return regex_search(line.begin() + ptrdiff_t(start), line.end(), m, re, flags);
+      }
+
+      regex header_;
+      regex timestamp_;
+      regex teilbereich_;
+      regex situation_;
+   };
+
+   //------------------------------------------------------------------------
+   // Counts a difference and reports the first ones.
+   void report(uint64_t& differences, const char* matcher, const string& input,
+               const string& expected, const string& actual)
+   {
+      if (expected == actual)
+      {
+         return;
+      }
+      if (++differences <= kMaxReported)
+      {
+         cerr << "flumore_bench: " << matcher << " differs on \"" << input << "\"\n"
+              << "  regex:  " << expected << "\n"
+              << "  native: " << actual << "\n";
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // Compares the single line matchers on line.
+   void checkLine(const Reference& reference, const string& line, uint64_t& differences)
+   {
+      const char* const begin = line.data();
+      const char* const end = begin + line.size();
+
+      FLUMOREPackageHeader expectedHeader, header;
+      const bool headerExpected = reference.matchHeader(line, expectedHeader);
+      const bool headerMatched = FLUMOREParser::matchPackageHeader(begin, end, header);
+      report(differences, "package header", line, headerText(headerExpected, expectedHeader),
+             headerText(headerMatched, header));
+
+      FLUMORETimestamp expectedTimestamp, timestamp;
+      const bool timestampExpected = reference.matchTimestamp(line, expectedTimestamp);
+      const bool timestampMatched = FLUMOREParser::matchTimestamp(begin, end, timestamp);
+      report(differences, "timestamp", line, timestampText(timestampExpected, expectedTimestamp),
+             timestampText(timestampMatched, timestamp));
+
+      FLUMOREBlock expectedBlock, block;
+      const bool blockExpected = reference.matchTeilbereich(line, expectedBlock);
+      const bool blockMatched = FLUMOREParser::matchTeilbereich(begin, end, block);
+      report(differences, "Teilbereich", line, teilbereichText(blockExpected, expectedBlock),
+             teilbereichText(blockMatched, block));
+   }
+
+   //------------------------------------------------------------------------
+   // Compares the situation matcher on the three lines, and checks that
+   // FLUMOREParser::scan() finds the same situation in a file starting
+   // with them.
+   void checkSituation(const Reference& reference, const string lines[3], uint64_t& differences)
+   {
+      const string joined = lines[0] + lines[1] + lines[2];
+      const string shown = lines[0] + "\\n" + lines[1] + "\\n" + lines[2];
+
+      FLUMORESituation expected, situation;
+      const bool situationExpected = reference.matchSituation(joined, expected);
+      const bool situationMatched = FLUMOREParser::matchSituation(joined, situation);
+      report(differences, "situation", shown, situationText(situationExpected, expected),
+             situationText(situationMatched, situation));
+
+      // scan() tries the timestamp pattern on the first line before.
+      FLUMORETimestamp timestamp;
+      if (!situationExpected ||
+          FLUMOREParser::matchTimestamp(lines[0].data(), lines[0].data() + lines[0].size(), timestamp))
+      {
+         return;
+      }
+      const string file = string(kHeaders[0]) + "\n" + lines[0] + "\n" + lines[1] + "\n" + lines[2] + "\n";
+      vector<char> text(file.begin(), file.end());
+      FLUMOREParser parser;
+      parser.assign(text);
+      const bool scanned = parser.scan() && !parser.situations().empty();
+      report(differences, "scan of situation", shown, situationText(true, expected),
+             situationText(scanned, scanned ? parser.situations()[0] : situation));
+   }
+}
+
+//===========================================================================
+// Check Matchers
+uint64_t checkMatchers(uint64_t seed, int32_t count)
+{
+   const Reference reference;
+   Random random(seed);
+   uint64_t differences = 0;
+   uint64_t lines = 0, situations = 0;
+
+   vector<string> corpus;
+   corpus.insert(corpus.end(), kHeaders, kHeaders + sizeof(kHeaders) / sizeof(kHeaders[0]));
+   corpus.insert(corpus.end(), kTimestamps, kTimestamps + sizeof(kTimestamps) / sizeof(kTimestamps[0]));
+   corpus.insert(corpus.end(), kTeilbereiche, kTeilbereiche + sizeof(kTeilbereiche) / sizeof(kTeilbereiche[0]));
+   const size_t wellFormed = corpus.size();
+   for (size_t s = 0; s < sizeof(kSituations) / sizeof(kSituations[0]); ++s)
+   {
+      corpus.insert(corpus.end(), kSituations[s], kSituations[s] + 3);
+   }
+
+   for (size_t i = 0; i < corpus.size(); ++i)
+   {
+      checkLine(reference, corpus[i], differences);
+      ++lines;
+   }
+   for (size_t s = 0; s < sizeof(kSituations) / sizeof(kSituations[0]); ++s)
+   {
+      const string triple[3] = { kSituations[s][0], kSituations[s][1], kSituations[s][2] };
+      checkSituation(reference, triple, differences);
+      ++situations;
+   }
+
+   for (int32_t i = 0; i < count; ++i)
+   {
+      if (random.below(2) == 0)
+      {
+         checkLine(reference, edit(corpus[random.below(wellFormed)], random), differences);
+         ++lines;
+      }
+      else
+      {
+         const size_t s = random.below(sizeof(kSituations) / sizeof(kSituations[0]));
+         string triple[3] = { kSituations[s][0], kSituations[s][1], kSituations[s][2] };
+         const size_t line = random.below(3);
+         triple[line] = edit(triple[line], random);
+         checkSituation(reference, triple, differences);
+         checkLine(reference, triple[line], differences);
+         ++lines;
+         ++situations;
+      }
+   }
+
+   cout << "matchers: " << lines << " lines and " << situations << " situation headers checked, "
+        << differences << " differences\n";
+   return differences;
+}
@@ -0,0 +1,27 @@
+#ifndef FLUMORE_MATCHER_CHECK_H
+#define FLUMORE_MATCHER_CHECK_H
+/*=============================================================================
+
+   Name     : flumorematchercheck.h
+
+   System   : FLUMORE benchmark
+
+   Language : C++
+
+   Purpose  : Declaration of checkMatchers, the equivalence check of the
+              native header matchers against the patterns of Patterns.fs
+
+=============================================================================*/
+
+#include <cstdint>
+
+//=====================================================================
+// checkMatchers()
+// Runs the line matchers of FLUMOREParser and std::regex translations
+// of the patterns in Patterns.fs over the same corpus: well formed
+// header, timestamp, situation and Teilbereich lines and count variants
+// of them with random edits. Matching lines must yield the same values.
+// Reports the first differences on stderr and returns their number.
+uint64_t checkMatchers(uint64_t seed, int32_t count);
+
+#endif
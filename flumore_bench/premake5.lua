@@ -0,0 +1,56 @@
+-- Compressed FLUMORE input needs the libraries, e.g.
+-- premake5 --with-zlib --with-zstd gmake2
+newoption { trigger = "with-zlib", description = "Read gzip compressed FLUMORE files, links zlib" }
+newoption { trigger = "with-zstd", description = "Read zstd compressed FLUMORE files, links libzstd" }
+newoption { trigger = "with-uring", description = "Read large FLUMORE files through io_uring on Linux" }
+
+workspace "FlumoreBench"
+
+    configurations { "Debug", "Release" }
+    platforms { "x64" }
+
+    filter "configurations:Release"
+        symbols "On"
+        optimize "Speed"
+        defines { "NDEBUG" }
+
+    filter "configurations:Debug"
+        symbols "On"
+
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "options:with-zlib"
+        defines { "FLUMORE_WITH_ZLIB" }
+        links { "z" }
+
+    filter "options:with-zstd"
+        defines { "FLUMORE_WITH_ZSTD" }
+        links { "zstd" }
+
+    filter { "options:with-uring", "system:linux" }
+        defines { "FLUMORE_WITH_URING" }
+
+    filter {}
+
+    project("flumore_bench")
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++14"
+        includedirs { "../fme_headless/include", "../fme_headless", "../fme_flumore_reader" }
+        files {
+            "*.h", "*.cpp",
+            "../fme_headless/include/*.h", "../fme_headless/headless*.h", "../fme_headless/headless*.cpp",
+            "../fme_flumore_reader/flumoreparser.h", "../fme_flumore_reader/flumoreparser.cpp",
+            "../fme_flumore_reader/flumorefilereader.h", "../fme_flumore_reader/flumorefilereader.cpp",
+            "../fme_flumore_reader/flumoredecompressor.h", "../fme_flumore_reader/flumoredecompressor.cpp",
+            "../fme_flumore_reader/flumorecache.h", "../fme_flumore_reader/flumorecache.cpp",
+            "../fme_flumore_reader/flumorearena.h", "../fme_flumore_reader/flumorearena.cpp",
+            "../fme_flumore_reader/flumoreformat.h", "../fme_flumore_reader/flumoreformat.cpp",
+            "../fme_flumore_reader/flumorefilewriter.h", "../fme_flumore_reader/flumorefilewriter.cpp",
+            "../fme_flumore_reader/flumorecompactrows.h", "../fme_flumore_reader/flumorecompactrows.cpp",
+            "../fme_flumore_reader/flumorereprojector.h", "../fme_flumore_reader/flumorereprojector.cpp",
+            "../fme_flumore_reader/flumorethreadpool.h", "../fme_flumore_reader/flumorethreadpool.cpp",
+            "../fme_flumore_reader/flumorefeaturebuilder.h", "../fme_flumore_reader/flumorefeaturebuilder.cpp",
+            "../fme_flumore_reader/flumorestats.h", "../fme_flumore_reader/flumorestats.cpp"
+        }
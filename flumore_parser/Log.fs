@@ -0,0 +1,81 @@
+﻿module Log
+open System.Threading
+
+/// <summary>
+/// Verbosity of the parser output. The values are shared with FLUMORELogLevel
+/// in flumorelog.h of the FME plug-in, so keep both in sync.
+/// </summary>
+type Level =
+    | Off = 0
+    | Summary = 1
+    | Sample = 2
+    | Full = 3
+
+/// <summary>
+/// Severity of a queued message, returned by lastSeverities. The values are shared with
+/// FLUMOREParserSeverity in flumorelog.h of the FME plug-in, so keep both in sync.
+/// </summary>
+type Severity =
+    | Info = 0
+    | Warning = 1
+
+/// Upper bound of queued messages, everything beyond is only counted.
+[<Literal>]
+let private maxQueued = 1000
+
+/// The level and the queued messages of one thread calling the parser, so readers parsing on
+/// several threads neither change each other's level nor drain each other's messages. Messages
+/// have to be posted on the thread calling the parser.
+type private ThreadLog() =
+    member val Level = Level.Summary with get, set
+    member val Messages = ResizeArray<string * Severity>()
+    member val Dropped = 0 with get, set
+    member val DroppedWarnings = false with get, set
+    member val Severities : int array = [||] with get, set
+
+let private threadLog = new ThreadLocal<ThreadLog>(fun () -> ThreadLog())
+
+let private post severity (msg:string) =
+    let log = threadLog.Value
+    if log.Messages.Count < maxQueued then log.Messages.Add((msg, severity))
+    else
+        log.Dropped <- log.Dropped + 1
+        log.DroppedWarnings <- log.DroppedWarnings || severity = Severity.Warning
+
+/// <summary>
+/// Sets the verbosity of the calling thread, called by the FME plug-in before parsing.
+/// </summary>
+/// <param name="value">One of the values of Level.</param>
+let setLevel (value:int) = threadLog.Value.Level <- enum<Level> value
+
+/// Whether info keeps its messages on the calling thread. The arguments are formatted before
+/// info can look at the level, so callers check this first where that costs.
+let infoEnabled () = threadLog.Value.Level >= Level.Full
+
+/// Progress output, only kept if everything is logged.
+let info format = Printf.kprintf (fun msg -> if infoEnabled () then post Severity.Info msg) format
+
+/// Problems with the parsed file, kept at every level like the warnings of the FME plug-in.
+let warning format = Printf.kprintf (post Severity.Warning) format
+
+/// <summary>
+/// Returns the messages queued on the calling thread and empties its queue. The C side forwards
+/// them to the FME log file, with the severities of lastSeverities.
+/// </summary>
+let drain () =
+    let log = threadLog.Value
+    let result = ResizeArray(log.Messages |> Seq.map fst)
+    let severities = ResizeArray(log.Messages |> Seq.map (snd >> int))
+    log.Messages.Clear()
+    if log.Dropped > 0 then
+        result.Add (sprintf "Parser, INFO: %d further messages suppressed." log.Dropped)
+        severities.Add (int (if log.DroppedWarnings then Severity.Warning else Severity.Info))
+        log.Dropped <- 0
+        log.DroppedWarnings <- false
+    log.Severities <- severities.ToArray()
+    result.ToArray()
+
+/// <summary>
+/// Returns the Severity of every message returned by the last call to drain on the calling thread.
+/// </summary>
+let lastSeverities () = Array.copy threadLog.Value.Severities
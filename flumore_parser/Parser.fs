@@ -4,6 +4,7 @@ open Definitions
 open Patterns
 open Utils
 open System.Diagnostics
+open System.Threading
 open System.Threading.Tasks
 
 type TimestampPaket = {
@@ -12,6 +13,47 @@ type TimestampPaket = {
     Data : (int * float * float * float * float * float * float) array
 }
 
+/// Indices into the statistics returned by lastStatistics. The FME plug-in
+/// reads them in the same order, see FLUMOREParserStatistic in flumorestats.h.
+[<Literal>]
+let private statReadMilliseconds = 0
+[<Literal>]
+let private statScanMilliseconds = 1
+[<Literal>]
+let private statDecodeMilliseconds = 2
+[<Literal>]
+let private statRowsRejected = 3
+[<Literal>]
+let private statThreads = 4
+
+[<Literal>]
+let private statCount = 5
+
+/// The statistics of the last call to getSimulationFileData on each thread. Every call collects them
+/// in an array of its own, so readers parsing on several threads don't overwrite each other's.
+let private threadStatistics = new ThreadLocal<int64 array>(fun () -> Array.zeroCreate statCount)
+
+/// The options of the parallel loops for every thread limit used so far. The loops of all calls with
+/// the same limit share one scheduler, which is never completed.
+let private limitedOptions = System.Collections.Concurrent.ConcurrentDictionary<int, ParallelOptions>()
+
+/// The options of the parallel loops of getSimulationFileData on each thread, see setMaxThreads.
+let private threadOptions = new ThreadLocal<ParallelOptions>(fun () -> ParallelOptions())
+
+/// <summary>
+/// C compatibility API, limits getSimulationFileData on the calling thread to value threads, the nested
+/// parallel loops included. The FME plug-in passes the size of its shared thread pool. 0 or less removes
+/// the limit.
+/// </summary>
+let setMaxThreads (value:int) =
+    threadOptions.Value <-
+        if value > 0 then
+            limitedOptions.GetOrAdd(value, fun limit ->
+                let scheduler = ConcurrentExclusiveSchedulerPair(TaskScheduler.Default, limit).ConcurrentScheduler
+                ParallelOptions(MaxDegreeOfParallelism = limit, TaskScheduler = scheduler))
+        else
+            ParallelOptions()
+
 /// <summary>
 /// Tries to parse the first line of a simulation file.
 /// It's allowed to pass the complete file text here because the pattern is whitespace resistent and unique.
@@ -24,7 +66,7 @@ let tryParsePackageIdentifier firstLine =
             let res = completeIdentifierRegex.TypedMatch(firstLine)
             if res.Success then Some res
             else None
-        let! date = regex.date.Value |> DateTime.tryParse |> Option.map DateTime.toUniversalTime
+        let! date = regex.date.Value |> DateTime.tryParseFlumore |> Option.map DateTime.toUniversalTime
         let timesteps = regex.timesteps.Value |> Convert.ToInt32
         let variantNumber = regex.variant.Value |> Convert.ToInt32
         let counterNumber = regex.counter.Value |> Convert.ToInt32
@@ -81,7 +123,7 @@ let tryParseTimestampIdentifier timestamp =
                 | "SZO" -> return TimestampKind.Scenario
                 | _ -> ()
             }
-        let! date = regex.date.Value |> DateTime.tryParse |> Option.map DateTime.toUniversalTime
+        let! date = regex.date.Value |> DateTime.tryParseFlumore |> Option.map DateTime.toUniversalTime
         let subspanCount = regex.subspanCount.Value |> System.Convert.ToInt32
         let _2DCount = regex._2DCount.Value |> System.Convert.ToInt32
         return TimestampIdentifier(
@@ -167,7 +209,8 @@ let (|IsTimestampSubData|_|) (lines:string array, lineNumber) =
     let first = lines.[lineNumber]
     tryParseSubDataIdentifier first
     
-let tryParseSimulationFile (path:string) =
+let tryParseSimulationFile (path:string) (statistics:int64 array) =
+    let stopwatch = Stopwatch.StartNew()
     let ret = 
         maybe {
             #if DEBUG
@@ -175,6 +218,7 @@ let tryParseSimulationFile (path:string) =
             #endif 
             let! allLines =
                 File.tryReadAllLines path |> Result.asOption
+            statistics.[statReadMilliseconds] <- stopwatch.ElapsedMilliseconds
             let! fileIdentifier = tryParseFileName (System.IO.Path.GetFileName path)
             let! packageIdentifier = tryParsePackageIdentifier (allLines.[0])
             return allLines, fileIdentifier, packageIdentifier
@@ -190,30 +234,37 @@ let tryParseSimulationFile (path:string) =
                     | IsTimestampHeader identifier ->
                         lineNumber + 1, TimestampHeader(identifier, lineNumber)
                     | IsTimestampSubHeader identifier ->
-                        printfn "Pre-Parser, INFO: Parsing %.2f %% complete" (((float lineNumber + 2.) / float lines.Length) * 100.)
+                        if Log.infoEnabled () then
+                            Log.info "Pre-Parser, INFO: Parsing %.2f %% complete" (((float lineNumber + 2.) / float lines.Length) * 100.)
                         lineNumber + 3, TimestampSubHeader(context, identifier, lineNumber, lineNumber + 2)
                     | IsTimestampSubData (TimestampSubDataIdentifier(count, _, _) as identifier) ->
                         lineNumber + 2 + count, TimestampSubData(context, identifier, lineNumber, lineNumber + 1 + count)
                     | _ -> 
-                        printfn "Pre-Praser, WARNING: Parsing line %A with content \"%s\" failed!" lineNumber (lines.[lineNumber])
+                        Log.warning "Pre-Parser, WARNING: Parsing line %A with content \"%s\" failed!" lineNumber (lines.[lineNumber])
                         lineNumber + 1, Detached
                 newAst |> res.Add
                 parseFile newPos
             else () // Finished parsing
         parseFile 1 
+        statistics.[statScanMilliseconds] <- stopwatch.ElapsedMilliseconds - statistics.[statReadMilliseconds]
         Some { AllLines = lines; AST = res |> Seq.toList }
     | _ -> 
-        printfn "Tokenizing and Pre-Parsing failed." 
+        Log.warning "Tokenizing and Pre-Parsing failed." 
         None
 
 let  testUnicodeNameaeae () = ()
 
 /// C compatibility API
 let getSimulationFileData path =
+    let statistics : int64 array = Array.zeroCreate statCount
+    // Taken here, the loops run on other threads.
+    let parallelOptions = threadOptions.Value
     let stopwatch = Stopwatch.StartNew()
+    let threads = System.Collections.Concurrent.ConcurrentDictionary<int, unit>()
     let res = 
-        match tryParseSimulationFile path with
+        match tryParseSimulationFile path statistics with
         | Some res ->
+            let decodeStart = stopwatch.ElapsedMilliseconds
             let AllLines, ast = res.AllLines, res.AST
             let parseCSV startLine endLine =
                 let parseLine nmbr =
@@ -234,15 +285,30 @@ let getSimulationFileData path =
                             return { id = id; x = x; y = y; z = z; wsp = wsp; h = h; vres = vres }
                     }
                 // The first section includes the CSV table definitions which we already know. So skip the first line!
-                let resizeArray = ResizeArray(Capacity = endLine - 1 - startLine)
-                let init = parseLine >> Option.iter(resizeArray.Add)
-                    //|> Option.defaultValue (
+                // The rows follow up to and including endLine. Every row gets its own slot, so the
+                // parallel loop neither races nor reorders the rows. A truncated file ends before
+                // endLine, the missing rows stay unparsed and count as rejected.
+                let firstRow = startLine + 1
+                let lastRow = min endLine (AllLines.Length - 1)
+                let rows = Array.zeroCreate (endLine - startLine)
+                let parsed = Array.zeroCreate (endLine - startLine)
+                let init nmbr =
+                    match parseLine nmbr with
+                    | Some row ->
+                        rows.[nmbr - firstRow] <- row
+                        parsed.[nmbr - firstRow] <- true
+                    | None -> ()
                     //    printfn "Data-Parser, WARNING: Parsing line %A with content \"%s\" failed" i (AllLines.[i])
-                    //    DataRowFLUMORE.Invalid
-                    //)
-                Parallel.For(startLine + 1, endLine, init) |> ignore
+                Parallel.For(firstRow, lastRow + 1, parallelOptions,
+                             (fun () -> threads.TryAdd(Thread.CurrentThread.ManagedThreadId, ()) |> ignore),
+                             (fun nmbr _ () -> init nmbr),
+                             (fun () -> ())) |> ignore
 
-                resizeArray.ToArray()
+                let result = ResizeArray(Capacity = rows.Length)
+                for i in 0 .. rows.Length - 1 do
+                    if parsed.[i] then result.Add rows.[i]
+                Interlocked.Add(&statistics.[statRowsRejected], int64 (rows.Length - result.Count)) |> ignore
+                result.ToArray()
 
             let results = ResizeArray()
 
@@ -265,9 +331,13 @@ let getSimulationFileData path =
                     |> Table |> Some
                 | _ -> None
               
-            ast 
-            |> List.toArray 
-            |> Array.Parallel.choose parseSubDataSection
+            let sections = ast |> List.toArray
+            let chosen : DataTableFLUMORE option array = Array.zeroCreate sections.Length
+            Parallel.For(0, sections.Length, parallelOptions,
+                         (fun i -> chosen.[i] <- parseSubDataSection sections.[i])) |> ignore
+            let tables = chosen |> Array.choose id
+            statistics.[statDecodeMilliseconds] <- stopwatch.ElapsedMilliseconds - decodeStart
+            tables
 
             //let rec visitAST remainingAST =
             //    match remainingAST with
@@ -295,13 +365,23 @@ let getSimulationFileData path =
             //    | _ -> results
             //visitAST ast
         | None -> 
-            printfn "FATAL: No result of the parser, returned data will be empty!"
+            Log.warning "FATAL: No result of the parser, returned data will be empty!"
             [||]
     stopwatch.Stop()
+    statistics.[statThreads] <- int64 threads.Count
+    threadStatistics.Value <- statistics
     let diff = stopwatch.ElapsedMilliseconds
-    printfn "Parsing took %d milliseconds." diff
+    if Log.infoEnabled () then
+        Log.info "Parsing took %d milliseconds." diff
     res
 
+/// <summary>
+/// C compatibility API, returns the timings and counters of the last call to getSimulationFileData
+/// on the calling thread: read, scan and decode time in milliseconds, the number of rejected rows
+/// and the number of threads.
+/// </summary>
+let lastStatistics () = Array.copy threadStatistics.Value
+
 let test () = [|1|]
 
 type Foo = | Bar of int
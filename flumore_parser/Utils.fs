@@ -129,6 +129,23 @@ module DateTime =
         let success, res = System.DateTime.TryParse input
         Option.someIf success res
 
+    /// Parses the dd.MM.yyyy-HH:mm of the FLUMORE files as local time. The
+    /// fields are taken by position whatever the culture of the machine is,
+    /// the separators are not checked, as in patternDate.
+    let tryParseFlumore (input:string) =
+        if isNull input || input.Length <> 16 then None
+        else
+            let field start length =
+                System.Int32.Parse(input.Substring(start, length),
+                                   System.Globalization.NumberStyles.None,
+                                   System.Globalization.CultureInfo.InvariantCulture)
+            try
+                Some (System.DateTime(field 6 4, field 3 2, field 0 2, field 11 2, field 14 2, 0,
+                                      System.DateTimeKind.Local))
+            with
+            | :? System.FormatException
+            | :? System.ArgumentOutOfRangeException -> None
+
 
 type MaybeBuilder() =
     member this.Bind(x, f) = 
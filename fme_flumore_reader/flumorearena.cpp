@@ -0,0 +1,107 @@
+/*=============================================================================
+
+   Name     : flumorearena.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREArena method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorearena.h"
+
+#include <new>
+
+const size_t FLUMOREArena::kDefaultChunkSize;
+
+//===========================================================================
+// Constructor
+FLUMOREArena::FLUMOREArena(size_t chunkSize)
+:
+   offset_(0),
+   chunkSize_(chunkSize > 0 ? chunkSize : kDefaultChunkSize),
+   used_(0),
+   capacity_(0),
+   systemAllocations_(0)
+{
+}
+
+//===========================================================================
+// Destructor
+FLUMOREArena::~FLUMOREArena()
+{
+   clear();
+}
+
+//===========================================================================
+// Allocate
+void* FLUMOREArena::allocate(size_t bytes, size_t alignment)
+{
+   if (!chunks_.empty())
+   {
+      const Chunk& chunk = chunks_.back();
+      const uintptr_t address = reinterpret_cast<uintptr_t>(chunk.data) + offset_;
+      const size_t padding = size_t((alignment - (address & (alignment - 1))) & (alignment - 1));
+      if (offset_ + padding <= chunk.size && bytes <= chunk.size - offset_ - padding)
+      {
+         offset_ += padding + bytes;
+         used_ += padding + bytes;
+         return chunk.data + offset_ - bytes;
+      }
+   }
+
+   grow(bytes + alignment);
+   return allocate(bytes, alignment);
+}
+
+//===========================================================================
+// Reset
+void FLUMOREArena::reset()
+{
+   // The next block likely needs as much again, in one chunk.
+   if (chunks_.size() > 1)
+   {
+      const size_t total = capacity_;
+      clear();
+      grow(total);
+   }
+   offset_ = 0;
+   used_ = 0;
+}
+
+//===========================================================================
+// Clear
+void FLUMOREArena::clear()
+{
+   for (size_t i = 0; i < chunks_.size(); ++i)
+   {
+      ::operator delete(chunks_[i].data);
+   }
+   chunks_.clear();
+   offset_ = 0;
+   used_ = 0;
+   capacity_ = 0;
+}
+
+//===========================================================================
+// Grow
+void FLUMOREArena::grow(size_t bytes)
+{
+   // Chunks double, so a growing block takes few of them.
+   size_t size = chunks_.empty() ? chunkSize_ : chunks_.back().size * 2;
+   if (size < bytes)
+   {
+      size = bytes;
+   }
+
+   Chunk chunk;
+   chunk.data = static_cast<char*>(::operator new(size));
+   chunk.size = size;
+   chunks_.push_back(chunk);
+   offset_ = 0;
+   capacity_ += size;
+   ++systemAllocations_;
+}
@@ -0,0 +1,118 @@
+#ifndef FLUMORE_ARENA_H
+#define FLUMORE_ARENA_H
+/*=============================================================================
+
+   Name     : flumorearena.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREArena, the allocator of per block
+              intermediates
+
+=============================================================================*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// FLUMOREArena
+//
+// A bump allocator for the short lived data of one Teilbereich block.
+// Allocations are never freed one by one; reset() drops all of them at
+// once when the block has been read. After a reset the memory is kept,
+// so once the arena has grown to the largest block no further memory is
+// taken from the heap. If a block needed more than one chunk, reset()
+// replaces them by a single chunk of their total size.
+// Objects placed in the arena must not need a destructor.
+class FLUMOREArena
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   // The first chunk is taken on the first allocation.
+   explicit FLUMOREArena(size_t chunkSize = kDefaultChunkSize);
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   ~FLUMOREArena();
+
+   // -----------------------------------------------------------------------
+   // allocate()
+   // Uninitialized memory for bytes bytes at the given alignment, which
+   // must be a power of two.
+   void* allocate(size_t bytes, size_t alignment);
+
+   // -----------------------------------------------------------------------
+   // allocate()
+   // Uninitialized memory for count values of T.
+   template <typename T>
+   T* allocate(size_t count)
+   {
+      return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+   }
+
+   // -----------------------------------------------------------------------
+   // reset()
+   // Drops all allocations and keeps the memory.
+   void reset();
+
+   // -----------------------------------------------------------------------
+   // clear()
+   // Drops all allocations and releases the memory.
+   void clear();
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   // used() are the bytes allocated since the last reset, capacity() the
+   // bytes held, systemAllocations() counts the chunks taken from the heap.
+   size_t used() const { return used_; }
+   size_t capacity() const { return capacity_; }
+   uint64_t systemAllocations() const { return systemAllocations_; }
+
+   // The size of the first chunk if none is given.
+   static const size_t kDefaultChunkSize = 1 << 20;
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREArena(const FLUMOREArena&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREArena &operator=(const FLUMOREArena&);
+
+   // -----------------------------------------------------------------------
+   // grow()
+   // Adds a chunk holding at least bytes bytes at any alignment.
+   void grow(size_t bytes);
+
+   //=====================================================================
+   struct Chunk
+   {
+      char* data;
+      size_t size;
+   };
+
+   // Data members
+
+   // All chunks, the last one is allocated from.
+   vector<Chunk> chunks_;
+
+   // The next free byte of the last chunk.
+   size_t offset_;
+
+   size_t chunkSize_;
+   size_t used_;
+   size_t capacity_;
+   uint64_t systemAllocations_;
+};
+
+#endif
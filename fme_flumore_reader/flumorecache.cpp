@@ -0,0 +1,916 @@
+/*=============================================================================
+
+   Name     : flumorecache.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMORECache method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorecache.h"
+#include "flumoreformat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef FLUMORE_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef FLUMORE_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+   // Start and end of every cache file, followed by the version.
+   const char kMagic[8] = { 'F', 'L', 'U', 'M', 'C', 'A', 'C', 'H' };
+   const uint32_t kVersion = 2;
+
+   // magic, version, flags, dataset size and time.
+   const size_t kHeaderSize = 8 + 4 + 4 + 8 + 8;
+
+   // Checksum of the footer, footer offset and magic.
+   const size_t kTrailerSize = 4 + 8 + 8;
+
+   // The encodings of a column.
+   enum ColumnCodec
+   {
+      // int32 as varint of the zigzag delta to the previous value.
+      kCodecIdDelta = 1,
+      // value * 10^scale as integer, varint of the zigzag delta.
+      kCodecScaledDelta,
+      // value * 10^scale as integer, runs of zeros as their length
+      // followed by the next value.
+      kCodecScaledZeroRuns,
+      // XOR with the previous double, bytes shuffled into 8 planes.
+      kCodecXorShuffle
+   };
+
+   // The largest scale tried for decimal columns, and the largest
+   // integer every double between 0 and it represents exactly.
+   const int kMaxScale = 9;
+   const double kPowersOfTen[kMaxScale + 1] =
+   {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+   };
+   const double kMaxExactInteger = 9007199254740992.0;
+
+   //------------------------------------------------------------------------
+   // CRC-32 of the bytes from p to end, the same with and without zlib.
+   uint32_t checksum(const char* p, const char* end)
+   {
+#ifdef FLUMORE_WITH_ZLIB
+      uLong crc = crc32(0L, Z_NULL, 0);
+      while (p < end)
+      {
+         // crc32() takes at most a uInt at once.
+         const size_t length = std::min(size_t(end - p), size_t(1) << 30);
+         crc = crc32(crc, reinterpret_cast<const Bytef*>(p), uInt(length));
+         p += length;
+      }
+      return uint32_t(crc);
+#else
+      static const struct Table
+      {
+         Table()
+         {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+               uint32_t value = i;
+               for (int k = 0; k < 8; ++k)
+               {
+                  value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+               }
+               entries[i] = value;
+            }
+         }
+         uint32_t entries[256];
+      } table;
+
+      uint32_t crc = 0xFFFFFFFFu;
+      for (; p < end; ++p)
+      {
+         crc = table.entries[(crc ^ static_cast<unsigned char>(*p)) & 0xFF] ^ (crc >> 8);
+      }
+      return crc ^ 0xFFFFFFFFu;
+#endif
+   }
+
+   //------------------------------------------------------------------------
+   // The cache files are read on the machine architecture they were
+   // written on, values are stored as they are in memory.
+   template <typename T>
+   void putValue(vector<char>& out, T value)
+   {
+      const char* p = reinterpret_cast<const char*>(&value);
+      out.insert(out.end(), p, p + sizeof(T));
+   }
+
+   //------------------------------------------------------------------------
+   void putVarint(vector<char>& out, uint64_t value)
+   {
+      while (value >= 0x80)
+      {
+         out.push_back(char(value | 0x80));
+         value >>= 7;
+      }
+      out.push_back(char(value));
+   }
+
+   //------------------------------------------------------------------------
+   // Writes value at p, at most kMaxVarintBytes bytes, and advances p.
+   const size_t kMaxVarintBytes = 10;
+
+   inline void putVarint(char*& p, uint64_t value)
+   {
+      while (value >= 0x80)
+      {
+         *p++ = char(value | 0x80);
+         value >>= 7;
+      }
+      *p++ = char(value);
+   }
+
+   //------------------------------------------------------------------------
+   void putString(vector<char>& out, const string& value)
+   {
+      putVarint(out, value.size());
+      out.insert(out.end(), value.begin(), value.end());
+   }
+
+   //------------------------------------------------------------------------
+   inline uint64_t zigzag(int64_t value)
+   {
+      return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+   }
+
+   //------------------------------------------------------------------------
+   inline int64_t unzigzag(uint64_t value)
+   {
+      return int64_t(value >> 1) ^ -int64_t(value & 1);
+   }
+
+   //=====================================================================
+   // Reads the values written by the put functions. Every read checks
+   // the end of the data, ok() tells whether all of them succeeded.
+   class ByteReader
+   {
+   public:
+      ByteReader(const char* begin, const char* end) : p_(begin), end_(end), ok_(true) {}
+
+      const char* skip(size_t length)
+      {
+         if (!ok_ || size_t(end_ - p_) < length)
+         {
+            ok_ = false;
+            return NULL;
+         }
+         const char* start = p_;
+         p_ += length;
+         return start;
+      }
+
+      template <typename T>
+      T value()
+      {
+         T result = T();
+         const char* p = skip(sizeof(T));
+         if (p != NULL)
+         {
+            memcpy(&result, p, sizeof(T));
+         }
+         return result;
+      }
+
+      uint64_t varint()
+      {
+         uint64_t result = 0;
+         for (int shift = 0; shift < 64 && p_ < end_; shift += 7)
+         {
+            const unsigned char byte = static_cast<unsigned char>(*p_++);
+            result |= uint64_t(byte & 0x7f) << shift;
+            if (byte < 0x80)
+            {
+               return result;
+            }
+         }
+         ok_ = false;
+         return 0;
+      }
+
+      string text()
+      {
+         const uint64_t length = varint();
+         const char* p = skip(size_t(length));
+         return p != NULL ? string(p, size_t(length)) : string();
+      }
+
+      bool ok() const { return ok_; }
+      bool atEnd() const { return p_ == end_; }
+
+   private:
+      const char* p_;
+      const char* end_;
+      bool ok_;
+   };
+
+   //------------------------------------------------------------------------
+   // Finds the smallest scale at which every value is an integer that
+   // converts back to exactly the same double. This holds for the values
+   // of the parser's decimal path, whose digits are all significant.
+   bool findScale(const vector<double>& values, int& scale)
+   {
+      for (scale = 0; scale <= kMaxScale; ++scale)
+      {
+         const double power = kPowersOfTen[scale];
+         size_t i = 0;
+         for (; i < values.size(); ++i)
+         {
+            const double scaled = std::floor(values[i] * power + 0.5);
+            if (!(std::fabs(scaled) < kMaxExactInteger) || scaled / power != values[i] ||
+                std::signbit(values[i]))
+            {
+               break;
+            }
+         }
+         if (i == values.size())
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   //------------------------------------------------------------------------
+   // Writes the header of a column followed by its encoded bytes.
+   void putColumn(vector<char>& out, ColumnCodec codec, int scale, const char* bytes, const char* end)
+   {
+      out.push_back(char(codec));
+      out.push_back(char(scale));
+      putValue<uint64_t>(out, uint64_t(end - bytes));
+      out.insert(out.end(), bytes, end);
+   }
+
+   //------------------------------------------------------------------------
+   // The encoded bytes are built in scratch before they are appended.
+   void encodeIds(const vector<int32_t>& ids, vector<char>& out, FLUMOREArena& scratch)
+   {
+      char* const bytes = scratch.allocate<char>(ids.size() * kMaxVarintBytes);
+      char* p = bytes;
+      int64_t previous = 0;
+      for (size_t i = 0; i < ids.size(); ++i)
+      {
+         putVarint(p, zigzag(int64_t(ids[i]) - previous));
+         previous = ids[i];
+      }
+      putColumn(out, kCodecIdDelta, 0, bytes, p);
+   }
+
+   //------------------------------------------------------------------------
+   void encodeDoubles(const vector<double>& values, vector<char>& out, FLUMOREArena& scratch)
+   {
+      const size_t rows = values.size();
+      int scale = 0;
+      if (findScale(values, scale))
+      {
+         const double power = kPowersOfTen[scale];
+
+         char* const deltas = scratch.allocate<char>(rows * kMaxVarintBytes);
+         char* deltasEnd = deltas;
+         int64_t previous = 0;
+         for (size_t i = 0; i < rows; ++i)
+         {
+            const int64_t scaled = int64_t(std::floor(values[i] * power + 0.5));
+            putVarint(deltasEnd, zigzag(scaled - previous));
+            previous = scaled;
+         }
+
+         // Given up as soon as it is not shorter, so it never exceeds
+         // the deltas by more than one run.
+         char* const runs = scratch.allocate<char>(size_t(deltasEnd - deltas) + 2 * kMaxVarintBytes);
+         char* runsEnd = runs;
+         for (size_t i = 0; i < rows && runsEnd - runs < deltasEnd - deltas; )
+         {
+            size_t zeros = 0;
+            for (; i < rows && values[i] == 0.0; ++i)
+            {
+               ++zeros;
+            }
+            putVarint(runsEnd, zeros);
+            if (i < rows)
+            {
+               putVarint(runsEnd, uint64_t(std::floor(values[i++] * power + 0.5)));
+            }
+         }
+
+         if (runsEnd - runs < deltasEnd - deltas)
+         {
+            putColumn(out, kCodecScaledZeroRuns, scale, runs, runsEnd);
+         }
+         else
+         {
+            putColumn(out, kCodecScaledDelta, scale, deltas, deltasEnd);
+         }
+         return;
+      }
+
+      char* const planes = scratch.allocate<char>(rows * 8);
+      uint64_t previous = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+         uint64_t bits = 0;
+         memcpy(&bits, &values[i], 8);
+         const uint64_t change = bits ^ previous;
+         previous = bits;
+         for (size_t k = 0; k < 8; ++k)
+         {
+            planes[k * rows + i] = char(change >> (8 * k));
+         }
+      }
+      putColumn(out, kCodecXorShuffle, 0, planes, planes + rows * 8);
+   }
+
+   //------------------------------------------------------------------------
+   bool decodeIds(ByteReader& in, size_t rows, vector<int32_t>& ids)
+   {
+      const int codec = in.value<unsigned char>();
+      in.value<unsigned char>();
+      const uint64_t length = in.value<uint64_t>();
+      const char* p = in.skip(size_t(length));
+      if (p == NULL || codec != kCodecIdDelta)
+      {
+         return false;
+      }
+
+      ByteReader bytes(p, p + length);
+      ids.resize(rows);
+      int64_t previous = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+         previous += unzigzag(bytes.varint());
+         ids[i] = int32_t(previous);
+      }
+      return bytes.ok();
+   }
+
+   //------------------------------------------------------------------------
+   bool decodeDoubles(ByteReader& in, size_t rows, vector<double>& values, FLUMOREArena& scratch)
+   {
+      const int codec = in.value<unsigned char>();
+      const int scale = in.value<unsigned char>();
+      const uint64_t length = in.value<uint64_t>();
+      const char* p = in.skip(size_t(length));
+      if (p == NULL || scale > kMaxScale)
+      {
+         return false;
+      }
+
+      values.resize(rows);
+      double* const out = values.empty() ? NULL : &values[0];
+      const double power = kPowersOfTen[scale];
+      ByteReader bytes(p, p + length);
+      switch (codec)
+      {
+      case kCodecScaledDelta:
+      {
+         int64_t previous = 0;
+         for (size_t i = 0; i < rows; ++i)
+         {
+            previous += unzigzag(bytes.varint());
+            out[i] = double(previous) / power;
+         }
+         return bytes.ok();
+      }
+      case kCodecScaledZeroRuns:
+      {
+         size_t i = 0;
+         while (i < rows && bytes.ok())
+         {
+            const uint64_t zeros = bytes.varint();
+            if (zeros > rows - i)
+            {
+               return false;
+            }
+            for (const size_t end = i + size_t(zeros); i < end; ++i)
+            {
+               out[i] = 0.0;
+            }
+            if (i < rows)
+            {
+               out[i++] = double(bytes.varint()) / power;
+            }
+         }
+         return bytes.ok();
+      }
+      case kCodecXorShuffle:
+      {
+         if (length != rows * 8)
+         {
+            return false;
+         }
+         // Gathering the planes is independent per row and left to the
+         // compiler to vectorize, only the XOR chain is sequential.
+         const unsigned char* const planes = reinterpret_cast<const unsigned char*>(p);
+         uint64_t* const changes = scratch.allocate<uint64_t>(rows);
+         memset(changes, 0, rows * sizeof(uint64_t));
+         for (size_t k = 0; k < 8; ++k)
+         {
+            const unsigned char* const plane = planes + k * rows;
+            for (size_t i = 0; i < rows; ++i)
+            {
+               changes[i] |= uint64_t(plane[i]) << (8 * k);
+            }
+         }
+         uint64_t bits = 0;
+         for (size_t i = 0; i < rows; ++i)
+         {
+            bits ^= changes[i];
+            memcpy(&out[i], &bits, 8);
+         }
+         return true;
+      }
+      default:
+         return false;
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // The size and modification time of a file.
+   bool fileStamp(const string& path, uint64_t& size, int64_t& time)
+   {
+#ifdef WIN32
+      struct __stat64 status;
+      if (_stat64(path.c_str(), &status) != 0)
+      {
+         return false;
+      }
+#else
+      struct stat status;
+      if (stat(path.c_str(), &status) != 0)
+      {
+         return false;
+      }
+#endif
+      size = uint64_t(status.st_size);
+      time = int64_t(status.st_mtime);
+      return true;
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMORECache::FLUMORECache()
+:
+   file_(NULL),
+   datasetSize_(0),
+   datasetTime_(0),
+   size_(0)
+{
+   header_.timesteps = 0;
+   header_.variant = 0;
+   header_.counter = 0;
+}
+
+//===========================================================================
+// Destructor
+FLUMORECache::~FLUMORECache()
+{
+   clear();
+}
+
+//===========================================================================
+// Cache Path
+string FLUMORECache::cachePath(const string& directory, const string& dataset)
+{
+   // FNV-1a of the path as given.
+   uint64_t hash = 14695981039346656037ULL;
+   for (size_t i = 0; i < dataset.size(); ++i)
+   {
+      hash = (hash ^ static_cast<unsigned char>(dataset[i])) * 1099511628211ULL;
+   }
+
+   const size_t slash = dataset.find_last_of("/\\");
+   const string name = (slash == string::npos) ? dataset : dataset.substr(slash + 1);
+
+   char digits[17];
+   snprintf(digits, sizeof(digits), "%016llx", static_cast<unsigned long long>(hash));
+   return directory + "/" + name + "-" + digits + ".flumorecache";
+}
+
+//===========================================================================
+// Clear
+void FLUMORECache::clear()
+{
+   if (file_ != NULL)
+   {
+      fclose(file_);
+      file_ = NULL;
+      remove((path_ + ".tmp").c_str());
+   }
+   vector<char>().swap(data_);
+   vector<char>().swap(encoded_);
+   vector<char>().swap(compressed_);
+   scratch_.clear();
+   timestamps_.clear();
+   situations_.clear();
+   blocks_.clear();
+   encodings_.clear();
+   path_.clear();
+   size_ = 0;
+   error_.clear();
+}
+
+//===========================================================================
+// Open
+bool FLUMORECache::open(const string& path, const string& dataset, const FLUMORETimeZone& zone)
+{
+   clear();
+
+   uint64_t datasetSize = 0;
+   int64_t datasetTime = 0;
+   if (!fileStamp(dataset, datasetSize, datasetTime))
+   {
+      error_ = "Could not find " + dataset;
+      return false;
+   }
+
+   ifstream in(path.c_str(), ios::in | ios::binary);
+   if (!in)
+   {
+      error_ = "There is no cache " + path;
+      return false;
+   }
+   in.seekg(0, ios::end);
+   const streamoff length = in.tellg();
+   in.seekg(0, ios::beg);
+   if (length < streamoff(kHeaderSize + kTrailerSize))
+   {
+      error_ = "The cache is damaged: " + path;
+      return false;
+   }
+   data_.resize(size_t(length));
+   if (!in.read(&data_[0], length))
+   {
+      clear();
+      error_ = "Could not read " + path;
+      return false;
+   }
+
+   const char* const begin = &data_[0];
+   const char* const end = begin + data_.size();
+   ByteReader header(begin, begin + kHeaderSize);
+   const char* magic = header.skip(8);
+   const uint32_t version = header.value<uint32_t>();
+   header.value<uint32_t>();
+   const uint64_t cachedSize = header.value<uint64_t>();
+   const int64_t cachedTime = header.value<int64_t>();
+   if (memcmp(magic, kMagic, 8) != 0 || version != kVersion || memcmp(end - 8, kMagic, 8) != 0)
+   {
+      clear();
+      error_ = "The cache is damaged or of another version: " + path;
+      return false;
+   }
+   if (cachedSize != datasetSize || cachedTime != datasetTime)
+   {
+      clear();
+      error_ = "The cache is out of date: " + path;
+      return false;
+   }
+
+   uint32_t footerChecksum = 0;
+   uint64_t footer = 0;
+   memcpy(&footerChecksum, end - kTrailerSize, 4);
+   memcpy(&footer, end - kTrailerSize + 4, 8);
+   if (footer < kHeaderSize || footer > data_.size() - kTrailerSize ||
+       checksum(begin + footer, end - kTrailerSize) != footerChecksum)
+   {
+      clear();
+      error_ = "The cache is damaged: " + path;
+      return false;
+   }
+
+   ByteReader in2(begin + footer, end - kTrailerSize);
+   header_.created = in2.text();
+   header_.timesteps = in2.value<int32_t>();
+   header_.variant = in2.value<int32_t>();
+   header_.counter = in2.value<int32_t>();
+
+   const uint64_t timestampCount = in2.varint();
+   for (uint64_t t = 0; t < timestampCount && in2.ok(); ++t)
+   {
+      FLUMORETimestamp timestamp;
+      timestamp.date = in2.text();
+      timestamp.kind = FLUMORETimestampKind(in2.value<unsigned char>());
+      timestamp.subspanCount = in2.value<int32_t>();
+      timestamp.count2D = in2.value<int32_t>();
+      // Converted again, the time zone may have changed.
+      string date;
+      if (!FLUMOREFormat::flumoreDate(timestamp.date, date, timestamp.fmeDate, zone))
+      {
+         timestamp.fmeDate.clear();
+      }
+      timestamps_.push_back(timestamp);
+   }
+
+   const uint64_t situationCount = in2.varint();
+   for (uint64_t s = 0; s < situationCount && in2.ok(); ++s)
+   {
+      FLUMORESituation situation;
+      situation.kind = FLUMORESituationKind(in2.value<unsigned char>());
+      situation.nlp = in2.value<int32_t>();
+      situation.hasLocation = in2.value<unsigned char>() != 0;
+      situation.rw = in2.value<double>();
+      situation.hw = in2.value<double>();
+      for (int i = 0; i < 3; ++i)
+      {
+         situation.values[i] = in2.value<double>();
+      }
+      situation.valueCount = in2.value<int32_t>();
+      situations_.push_back(situation);
+   }
+
+   const uint64_t blockCount = in2.varint();
+   for (uint64_t b = 0; b < blockCount && in2.ok(); ++b)
+   {
+      FLUMOREBlock block;
+      block.timestamp = in2.value<int32_t>();
+      block.situation = in2.value<int32_t>();
+      block.count = in2.value<int32_t>();
+      block.id = in2.value<int32_t>();
+      block.version = in2.value<int32_t>();
+      block.line = size_t(in2.value<uint64_t>());
+      block.begin = 0;
+      block.end = 0;
+
+      Encoding encoding;
+      encoding.offset = in2.value<uint64_t>();
+      encoding.storedSize = in2.value<uint64_t>();
+      encoding.encodedSize = in2.value<uint64_t>();
+      encoding.rows = in2.value<uint32_t>();
+      encoding.rejected = in2.value<uint32_t>();
+      encoding.compressed = in2.value<unsigned char>() != 0;
+      encoding.checksum = in2.value<uint32_t>();
+
+#ifndef FLUMORE_WITH_ZSTD
+      if (encoding.compressed)
+      {
+         clear();
+         error_ = "The cache was compressed with zstd, which this build doesn't support: " + path;
+         return false;
+      }
+#endif
+      if (encoding.offset < kHeaderSize || encoding.offset > footer ||
+          encoding.storedSize > footer - encoding.offset ||
+          block.timestamp >= int32_t(timestamps_.size()) || block.situation >= int32_t(situations_.size()))
+      {
+         clear();
+         error_ = "The cache is damaged: " + path;
+         return false;
+      }
+      blocks_.push_back(block);
+      encodings_.push_back(encoding);
+   }
+
+   if (!in2.ok() || !in2.atEnd())
+   {
+      clear();
+      error_ = "The cache is damaged: " + path;
+      return false;
+   }
+   size_ = data_.size();
+   return true;
+}
+
+//===========================================================================
+// Decode
+bool FLUMORECache::decode(size_t index, FLUMOREColumns& columns, size_t& rejected, FLUMOREArena& scratch) const
+{
+   const Encoding& encoding = encodings_[index];
+   const char* p = &data_[size_t(encoding.offset)];
+   const char* end = p + encoding.storedSize;
+   rejected = encoding.rejected;
+   if (checksum(p, end) != encoding.checksum)
+   {
+      return false;
+   }
+
+   if (encoding.compressed)
+   {
+#ifdef FLUMORE_WITH_ZSTD
+      const size_t size = size_t(encoding.encodedSize);
+      char* const expanded = scratch.allocate<char>(size);
+      const size_t length = ZSTD_decompress(expanded, size, p, size_t(encoding.storedSize));
+      if (ZSTD_isError(length) || length != size)
+      {
+         return false;
+      }
+      p = expanded;
+      end = p + size;
+#else
+      // Rejected by open().
+      return false;
+#endif
+   }
+
+   const size_t rows = encoding.rows;
+   ByteReader in(p, end);
+   return decodeIds(in, rows, columns.id) &&
+          decodeDoubles(in, rows, columns.x, scratch) && decodeDoubles(in, rows, columns.y, scratch) &&
+          decodeDoubles(in, rows, columns.z, scratch) && decodeDoubles(in, rows, columns.wsp, scratch) &&
+          decodeDoubles(in, rows, columns.h, scratch) && decodeDoubles(in, rows, columns.vres, scratch) &&
+          in.atEnd();
+}
+
+//===========================================================================
+// Create
+bool FLUMORECache::create(const string& path, const string& dataset)
+{
+   clear();
+   if (!fileStamp(dataset, datasetSize_, datasetTime_))
+   {
+      error_ = "Could not find " + dataset;
+      return false;
+   }
+
+   // Written under a temporary name, so a cache is either complete or
+   // not there at all.
+   path_ = path;
+   file_ = fopen((path_ + ".tmp").c_str(), "wb");
+   if (file_ == NULL)
+   {
+      error_ = "Could not create " + path_ + ".tmp";
+      return false;
+   }
+
+   vector<char> header;
+   header.insert(header.end(), kMagic, kMagic + 8);
+   putValue<uint32_t>(header, kVersion);
+   putValue<uint32_t>(header, 0);
+   putValue<uint64_t>(header, datasetSize_);
+   putValue<int64_t>(header, datasetTime_);
+   if (fwrite(&header[0], 1, header.size(), file_) != header.size())
+   {
+      clear();
+      error_ = "Could not write " + path;
+      return false;
+   }
+   size_ = header.size();
+   return true;
+}
+
+//===========================================================================
+// Add Block
+bool FLUMORECache::addBlock(const FLUMOREColumns& columns, size_t rejected)
+{
+   if (file_ == NULL)
+   {
+      return false;
+   }
+
+   scratch_.reset();
+   encoded_.clear();
+   encodeIds(columns.id, encoded_, scratch_);
+   encodeDoubles(columns.x, encoded_, scratch_);
+   encodeDoubles(columns.y, encoded_, scratch_);
+   encodeDoubles(columns.z, encoded_, scratch_);
+   encodeDoubles(columns.wsp, encoded_, scratch_);
+   encodeDoubles(columns.h, encoded_, scratch_);
+   encodeDoubles(columns.vres, encoded_, scratch_);
+
+   Encoding encoding;
+   encoding.offset = size_;
+   encoding.encodedSize = encoded_.size();
+   encoding.rows = uint32_t(columns.size());
+   encoding.rejected = uint32_t(rejected);
+   encoding.compressed = false;
+
+   const vector<char>* stored = &encoded_;
+#ifdef FLUMORE_WITH_ZSTD
+   compressed_.resize(ZSTD_compressBound(encoded_.size()));
+   const size_t length = ZSTD_compress(&compressed_[0], compressed_.size(), &encoded_[0], encoded_.size(), 1);
+   if (!ZSTD_isError(length) && length < encoded_.size())
+   {
+      compressed_.resize(length);
+      stored = &compressed_;
+      encoding.compressed = true;
+   }
+#endif
+   encoding.storedSize = stored->size();
+   const char* const bytes = stored->empty() ? NULL : &(*stored)[0];
+   encoding.checksum = checksum(bytes, bytes + stored->size());
+
+   if (!stored->empty() && fwrite(&(*stored)[0], 1, stored->size(), file_) != stored->size())
+   {
+      const string path = path_;
+      clear();
+      error_ = "Could not write " + path;
+      return false;
+   }
+   size_ += stored->size();
+   encodings_.push_back(encoding);
+   return true;
+}
+
+//===========================================================================
+// Finish
+bool FLUMORECache::finish(const FLUMOREParser& parser)
+{
+   if (file_ == NULL)
+   {
+      return false;
+   }
+   const string path = path_;
+   if (encodings_.size() != parser.blocks().size())
+   {
+      clear();
+      error_ = "Not all blocks were added to " + path;
+      return false;
+   }
+
+   vector<char> footer;
+   const FLUMOREPackageHeader& header = parser.header();
+   putString(footer, header.created);
+   putValue<int32_t>(footer, header.timesteps);
+   putValue<int32_t>(footer, header.variant);
+   putValue<int32_t>(footer, header.counter);
+
+   const vector<FLUMORETimestamp>& timestamps = parser.timestamps();
+   putVarint(footer, timestamps.size());
+   for (size_t t = 0; t < timestamps.size(); ++t)
+   {
+      putString(footer, timestamps[t].date);
+      putValue<unsigned char>(footer, static_cast<unsigned char>(timestamps[t].kind));
+      putValue<int32_t>(footer, timestamps[t].subspanCount);
+      putValue<int32_t>(footer, timestamps[t].count2D);
+   }
+
+   const vector<FLUMORESituation>& situations = parser.situations();
+   putVarint(footer, situations.size());
+   for (size_t s = 0; s < situations.size(); ++s)
+   {
+      const FLUMORESituation& situation = situations[s];
+      putValue<unsigned char>(footer, static_cast<unsigned char>(situation.kind));
+      putValue<int32_t>(footer, situation.nlp);
+      putValue<unsigned char>(footer, situation.hasLocation ? 1 : 0);
+      putValue<double>(footer, situation.rw);
+      putValue<double>(footer, situation.hw);
+      for (int i = 0; i < 3; ++i)
+      {
+         putValue<double>(footer, situation.values[i]);
+      }
+      putValue<int32_t>(footer, situation.valueCount);
+   }
+
+   const vector<FLUMOREBlock>& blocks = parser.blocks();
+   putVarint(footer, blocks.size());
+   for (size_t b = 0; b < blocks.size(); ++b)
+   {
+      const FLUMOREBlock& block = blocks[b];
+      const Encoding& encoding = encodings_[b];
+      putValue<int32_t>(footer, block.timestamp);
+      putValue<int32_t>(footer, block.situation);
+      putValue<int32_t>(footer, block.count);
+      putValue<int32_t>(footer, block.id);
+      putValue<int32_t>(footer, block.version);
+      putValue<uint64_t>(footer, block.line);
+      putValue<uint64_t>(footer, encoding.offset);
+      putValue<uint64_t>(footer, encoding.storedSize);
+      putValue<uint64_t>(footer, encoding.encodedSize);
+      putValue<uint32_t>(footer, encoding.rows);
+      putValue<uint32_t>(footer, encoding.rejected);
+      putValue<unsigned char>(footer, encoding.compressed ? 1 : 0);
+      putValue<uint32_t>(footer, encoding.checksum);
+   }
+
+   putValue<uint32_t>(footer, checksum(&footer[0], &footer[0] + footer.size()));
+   putValue<uint64_t>(footer, size_);
+   footer.insert(footer.end(), kMagic, kMagic + 8);
+
+   bool ok = fwrite(&footer[0], 1, footer.size(), file_) == footer.size();
+   ok = (fclose(file_) == 0) && ok;
+   file_ = NULL;
+   size_ += footer.size();
+
+   // rename() doesn't replace an existing file everywhere.
+   remove(path.c_str());
+   if (!ok || rename((path + ".tmp").c_str(), path.c_str()) != 0)
+   {
+      remove((path + ".tmp").c_str());
+      const uint64_t written = size_;
+      clear();
+      size_ = written;
+      error_ = "Could not write " + path;
+      return false;
+   }
+   encodings_.clear();
+   return true;
+}
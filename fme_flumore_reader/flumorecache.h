@@ -0,0 +1,161 @@
+#ifndef FLUMORE_CACHE_H
+#define FLUMORE_CACHE_H
+/*=============================================================================
+
+   Name     : flumorecache.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMORECache
+
+=============================================================================*/
+
+#include "flumorearena.h"
+#include "flumoreparser.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// FLUMORECache
+//
+// A compact binary copy of a parsed dataset, so repeated runs skip the
+// text parser. The cache is written block by block while the reader
+// decodes the dataset and is only used while the size and modification
+// time of the dataset match.
+// Every column of a block is stored with its own encoding: ids as
+// varint deltas, decimal values as scaled integers with varint deltas
+// or zero runs, anything else as XOR of neighbouring doubles with their
+// bytes shuffled. With FLUMORE_WITH_ZSTD the encoded blocks are
+// compressed on top. Every block and the structure of the dataset
+// carry a CRC-32, so damage is found before its values are used.
+// Errors are reported by the return value; error() describes them.
+class FLUMORECache
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMORECache();
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   // Discards an unfinished cache file.
+   ~FLUMORECache();
+
+   // -----------------------------------------------------------------------
+   // cachePath()
+   // Where the cache of dataset is kept in directory. The name includes a
+   // hash of the full path, so datasets of the same name don't collide.
+   static string cachePath(const string& directory, const string& dataset);
+
+   // -----------------------------------------------------------------------
+   // open()
+   // Reads the cache at path. Fails if there is none, it is damaged or
+   // it doesn't match the current dataset. The dates are converted from
+   // the given time zone, as the parser would.
+   bool open(const string& path, const string& dataset, const FLUMORETimeZone& zone = FLUMORETimeZone());
+
+   // -----------------------------------------------------------------------
+   // decode()
+   // Decodes the rows of block index into columns and returns the number
+   // of rows the parser had rejected. Intermediate buffers are taken from
+   // scratch and may be dropped once the call returned. Fails if the
+   // block is damaged, columns are undefined then.
+   bool decode(size_t index, FLUMOREColumns& columns, size_t& rejected, FLUMOREArena& scratch) const;
+
+   // -----------------------------------------------------------------------
+   // create()
+   // Starts writing the cache of dataset to path. The blocks follow with
+   // addBlock() in the order of the parser, finish() completes the file.
+   bool create(const string& path, const string& dataset);
+
+   // -----------------------------------------------------------------------
+   // addBlock()
+   // Encodes and writes the decoded rows of the next block.
+   bool addBlock(const FLUMOREColumns& columns, size_t rejected);
+
+   // -----------------------------------------------------------------------
+   // finish()
+   // Writes the structure of the parsed dataset and moves the cache file
+   // into place. Every block of parser must have been added.
+   bool finish(const FLUMOREParser& parser);
+
+   // -----------------------------------------------------------------------
+   // clear()
+   // Releases the cache and discards an unfinished cache file.
+   void clear();
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   const FLUMOREPackageHeader& header() const { return header_; }
+   const vector<FLUMORETimestamp>& timestamps() const { return timestamps_; }
+   const vector<FLUMORESituation>& situations() const { return situations_; }
+   const vector<FLUMOREBlock>& blocks() const { return blocks_; }
+   bool writing() const { return file_ != NULL; }
+   uint64_t size() const { return size_; }
+   const string& error() const { return error_; }
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMORECache(const FLUMORECache&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMORECache &operator=(const FLUMORECache&);
+
+   //=====================================================================
+   // Where the encoded rows of a block are kept in the cache file.
+   struct Encoding
+   {
+      uint64_t offset;
+      uint64_t storedSize;
+      uint64_t encodedSize;
+      uint32_t rows;
+      uint32_t rejected;
+      bool compressed;
+      // CRC-32 of the stored bytes.
+      uint32_t checksum;
+   };
+
+   // Data members
+
+   // The content of an opened cache file.
+   vector<char> data_;
+
+   // The structure of the dataset, FLUMOREBlock::begin and end are not
+   // used. encodings_ has one entry per block.
+   FLUMOREPackageHeader header_;
+   vector<FLUMORETimestamp> timestamps_;
+   vector<FLUMORESituation> situations_;
+   vector<FLUMOREBlock> blocks_;
+   vector<Encoding> encodings_;
+
+   // While writing: the temporary file, its final path, the size and
+   // modification time of the dataset, the encoded and compressed
+   // block and the intermediates of encoding it.
+   FILE* file_;
+   string path_;
+   uint64_t datasetSize_;
+   int64_t datasetTime_;
+   vector<char> encoded_;
+   vector<char> compressed_;
+   FLUMOREArena scratch_;
+
+   // Bytes of the cache file read or written.
+   uint64_t size_;
+
+   // Describes why the last operation failed.
+   string error_;
+};
+
+#endif
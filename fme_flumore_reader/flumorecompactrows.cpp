@@ -0,0 +1,339 @@
+/*=============================================================================
+
+   Name     : flumorecompactrows.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMORECompactRows method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorecompactrows.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const size_t FLUMORECompactRows::kColumns;
+
+namespace
+{
+   // The scale of columns kept as doubles.
+   const int8_t kDoubleScale = -1;
+
+   // The largest scale tried for decimal columns, and the largest
+   // integer every double between 0 and it represents exactly.
+   const int kMaxScale = 9;
+   const double kPowersOfTen[kMaxScale + 1] =
+   {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+   };
+   const double kMaxExactInteger = 9007199254740992.0;
+
+   //------------------------------------------------------------------------
+   // Whether value * 10^scale is an integer which converts back to
+   // exactly value, returned in scaled.
+   inline bool scaleValue(double value, int scale, int64_t& scaled)
+   {
+      const double power = kPowersOfTen[scale];
+      const double rounded = std::floor(value * power + 0.5);
+      if (!(std::fabs(rounded) < kMaxExactInteger) || rounded / power != value ||
+          (value == 0.0 && std::signbit(value)))
+      {
+         return false;
+      }
+      scaled = int64_t(rounded);
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Finds the scale of the values and converts them into scaled. The
+   // scale grows with the first value needing more fraction digits; as
+   // the values before may not stay exact at the larger scale, they are
+   // converted again with the final one.
+   bool scaleValues(const vector<double>& values, vector<int64_t>& scaled, int& scale)
+   {
+      const size_t rows = values.size();
+      scale = 0;
+      size_t converted = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+         while (!scaleValue(values[i], scale, scaled[i]))
+         {
+            if (++scale > kMaxScale)
+            {
+               return false;
+            }
+            converted = i;
+         }
+      }
+      for (size_t i = 0; i < converted; ++i)
+      {
+         if (!scaleValue(values[i], scale, scaled[i]))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // The bytes needed for every value - base of values.
+   uint8_t widthOf(const vector<int64_t>& values, int64_t& base)
+   {
+      if (values.empty())
+      {
+         base = 0;
+         return 0;
+      }
+      int64_t low = values[0];
+      int64_t high = values[0];
+      for (size_t i = 1; i < values.size(); ++i)
+      {
+         low = std::min(low, values[i]);
+         high = std::max(high, values[i]);
+      }
+      base = low;
+      const uint64_t range = uint64_t(high) - uint64_t(low);
+      return range == 0 ? 0 : range <= 0xff ? 1 : range <= 0xffff ? 2 : range <= 0xffffffffULL ? 4 : 8;
+   }
+
+   //------------------------------------------------------------------------
+   template <typename U>
+   void storeDeltas(char* out, const vector<int64_t>& values, int64_t base)
+   {
+      for (size_t i = 0; i < values.size(); ++i)
+      {
+         const U delta = U(uint64_t(values[i]) - uint64_t(base));
+         memcpy(out + i * sizeof(U), &delta, sizeof(U));
+      }
+   }
+
+   //------------------------------------------------------------------------
+   void storeDeltas(char* out, uint8_t width, const vector<int64_t>& values, int64_t base)
+   {
+      switch (width)
+      {
+      case 1: storeDeltas<uint8_t>(out, values, base); break;
+      case 2: storeDeltas<uint16_t>(out, values, base); break;
+      case 4: storeDeltas<uint32_t>(out, values, base); break;
+      case 8: storeDeltas<uint64_t>(out, values, base); break;
+      default: break;
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // The value at index of a column of width bytes, relative to its base.
+   inline uint64_t loadDelta(const char* p, uint8_t width, size_t index)
+   {
+      switch (width)
+      {
+      case 1: { uint8_t v; memcpy(&v, p + index, 1); return v; }
+      case 2: { uint16_t v; memcpy(&v, p + 2 * index, 2); return v; }
+      case 4: { uint32_t v; memcpy(&v, p + 4 * index, 4); return v; }
+      case 8: { uint64_t v; memcpy(&v, p + 8 * index, 8); return v; }
+      default: return 0;
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // Calls f(i, value - base) for all values of a column of U.
+   template <typename U, typename F>
+   void forEachDelta(const char* p, size_t rows, F f)
+   {
+      for (size_t i = 0; i < rows; ++i)
+      {
+         U delta;
+         memcpy(&delta, p + i * sizeof(U), sizeof(U));
+         f(i, uint64_t(delta));
+      }
+   }
+
+   //------------------------------------------------------------------------
+   template <typename F>
+   void forEachDelta(const char* p, uint8_t width, size_t rows, F f)
+   {
+      switch (width)
+      {
+      case 0:
+         for (size_t i = 0; i < rows; ++i)
+         {
+            f(i, uint64_t(0));
+         }
+         break;
+      case 1: forEachDelta<uint8_t>(p, rows, f); break;
+      case 2: forEachDelta<uint16_t>(p, rows, f); break;
+      case 4: forEachDelta<uint32_t>(p, rows, f); break;
+      default: forEachDelta<uint64_t>(p, rows, f); break;
+      }
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMORECompactRows::FLUMORECompactRows()
+:
+   rows_(0),
+   dataSize_(0)
+{
+   memset(columns_, 0, sizeof(columns_));
+}
+
+//===========================================================================
+// Clear
+void FLUMORECompactRows::clear()
+{
+   memset(columns_, 0, sizeof(columns_));
+   rows_ = 0;
+   dataSize_ = 0;
+   vector<char>().swap(data_);
+}
+
+//===========================================================================
+// Release
+void FLUMORECompactRows::release()
+{
+   vector<char>().swap(data_);
+}
+
+//===========================================================================
+// Pack
+void FLUMORECompactRows::pack(const FLUMOREColumns& columns)
+{
+   rows_ = columns.size();
+   const vector<double>* const values[kColumns - 1] =
+   {
+      &columns.x, &columns.y, &columns.z, &columns.wsp, &columns.h, &columns.vres
+   };
+
+   // The integers of every column are kept until the size is known.
+   vector<int64_t> scaled[kColumns];
+   scaled[0].resize(rows_);
+   for (size_t i = 0; i < rows_; ++i)
+   {
+      scaled[0][i] = int64_t(columns.id[i]) - int64_t(i);
+   }
+   columns_[0].scale = 0;
+   columns_[0].width = widthOf(scaled[0], columns_[0].base);
+
+   for (size_t c = 1; c < kColumns; ++c)
+   {
+      Column& column = columns_[c];
+      scaled[c].resize(rows_);
+      int scale = 0;
+      if (scaleValues(*values[c - 1], scaled[c], scale))
+      {
+         column.scale = int8_t(scale);
+         column.width = widthOf(scaled[c], column.base);
+      }
+      else
+      {
+         column.scale = kDoubleScale;
+         column.width = sizeof(double);
+         column.base = 0;
+      }
+   }
+
+   dataSize_ = 0;
+   for (size_t c = 0; c < kColumns; ++c)
+   {
+      columns_[c].offset = dataSize_;
+      dataSize_ += rows_ * columns_[c].width;
+   }
+   // Exactly as large as needed, the rows may be held for long.
+   vector<char>(dataSize_).swap(data_);
+   if (rows_ == 0)
+   {
+      return;
+   }
+
+   for (size_t c = 0; c < kColumns; ++c)
+   {
+      const Column& column = columns_[c];
+      char* const out = data_.empty() ? NULL : &data_[column.offset];
+      if (column.scale == kDoubleScale)
+      {
+         memcpy(out, &(*values[c - 1])[0], rows_ * sizeof(double));
+      }
+      else
+      {
+         storeDeltas(out, column.width, scaled[c], column.base);
+      }
+   }
+}
+
+//===========================================================================
+// Unpack
+void FLUMORECompactRows::unpack(FLUMOREColumns& columns) const
+{
+   unpack(data(), columns);
+}
+
+//===========================================================================
+// Unpack
+void FLUMORECompactRows::unpack(const char* data, FLUMOREColumns& columns) const
+{
+   const size_t start = columns.size();
+   if (rows_ == 0)
+   {
+      return;
+   }
+   vector<double>* const values[kColumns - 1] =
+   {
+      &columns.x, &columns.y, &columns.z, &columns.wsp, &columns.h, &columns.vres
+   };
+
+   columns.id.resize(start + rows_);
+   int32_t* const ids = &columns.id[0] + start;
+   const int64_t idBase = columns_[0].base;
+   forEachDelta(data + columns_[0].offset, columns_[0].width, rows_,
+                [ids, idBase](size_t i, uint64_t delta)
+                {
+                   ids[i] = int32_t(idBase + int64_t(delta) + int64_t(i));
+                });
+
+   for (size_t c = 1; c < kColumns; ++c)
+   {
+      const Column& column = columns_[c];
+      values[c - 1]->resize(start + rows_);
+      double* const out = &(*values[c - 1])[0] + start;
+      const char* const p = data + column.offset;
+      if (column.scale == kDoubleScale)
+      {
+         memcpy(out, p, rows_ * sizeof(double));
+         continue;
+      }
+      const int64_t base = column.base;
+      const double power = kPowersOfTen[column.scale];
+      forEachDelta(p, column.width, rows_,
+                   [out, base, power](size_t i, uint64_t delta)
+                   {
+                      out[i] = double(base + int64_t(delta)) / power;
+                   });
+   }
+}
+
+//===========================================================================
+// Row
+void FLUMORECompactRows::row(size_t index, int32_t& id, double* values) const
+{
+   const char* const p = data();
+   id = int32_t(columns_[0].base + int64_t(loadDelta(p + columns_[0].offset, columns_[0].width, index)) +
+                int64_t(index));
+   for (size_t c = 1; c < kColumns; ++c)
+   {
+      const Column& column = columns_[c];
+      if (column.scale == kDoubleScale)
+      {
+         memcpy(&values[c - 1], p + column.offset + index * sizeof(double), sizeof(double));
+      }
+      else
+      {
+         values[c - 1] = double(column.base + int64_t(loadDelta(p + column.offset, column.width, index))) /
+                         kPowersOfTen[column.scale];
+      }
+   }
+}
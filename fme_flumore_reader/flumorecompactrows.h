@@ -0,0 +1,107 @@
+#ifndef FLUMORE_COMPACT_ROWS_H
+#define FLUMORE_COMPACT_ROWS_H
+/*=============================================================================
+
+   Name     : flumorecompactrows.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMORECompactRows, decoded rows held in a
+              quantized form
+
+=============================================================================*/
+
+#include "flumoreparser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// FLUMORECompactRows
+//
+// The rows of a block packed for modes which hold a whole run in
+// memory, about 20 bytes per row instead of the 52 of FLUMOREColumns.
+// Every column is stored as fixed width integers relative to the
+// smallest value of the column, the block origin, with as few bytes as
+// the range of the column needs: decimal values scaled by the number of
+// fraction digits the column has, ids as their difference to the row
+// number so consecutive ids take no bytes at all. Values without an
+// exact decimal form, e.g. the -0.0 of a sign, are kept as doubles.
+// Unpacking returns bitwise the same values; rows stay randomly
+// accessible with row().
+class FLUMORECompactRows
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMORECompactRows();
+
+   // -----------------------------------------------------------------------
+   // pack()
+   // Replaces the content by the rows of columns.
+   void pack(const FLUMOREColumns& columns);
+
+   // -----------------------------------------------------------------------
+   // unpack()
+   // Appends the rows to columns. The second form takes the packed values
+   // from data, e.g. after they were moved elsewhere with release().
+   void unpack(FLUMOREColumns& columns) const;
+   void unpack(const char* data, FLUMOREColumns& columns) const;
+
+   // -----------------------------------------------------------------------
+   // row()
+   // The id and the values x, y, z, wsp, h and vres of one row.
+   void row(size_t index, int32_t& id, double* values) const;
+
+   // -----------------------------------------------------------------------
+   // release()
+   // Frees the packed values and keeps how they are laid out, so they can
+   // be given to unpack() from elsewhere.
+   void release();
+
+   // -----------------------------------------------------------------------
+   // clear()
+   void clear();
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   // dataSize() are the bytes of the packed values, bytes() the memory
+   // held including the layout.
+   size_t size() const { return rows_; }
+   const char* data() const { return data_.empty() ? NULL : &data_[0]; }
+   size_t dataSize() const { return dataSize_; }
+   size_t bytes() const { return data_.capacity() + sizeof(*this); }
+
+   // The number of columns, the id followed by the six values.
+   static const size_t kColumns = 7;
+
+private:
+
+   //=====================================================================
+   // How a column is packed: id - row - base for the id column and
+   // value * 10^scale - base for the others, in width bytes each, or the
+   // bits of the doubles if scale is negative.
+   struct Column
+   {
+      int64_t base;
+      size_t offset;
+      uint8_t width;
+      int8_t scale;
+   };
+
+   // Data members
+
+   Column columns_[kColumns];
+   size_t rows_;
+   size_t dataSize_;
+   vector<char> data_;
+};
+
+#endif
@@ -0,0 +1,403 @@
+/*=============================================================================
+
+   Name     : flumoredecompressor.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREDecompressor method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumoredecompressor.h"
+#include "flumorethreadpool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+
+#ifdef FLUMORE_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FLUMORE_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+   //------------------------------------------------------------------------
+   bool endsWith(const string& text, const char* suffix)
+   {
+      const string end(suffix);
+      return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+   }
+
+#if defined(FLUMORE_WITH_ZLIB) || defined(FLUMORE_WITH_ZSTD)
+   // A stream unpacks into pieces of this size at a time.
+   const size_t kStreamStep = 1 << 30;
+
+   //=====================================================================
+   // An independently compressed part of the input and where its text
+   // goes in the output.
+   struct Piece
+   {
+      size_t input;
+      size_t inputSize;
+      size_t output;
+      size_t outputSize;
+      uint32_t crc;
+   };
+#endif
+
+#ifdef FLUMORE_WITH_ZLIB
+   //------------------------------------------------------------------------
+   uint32_t littleEndian16(const unsigned char* p)
+   {
+      return uint32_t(p[0]) | (uint32_t(p[1]) << 8);
+   }
+
+   //------------------------------------------------------------------------
+   uint32_t littleEndian32(const unsigned char* p)
+   {
+      return littleEndian16(p) | (littleEndian16(p + 2) << 16);
+   }
+
+   //------------------------------------------------------------------------
+   // Splits a bgzip file into its members. Fails for any other gzip file,
+   // whose members can only be found by unpacking them.
+   bool bgzfPieces(const vector<char>& data, vector<Piece>& pieces, size_t& total)
+   {
+      const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(data.data());
+      const size_t size = data.size();
+      total = 0;
+      size_t pos = 0;
+      while (pos < size)
+      {
+         // ID1 ID2 CM FLG MTIME XFL OS XLEN, bgzip sets FEXTRA only.
+         if (size - pos < 18 || bytes[pos] != 0x1f || bytes[pos + 1] != 0x8b ||
+             bytes[pos + 2] != 8 || bytes[pos + 3] != 4)
+         {
+            return false;
+         }
+         const size_t extraLength = littleEndian16(bytes + pos + 10);
+         const size_t headerLength = 12 + extraLength;
+         if (size - pos < headerLength)
+         {
+            return false;
+         }
+
+         // The BC subfield holds the member size - 1.
+         size_t memberSize = 0;
+         for (size_t e = pos + 12; e + 4 <= pos + headerLength; )
+         {
+            const size_t fieldLength = littleEndian16(bytes + e + 2);
+            if (bytes[e] == 'B' && bytes[e + 1] == 'C' && fieldLength == 2 && e + 6 <= pos + headerLength)
+            {
+               memberSize = littleEndian16(bytes + e + 4) + 1;
+            }
+            e += 4 + fieldLength;
+         }
+         if (memberSize < headerLength + 8 || memberSize > size - pos)
+         {
+            return false;
+         }
+
+         Piece piece;
+         piece.input = pos + headerLength;
+         piece.inputSize = memberSize - headerLength - 8;
+         piece.output = total;
+         piece.outputSize = littleEndian32(bytes + pos + memberSize - 4);
+         piece.crc = littleEndian32(bytes + pos + memberSize - 8);
+         pieces.push_back(piece);
+         total += piece.outputSize;
+         pos += memberSize;
+      }
+      return !pieces.empty();
+   }
+
+   //------------------------------------------------------------------------
+   // Unpacks the raw deflate data of one bgzip member.
+   bool inflatePiece(const vector<char>& data, const Piece& piece, vector<char>& text)
+   {
+      char empty = 0;
+      z_stream stream = z_stream();
+      if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+      {
+         return false;
+      }
+      stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + piece.input));
+      stream.avail_in = uInt(piece.inputSize);
+      stream.next_out = reinterpret_cast<Bytef*>(piece.outputSize > 0 ? &text[piece.output] : &empty);
+      stream.avail_out = uInt(piece.outputSize);
+      const int result = inflate(&stream, Z_FINISH);
+      const bool ok = result == Z_STREAM_END && stream.total_out == piece.outputSize;
+      inflateEnd(&stream);
+      return ok &&
+             crc32(0L, reinterpret_cast<const Bytef*>(text.data() + piece.output), uInt(piece.outputSize)) == piece.crc;
+   }
+
+   //------------------------------------------------------------------------
+   // Unpacks any gzip file, also several members written one after the
+   // other.
+   bool inflateStream(const vector<char>& data, vector<char>& text, string& error)
+   {
+      z_stream stream = z_stream();
+      if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK)
+      {
+         error = "Could not initialize zlib";
+         return false;
+      }
+
+      text.resize(std::max(data.size() * 4, size_t(1) << 20));
+      size_t in = 0;
+      size_t out = 0;
+      bool ok = true;
+      for (;;)
+      {
+         if (stream.avail_in == 0)
+         {
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + in));
+            stream.avail_in = uInt(std::min(data.size() - in, kStreamStep));
+            in += stream.avail_in;
+         }
+         if (out == text.size())
+         {
+            text.resize(text.size() * 2);
+         }
+         const size_t room = std::min(text.size() - out, kStreamStep);
+         stream.next_out = reinterpret_cast<Bytef*>(&text[out]);
+         stream.avail_out = uInt(room);
+
+         const int result = inflate(&stream, Z_NO_FLUSH);
+         out += room - stream.avail_out;
+         if (result == Z_STREAM_END)
+         {
+            // Another member may follow, anything else is ignored like
+            // gzip does with trailing garbage.
+            const size_t left = stream.avail_in + (data.size() - in);
+            const size_t next = data.size() - left;
+            if (left < 2 || data[next] != '\x1f' || data[next + 1] != '\x8b')
+            {
+               break;
+            }
+            inflateReset(&stream);
+         }
+         else if (result == Z_BUF_ERROR && stream.avail_in == 0 && in == data.size())
+         {
+            error = "The gzip data is truncated";
+            ok = false;
+            break;
+         }
+         else if (result != Z_OK && result != Z_BUF_ERROR)
+         {
+            error = "The gzip data is damaged";
+            ok = false;
+            break;
+         }
+      }
+      inflateEnd(&stream);
+      text.resize(ok ? out : 0);
+      return ok;
+   }
+
+   //------------------------------------------------------------------------
+   bool decompressGzip(const vector<char>& data, vector<char>& text, size_t threads, string& error)
+   {
+      vector<Piece> pieces;
+      size_t total = 0;
+      if (!bgzfPieces(data, pieces, total))
+      {
+         return inflateStream(data, text, error);
+      }
+
+      text.resize(total);
+      const bool ok = FLUMOREThreadPool::forEach(pieces.size(), threads, [&](size_t i)
+      {
+         return inflatePiece(data, pieces[i], text);
+      });
+      if (!ok)
+      {
+         text.clear();
+         error = "The bgzip data is damaged";
+      }
+      return ok;
+   }
+#endif
+
+#ifdef FLUMORE_WITH_ZSTD
+   //------------------------------------------------------------------------
+   // Splits the data into its frames. Fails if a frame doesn't record its
+   // content size, the frames have to be unpacked in one stream then.
+   bool zstdPieces(const vector<char>& data, vector<Piece>& pieces, size_t& total)
+   {
+      total = 0;
+      size_t pos = 0;
+      while (pos < data.size())
+      {
+         const size_t frameSize = ZSTD_findFrameCompressedSize(data.data() + pos, data.size() - pos);
+         if (ZSTD_isError(frameSize))
+         {
+            return false;
+         }
+         const unsigned long long contentSize = ZSTD_getFrameContentSize(data.data() + pos, frameSize);
+         if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR)
+         {
+            return false;
+         }
+
+         Piece piece;
+         piece.input = pos;
+         piece.inputSize = frameSize;
+         piece.output = total;
+         piece.outputSize = size_t(contentSize);
+         piece.crc = 0;
+         pieces.push_back(piece);
+         total += piece.outputSize;
+         pos += frameSize;
+      }
+      return !pieces.empty();
+   }
+
+   //------------------------------------------------------------------------
+   bool decompressStream(const vector<char>& data, vector<char>& text, string& error)
+   {
+      ZSTD_DStream* stream = ZSTD_createDStream();
+      if (stream == NULL)
+      {
+         error = "Could not initialize zstd";
+         return false;
+      }
+
+      text.resize(std::max(data.size() * 4, size_t(1) << 20));
+      ZSTD_inBuffer input = { data.data(), data.size(), 0 };
+      size_t out = 0;
+      size_t result = 0;
+      bool ok = true;
+      while (input.pos < input.size)
+      {
+         if (out == text.size())
+         {
+            text.resize(text.size() * 2);
+         }
+         ZSTD_outBuffer output = { &text[out], text.size() - out, 0 };
+         result = ZSTD_decompressStream(stream, &output, &input);
+         out += output.pos;
+         if (ZSTD_isError(result))
+         {
+            error = string("The zstd data is damaged: ") + ZSTD_getErrorName(result);
+            ok = false;
+            break;
+         }
+      }
+      // Flush what the decoder still holds.
+      while (ok && result != 0)
+      {
+         if (out == text.size())
+         {
+            text.resize(text.size() * 2);
+         }
+         ZSTD_outBuffer output = { &text[out], text.size() - out, 0 };
+         result = ZSTD_decompressStream(stream, &output, &input);
+         out += output.pos;
+         if (ZSTD_isError(result) || (output.pos == 0 && output.size > 0))
+         {
+            error = "The zstd data is truncated";
+            ok = false;
+         }
+      }
+      ZSTD_freeDStream(stream);
+      text.resize(ok ? out : 0);
+      return ok;
+   }
+
+   //------------------------------------------------------------------------
+   bool decompressZstd(const vector<char>& data, vector<char>& text, size_t threads, string& error)
+   {
+      vector<Piece> pieces;
+      size_t total = 0;
+      if (!zstdPieces(data, pieces, total))
+      {
+         return decompressStream(data, text, error);
+      }
+
+      text.resize(total);
+      const bool ok = FLUMOREThreadPool::forEach(pieces.size(), threads, [&](size_t i)
+      {
+         const Piece& piece = pieces[i];
+         ZSTD_DCtx* context = ZSTD_createDCtx();
+         if (context == NULL)
+         {
+            return false;
+         }
+         const size_t written = ZSTD_decompressDCtx(context, text.data() + piece.output, piece.outputSize,
+                                                    data.data() + piece.input, piece.inputSize);
+         ZSTD_freeDCtx(context);
+         return !ZSTD_isError(written) && written == piece.outputSize;
+      });
+      if (!ok)
+      {
+         text.clear();
+         error = "The zstd data is damaged";
+      }
+      return ok;
+   }
+#endif
+}
+
+//===========================================================================
+// Detect
+FLUMORECompression FLUMOREDecompressor::detect(const char* data, size_t size)
+{
+   const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(data);
+   if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b)
+   {
+      return kFLUMORECompressionGzip;
+   }
+   if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd)
+   {
+      return kFLUMORECompressionZstd;
+   }
+   return kFLUMORECompressionNone;
+}
+
+//===========================================================================
+// Compressed Name
+bool FLUMOREDecompressor::compressedName(const string& path)
+{
+   return endsWith(path, ".gz") || endsWith(path, ".GZ") || endsWith(path, ".zst") || endsWith(path, ".ZST");
+}
+
+//===========================================================================
+// Decompress
+bool FLUMOREDecompressor::decompress(const vector<char>& data, vector<char>& text, size_t threads, string& error)
+{
+   const FLUMORECompression compression = detect(data.data(), data.size());
+   text.clear();
+   if (threads == 0)
+   {
+      threads = FLUMOREThreadPool::defaultThreads();
+   }
+   if (compression == kFLUMORECompressionGzip)
+   {
+#ifdef FLUMORE_WITH_ZLIB
+      return decompressGzip(data, text, threads, error);
+#else
+      error = "This build can't read gzip files, it was built without FLUMORE_WITH_ZLIB";
+      return false;
+#endif
+   }
+   if (compression == kFLUMORECompressionZstd)
+   {
+#ifdef FLUMORE_WITH_ZSTD
+      return decompressZstd(data, text, threads, error);
+#else
+      error = "This build can't read zstd files, it was built without FLUMORE_WITH_ZSTD";
+      return false;
+#endif
+   }
+   error = "The data is not compressed";
+   return false;
+}
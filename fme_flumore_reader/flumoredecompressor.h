@@ -0,0 +1,71 @@
+#ifndef FLUMORE_DECOMPRESSOR_H
+#define FLUMORE_DECOMPRESSOR_H
+/*=============================================================================
+
+   Name     : flumoredecompressor.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREDecompressor, gzip and zstd input for
+              the native parser
+
+=============================================================================*/
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// The compression of a dataset, recognized by its first bytes.
+enum FLUMORECompression
+{
+   kFLUMORECompressionNone = 0,
+   kFLUMORECompressionGzip,
+   kFLUMORECompressionZstd
+};
+
+//=====================================================================
+// FLUMOREDecompressor
+//
+// Unpacks compressed FLUMORE files in memory, so the parser can read an
+// archived delivery without a temporary copy. Files made of independent
+// pieces whose sizes are known up front are unpacked in parallel: gzip
+// written by bgzip, whose members carry their compressed size, and zstd
+// with several frames carrying their content size. Everything else is
+// unpacked in one stream.
+// The formats are only available if the build defines FLUMORE_WITH_ZLIB
+// and FLUMORE_WITH_ZSTD and links the libraries.
+class FLUMOREDecompressor
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // detect()
+   // The compression of data by its magic number.
+   static FLUMORECompression detect(const char* data, size_t size);
+
+   // -----------------------------------------------------------------------
+   // compressedName()
+   // Whether the path ends in .gz or .zst.
+   static bool compressedName(const string& path);
+
+   // -----------------------------------------------------------------------
+   // decompress()
+   // Unpacks the gzip or zstd data into text using up to threads
+   // threads, those of the shared pool if it is 0. Returns false and sets
+   // error if the data is damaged or the compression is not available.
+   static bool decompress(const vector<char>& data, vector<char>& text, size_t threads, string& error);
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREDecompressor();
+};
+
+#endif
@@ -99,6 +99,17 @@ FME_DLLEXPORT_C const char* FME_apiVersion()
    return kFMEDevKitVersion;
 }
 
+namespace fs = std::experimental::filesystem;
+void setMonoRuntimePaths() {
+    wchar_t full_path[MAX_PATH];
+    GetModuleFileNameW(NULL, full_path, MAX_PATH);
+    auto workingPath = fs::path(full_path).remove_filename();
+    auto runtimeAssemblyPath = workingPath / fs::path("plugins/flumore_importer_plugin/lib");
+    auto assemblyPath = workingPath / fs::path("plugins/flumore_importer_plugin");
+    mono_embeddinator_set_runtime_assembly_path(runtimeAssemblyPath.generic_string().c_str());
+    mono_embeddinator_set_assembly_path(assemblyPath.generic_string().c_str());
+}
+
 //=====================================================================
 // This method is called by the FME to initialize the plug-in.
 //
@@ -115,18 +126,11 @@ FME_DLLEXPORT_C FME_MsgNum FME_initialize(IFMEServiceManager& serviceManager)
       char* locale = setlocale(LC_CTYPE, codePageString.c_str());
    #endif
 
-   return FME_SUCCESS;
-}
+   // Only tells Mono where its runtime is, the first reader using the
+   // F# parser starts it.
+   setMonoRuntimePaths();
 
-namespace fs = std::experimental::filesystem;
-void setMonoRuntimePaths() {
-    wchar_t full_path[MAX_PATH];
-    GetModuleFileNameW(NULL, full_path, MAX_PATH);
-    auto workingPath = fs::path(full_path).remove_filename();
-    auto runtimeAssemblyPath = workingPath / fs::path("plugins/flumore_importer_plugin/lib");
-    auto assemblyPath = workingPath / fs::path("plugins/flumore_importer_plugin");
-    mono_embeddinator_set_runtime_assembly_path(runtimeAssemblyPath.generic_string().c_str());
-    mono_embeddinator_set_assembly_path(assemblyPath.generic_string().c_str());
+   return FME_SUCCESS;
 }
 
 // --------------------------------------------------------------------
@@ -149,13 +153,11 @@ FME_DLLEXPORT_C FME_MsgNum FME_createReader( IFMELogFile& logFile,
                                        const char* readerTypeName,
                                        const char* readerKeyword )
 {
-    setMonoRuntimePaths();
    reader = new FLUMOREReader(readerTypeName, readerKeyword);
    
    FLUMOREReader::gLogFile      = &logFile;     // create pointer to log file
    FLUMOREReader::gMappingFile  = &mappingFile; // create pointer to mapping file
    FLUMOREReader::gCoordSysMan  = &coordSysMan; // create pointer to coordinate system manager
-   auto foo = Parser_foo();
 
    return FME_SUCCESS;
 }
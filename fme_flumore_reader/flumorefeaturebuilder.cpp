@@ -0,0 +1,283 @@
+/*=============================================================================
+
+   Name     : flumorefeaturebuilder.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREFeatureBuilder method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorefeaturebuilder.h"
+#include "flumorepriv.h"
+
+#include <ifeature.h>
+#include <isession.h>
+#include <cstring>
+
+namespace
+{
+   // Names of the timestamp kinds in FLUMORETimestampKind order.
+   const char* const kTimestampKinds[] = { "SIM", "VHS", "SZO" };
+
+   // Names of the situation kinds in FLUMORESituationKind order.
+   const char* const kSituationKinds[] =
+   {
+      "Ueberstr.", "Bresche", "Deichentl.", "Folgebruch", "Innere Entl.", "Linien-SM", "Punkt-SM"
+   };
+
+   // Attributes of the situation values in their order.
+   const char* const kSituationValues[] =
+   {
+      kAttrSituationValue1, kAttrSituationValue2, kAttrSituationValue3
+   };
+
+   //------------------------------------------------------------------------
+   bool sameSituation(const FLUMORESituation& a, const FLUMORESituation& b)
+   {
+      if (a.kind != b.kind || a.nlp != b.nlp || a.hasLocation != b.hasLocation ||
+          a.valueCount != b.valueCount)
+      {
+         return false;
+      }
+      if (a.hasLocation && (a.rw != b.rw || a.hw != b.hw))
+      {
+         return false;
+      }
+      for (int32_t i = 0; i < a.valueCount; ++i)
+      {
+         if (a.values[i] != b.values[i])
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMOREFeatureBuilder::FLUMOREFeatureBuilder()
+:
+   session_(NULL),
+   template_(NULL),
+   coordSys_(""),
+   structureAttributes_(false),
+   date_(""),
+   timestampKind_(-1),
+   hasSituation_(false),
+   situation_(),
+   teilbereich_(-1),
+   version_(0)
+{
+}
+
+//===========================================================================
+// Destructor
+FLUMOREFeatureBuilder::~FLUMOREFeatureBuilder()
+{
+   close();
+}
+
+//===========================================================================
+// Open
+void FLUMOREFeatureBuilder::open(IFMESession* session)
+{
+   close();
+   session_ = session;
+   if (session_)
+   {
+      template_ = session_->createFeature();
+      resetTemplate();
+   }
+}
+
+//===========================================================================
+// Close
+void FLUMOREFeatureBuilder::close()
+{
+   if (template_)
+   {
+      session_->destroyFeature(template_);
+      template_ = NULL;
+   }
+   session_ = NULL;
+   date_.clear();
+   timestampKind_ = -1;
+   hasSituation_ = false;
+   teilbereich_ = -1;
+   version_ = 0;
+}
+
+//===========================================================================
+// Set Coord Sys
+void FLUMOREFeatureBuilder::setCoordSys(const char* coordSys)
+{
+   coordSys_ = coordSys ? coordSys : "";
+   if (template_)
+   {
+      template_->setCoordSys(coordSys_.c_str());
+   }
+}
+
+//===========================================================================
+// Set Structure Attributes
+void FLUMOREFeatureBuilder::setStructureAttributes(bool enabled)
+{
+   if (structureAttributes_ != enabled)
+   {
+      structureAttributes_ = enabled;
+      if (template_)
+      {
+         resetTemplate();
+      }
+   }
+}
+
+//===========================================================================
+// Begin Block
+void FLUMOREFeatureBuilder::beginBlock(const FLUMORETimestamp* timestamp, const FLUMORESituation* situation,
+                                       const FLUMOREBlock& block)
+{
+   const char* const date = timestamp ? timestamp->fmeDate.c_str() : "";
+   const int32_t timestampKind = timestamp ? int32_t(timestamp->kind) : -1;
+   const bool sameStructure =
+      timestampKind_ == timestampKind &&
+      hasSituation_ == (situation != NULL) && (!situation || sameSituation(situation_, *situation)) &&
+      teilbereich_ == block.id && version_ == block.version;
+   const bool sameDate = strcmp(date_.c_str(), date) == 0;
+   if (sameDate && sameStructure)
+   {
+      // Consecutive blocks with the same constants share the template.
+      return;
+   }
+   const bool reset = !sameDate || structureAttributes_;
+   date_ = date;
+   timestampKind_ = timestampKind;
+   hasSituation_ = (situation != NULL);
+   if (situation)
+   {
+      situation_ = *situation;
+   }
+   teilbereich_ = block.id;
+   version_ = block.version;
+   if (template_ && reset)
+   {
+      // Attributes of the previous block may not apply to this one.
+      resetTemplate();
+   }
+}
+
+//===========================================================================
+// Begin Block
+void FLUMOREFeatureBuilder::beginBlock(const char* date)
+{
+   if (date == NULL)
+   {
+      date = "";
+   }
+   if (strcmp(date_.c_str(), date) == 0 && timestampKind_ < 0 && !hasSituation_ && teilbereich_ < 0)
+   {
+      // Consecutive blocks of the same timestep share the template as is.
+      return;
+   }
+   const bool dateOnly = (timestampKind_ < 0 && !hasSituation_ && teilbereich_ < 0);
+   date_ = date;
+   timestampKind_ = -1;
+   hasSituation_ = false;
+   teilbereich_ = -1;
+   version_ = 0;
+   if (template_)
+   {
+      if (dateOnly)
+      {
+         template_->setAttribute(kAttrDate, date_.c_str());
+      }
+      else
+      {
+         resetTemplate();
+      }
+   }
+}
+
+//===========================================================================
+// Reset Template
+void FLUMOREFeatureBuilder::resetTemplate()
+{
+   // The row values come first so that overwriting them per row finds
+   // them without passing the block constants.
+   template_->resetFeature();
+   const char* const rowAttributes[] = { kAttrId, kAttrH, kAttrVres, kAttrWsp, kAttrX, kAttrY, kAttrZ };
+   template_->setAttribute(rowAttributes[0], FME_Int32(0));
+   for (size_t i = 1; i < sizeof(rowAttributes) / sizeof(rowAttributes[0]); ++i)
+   {
+      template_->setAttribute(rowAttributes[i], FME_Real64(0.0));
+   }
+   setBlockAttributes(*template_);
+}
+
+//===========================================================================
+// Set Block Attributes
+void FLUMOREFeatureBuilder::setBlockAttributes(IFMEFeature& feature) const
+{
+   feature.setFeatureType(kFeatureTypeFLUMORE);
+   if (!coordSys_.empty())
+   {
+      feature.setCoordSys(coordSys_.c_str());
+   }
+   feature.setAttribute(kAttrDate, date_.c_str());
+   if (!structureAttributes_)
+   {
+      return;
+   }
+   if (timestampKind_ >= 0)
+   {
+      feature.setAttribute(kAttrTimestampKind, kTimestampKinds[timestampKind_]);
+   }
+   if (hasSituation_)
+   {
+      feature.setAttribute(kAttrSituationKind, kSituationKinds[situation_.kind]);
+      feature.setAttribute(kAttrSituationNlp, FME_Int32(situation_.nlp));
+      if (situation_.hasLocation)
+      {
+         feature.setAttribute(kAttrSituationRw, FME_Real64(situation_.rw));
+         feature.setAttribute(kAttrSituationHw, FME_Real64(situation_.hw));
+      }
+      for (int32_t i = 0; i < situation_.valueCount; ++i)
+      {
+         feature.setAttribute(kSituationValues[i], FME_Real64(situation_.values[i]));
+      }
+   }
+   if (teilbereich_ >= 0)
+   {
+      feature.setAttribute(kAttrTeilbereich, FME_Int32(teilbereich_));
+      feature.setAttribute(kAttrTeilbereichVersion, FME_Int32(version_));
+   }
+}
+
+//===========================================================================
+// Build
+void FLUMOREFeatureBuilder::build(IFMEFeature& feature, FME_Int32 id, FME_Real64 x,
+                                  FME_Real64 y, FME_Real64 z, FME_Real64 wsp,
+                                  FME_Real64 h, FME_Real64 vres) const
+{
+   if (template_)
+   {
+      template_->clone(feature);
+   }
+   else
+   {
+      setBlockAttributes(feature);
+   }
+
+   feature.setAttribute(kAttrId, id);
+   feature.setAttribute(kAttrH, h);
+   feature.setAttribute(kAttrVres, vres);
+   feature.setAttribute(kAttrWsp, wsp);
+   feature.setAttribute(kAttrX, x);
+   feature.setAttribute(kAttrY, y);
+   feature.setAttribute(kAttrZ, z);
+}
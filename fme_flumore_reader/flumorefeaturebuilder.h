@@ -0,0 +1,134 @@
+#ifndef FLUMORE_FEATURE_BUILDER_H
+#define FLUMORE_FEATURE_BUILDER_H
+/*=============================================================================
+
+   Name     : flumorefeaturebuilder.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREFeatureBuilder
+
+=============================================================================*/
+
+#include "flumoreparser.h"
+
+#include <fmetypes.h>
+#include <string>
+
+using namespace std;
+
+// Forward declarations
+class IFMEFeature;
+class IFMESession;
+
+//=====================================================================
+// FLUMOREFeatureBuilder
+//
+// Fills the features handed out by FLUMOREReader::read(). Everything
+// which is constant for a whole Teilbereich block (the feature type, the
+// date and, if asked for, the kind of the timestep, the situation and
+// the Teilbereich) is set once on a template feature, so per row only
+// the template is cloned and the seven numeric values are overwritten.
+// The attribute names are the interned constants from flumorepriv.h
+// instead of literals spread over the reader.
+class FLUMOREFeatureBuilder
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREFeatureBuilder();
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   ~FLUMOREFeatureBuilder();
+
+   // -----------------------------------------------------------------------
+   // open()
+   // Creates the template feature from the given session. Without a
+   // session the builder sets the block constants on every feature.
+   void open(IFMESession* session);
+
+   // -----------------------------------------------------------------------
+   // close()
+   // Releases the template feature.
+   void close();
+
+   // -----------------------------------------------------------------------
+   // setCoordSys()
+   // The coordinate system of all features, empty for none.
+   void setCoordSys(const char* coordSys);
+
+   // -----------------------------------------------------------------------
+   // setStructureAttributes()
+   // Whether the features get the flumore_* attributes of their block.
+   // Off by default, every row pays for copying them.
+   void setStructureAttributes(bool enabled);
+
+   // -----------------------------------------------------------------------
+   // beginBlock()
+   // Must be called before the first row of every Teilbereich block with
+   // its timestamp and situation, NULL if the block has none. The template
+   // is only touched if any of them differs from the previous block. The
+   // form taking the date alone is for the F# parser, which tells nothing
+   // else about the block; the flumore_* attributes are left unset then.
+   void beginBlock(const FLUMORETimestamp* timestamp, const FLUMORESituation* situation,
+                   const FLUMOREBlock& block);
+   void beginBlock(const char* date);
+
+   // -----------------------------------------------------------------------
+   // build()
+   // Fills the feature with the block constants and the values of one row.
+   void build(IFMEFeature& feature, FME_Int32 id, FME_Real64 x, FME_Real64 y,
+              FME_Real64 z, FME_Real64 wsp, FME_Real64 h, FME_Real64 vres) const;
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREFeatureBuilder(const FLUMOREFeatureBuilder&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREFeatureBuilder &operator=(const FLUMOREFeatureBuilder&);
+
+   // -----------------------------------------------------------------------
+   // resetTemplate()
+   // Fills the template anew for the current block.
+   void resetTemplate();
+
+   // -----------------------------------------------------------------------
+   // setBlockAttributes()
+   // Sets the feature type and the block constants on feature.
+   void setBlockAttributes(IFMEFeature& feature) const;
+
+   // Data members
+
+   // The session the template feature was created with.
+   IFMESession* session_;
+
+   // Holds the attributes shared by all rows of the current block.
+   IFMEFeature* template_;
+
+   // The coordinate system of the features.
+   string coordSys_;
+
+   // Set if the flumore_* attributes are set.
+   bool structureAttributes_;
+
+   // The date of the current block, formatted as yyyyMMddHHmmss.
+   string date_;
+
+   // The rest of the current block, as far as it is known. The kind is
+   // negative if there is no timestamp, the Teilbereich if it is unknown.
+   int32_t timestampKind_;
+   bool hasSituation_;
+   FLUMORESituation situation_;
+   int32_t teilbereich_;
+   int32_t version_;
+};
+
+#endif
@@ -0,0 +1,513 @@
+/*=============================================================================
+
+   Name     : flumorefilereader.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREFileReader method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorefilereader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#if defined(FLUMORE_WITH_URING) && defined(__linux__)
+#define FLUMORE_URING
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// The system call numbers are the same on all architectures, older C
+// libraries do not know them.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+
+const size_t FLUMOREFileReader::kDefaultQueueDepth;
+const size_t FLUMOREFileReader::kMaxQueueDepth;
+const size_t FLUMOREFileReader::kChunkSize;
+
+namespace
+{
+#ifdef FLUMORE_URING
+   // O_DIRECT needs buffers, offsets and sizes aligned to the logical
+   // block size, which is at most a page.
+   const size_t kDirectAlignment = 4096;
+
+   // kFLUMOREReadAuto reads smaller files buffered, they are likely to be
+   // in the page cache and the setup would not pay off.
+   const uint64_t kMinUringSize = uint64_t(64) << 20;
+
+   //------------------------------------------------------------------------
+   string systemError(const char* call, int error)
+   {
+      return string(call) + ": " + strerror(error);
+   }
+
+   //=====================================================================
+   // The submission and completion queues of an io_uring instance,
+   // mapped from the kernel.
+   class Ring
+   {
+   public:
+      Ring()
+      :
+         fd_(-1), sq_(MAP_FAILED), sqSize_(0), cq_(MAP_FAILED), cqSize_(0),
+         sqes_(MAP_FAILED), sqesSize_(0), queued_(0)
+      {
+      }
+
+      ~Ring()
+      {
+         if (sqes_ != MAP_FAILED)
+         {
+            munmap(sqes_, sqesSize_);
+         }
+         if (cq_ != MAP_FAILED && cq_ != sq_)
+         {
+            munmap(cq_, cqSize_);
+         }
+         if (sq_ != MAP_FAILED)
+         {
+            munmap(sq_, sqSize_);
+         }
+         if (fd_ >= 0)
+         {
+            close(fd_);
+         }
+      }
+
+      //---------------------------------------------------------------------
+      // Creates the instance with room for entries submissions.
+      bool setup(unsigned entries, string& error)
+      {
+         io_uring_params params;
+         memset(&params, 0, sizeof(params));
+         fd_ = int(syscall(__NR_io_uring_setup, entries, &params));
+         if (fd_ < 0)
+         {
+            error = systemError("io_uring_setup", errno);
+            return false;
+         }
+
+         sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+         cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+         const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+         if (single)
+         {
+            sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+         }
+         sq_ = mmap(NULL, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+         if (sq_ == MAP_FAILED)
+         {
+            error = systemError("mmap", errno);
+            return false;
+         }
+         cq_ = single ? sq_ : mmap(NULL, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                   fd_, IORING_OFF_CQ_RING);
+         sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+         sqes_ = (cq_ == MAP_FAILED) ? MAP_FAILED
+               : mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+         if (sqes_ == MAP_FAILED)
+         {
+            error = systemError("mmap", errno);
+            return false;
+         }
+
+         char* const sq = static_cast<char*>(sq_);
+         char* const cq = static_cast<char*>(cq_);
+         sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+         sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+         sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+         sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+         cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+         cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+         cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+         cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+         return true;
+      }
+
+      //---------------------------------------------------------------------
+      // Queues a read of size bytes at offset of file into target. user
+      // comes back with the completion.
+      void queueRead(int file, char* target, size_t size, uint64_t offset, uint64_t user)
+      {
+         const unsigned tail = *sqTail_ + queued_;
+         const unsigned index = tail & sqMask_;
+         io_uring_sqe& sqe = static_cast<io_uring_sqe*>(sqes_)[index];
+         memset(&sqe, 0, sizeof(sqe));
+         sqe.opcode = IORING_OP_READ;
+         sqe.fd = file;
+         sqe.addr = uint64_t(reinterpret_cast<uintptr_t>(target));
+         sqe.len = unsigned(size);
+         sqe.off = offset;
+         sqe.user_data = user;
+         sqArray_[index] = index;
+         ++queued_;
+      }
+
+      //---------------------------------------------------------------------
+      // Submits the queued reads and waits for at least one completion.
+      bool submitAndWait(string& error)
+      {
+         __atomic_store_n(sqTail_, *sqTail_ + queued_, __ATOMIC_RELEASE);
+         unsigned toSubmit = queued_;
+         queued_ = 0;
+         for (;;)
+         {
+            const long submitted = syscall(__NR_io_uring_enter, fd_, toSubmit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            if (submitted >= long(toSubmit))
+            {
+               return true;
+            }
+            if (submitted >= 0)
+            {
+               toSubmit -= unsigned(submitted);
+            }
+            else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+               error = systemError("io_uring_enter", errno);
+               return false;
+            }
+         }
+      }
+
+      //---------------------------------------------------------------------
+      // Waits for at least one completion without submitting anything.
+      bool wait(string& error)
+      {
+         for (;;)
+         {
+            if (syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) >= 0)
+            {
+               return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+               error = systemError("io_uring_enter", errno);
+               return false;
+            }
+         }
+      }
+
+      //---------------------------------------------------------------------
+      // The reads which are never read, nor completed, once submitAndWait()
+      // isn't called any more: the ones still queued and the ones the
+      // kernel did not take after it failed.
+      unsigned unsubmitted() const
+      {
+         return *sqTail_ + queued_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+      }
+
+      //---------------------------------------------------------------------
+      // Takes the next completion if there is one.
+      bool nextCompletion(uint64_t& user, int32_t& result)
+      {
+         const unsigned head = *cqHead_;
+         if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+         {
+            return false;
+         }
+         const io_uring_cqe& cqe = cqes_[head & cqMask_];
+         user = cqe.user_data;
+         result = cqe.res;
+         __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+         return true;
+      }
+
+   private:
+      Ring(const Ring&);
+      Ring& operator=(const Ring&);
+
+      int fd_;
+      void* sq_;
+      size_t sqSize_;
+      void* cq_;
+      size_t cqSize_;
+      void* sqes_;
+      size_t sqesSize_;
+      unsigned* sqHead_;
+      unsigned* sqTail_;
+      unsigned sqMask_;
+      unsigned* sqArray_;
+      unsigned* cqHead_;
+      unsigned* cqTail_;
+      unsigned cqMask_;
+      io_uring_cqe* cqes_;
+      // Submissions written but not yet made visible to the kernel.
+      unsigned queued_;
+   };
+
+   //=====================================================================
+   // Closes a file descriptor when leaving the scope.
+   struct FileDescriptor
+   {
+      explicit FileDescriptor(int descriptor) : fd(descriptor) {}
+      ~FileDescriptor() { if (fd >= 0) close(fd); }
+      int fd;
+   };
+
+   //=====================================================================
+   // A chunk in flight: the part of the file it reads and how much of it
+   // has arrived.
+   struct Chunk
+   {
+      uint64_t offset;
+      size_t size;
+      size_t done;
+   };
+#endif
+}
+
+//===========================================================================
+// Constructor
+FLUMOREFileReader::FLUMOREFileReader()
+:
+   method_(kFLUMOREReadAuto),
+   queueDepth_(kDefaultQueueDepth),
+   used_(kFLUMOREReadBuffered)
+{
+}
+
+//===========================================================================
+// Read
+bool FLUMOREFileReader::read(const string& path, vector<char>& data)
+{
+   error_.clear();
+   fallback_.clear();
+   data.clear();
+
+   if (method_ != kFLUMOREReadBuffered)
+   {
+#ifdef FLUMORE_URING
+      if (readUring(path, data))
+      {
+         used_ = kFLUMOREReadUring;
+         return true;
+      }
+#else
+      if (method_ == kFLUMOREReadUring)
+      {
+         fallback_ = "io_uring is not available in this build";
+      }
+#endif
+   }
+   used_ = kFLUMOREReadBuffered;
+   return readBuffered(path, data);
+}
+
+//===========================================================================
+// Read Buffered
+bool FLUMOREFileReader::readBuffered(const string& path, vector<char>& data)
+{
+   ifstream in(path.c_str(), ios::in | ios::binary);
+   if (!in)
+   {
+      error_ = "Could not open " + path;
+      return false;
+   }
+   in.seekg(0, ios::end);
+   const streamoff length = in.tellg();
+   in.seekg(0, ios::beg);
+   if (length < 0)
+   {
+      error_ = "Could not determine the size of " + path;
+      return false;
+   }
+
+   data.resize(size_t(length));
+   if (length > 0 && !in.read(&data[0], length))
+   {
+      data.clear();
+      error_ = "Could not read " + path;
+      return false;
+   }
+   return true;
+}
+
+//===========================================================================
+// Read Uring
+bool FLUMOREFileReader::readUring(const string& path, vector<char>& data)
+{
+#ifdef FLUMORE_URING
+   // Without O_DIRECT the chunks are read straight into data, with it
+   // through aligned buffers of their own.
+   FileDescriptor file(open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT));
+   const bool direct = file.fd >= 0;
+   if (!direct)
+   {
+      file.fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   }
+   struct stat status;
+   if (file.fd < 0 || fstat(file.fd, &status) != 0)
+   {
+      fallback_ = systemError("open", errno);
+      return false;
+   }
+   if (method_ == kFLUMOREReadAuto && uint64_t(status.st_size) < kMinUringSize)
+   {
+      return false;
+   }
+   data.resize(size_t(status.st_size));
+
+   Ring ring;
+   if (!ring.setup(unsigned(queueDepth_), fallback_))
+   {
+      return false;
+   }
+
+   unique_ptr<char[]> storage(direct ? new char[queueDepth_ * kChunkSize + kDirectAlignment] : NULL);
+   char* const aligned = direct
+      ? storage.get() + (kDirectAlignment - uintptr_t(storage.get()) % kDirectAlignment) % kDirectAlignment
+      : NULL;
+
+   vector<Chunk> chunks(queueDepth_);
+   vector<size_t> idle;
+   for (size_t i = queueDepth_; i > 0; --i)
+   {
+      idle.push_back(i - 1);
+   }
+   const auto queue = [&](size_t i)
+   {
+      const Chunk& chunk = chunks[i];
+      char* const target = direct ? aligned + i * kChunkSize + chunk.done : &data[0] + chunk.offset + chunk.done;
+      size_t size = chunk.size - chunk.done;
+      if (direct)
+      {
+         size = (size + kDirectAlignment - 1) / kDirectAlignment * kDirectAlignment;
+      }
+      ring.queueRead(file.fd, target, size, chunk.offset + chunk.done, uint64_t(i));
+   };
+
+   // After a failure the reads in flight still have to complete before
+   // their buffers may go, the ones the kernel didn't take and the short
+   // reads queued again before the failure never will.
+   bool ok = true;
+   uint64_t next = 0;
+   const uint64_t size = uint64_t(data.size());
+   while ((ok && next < size) || queueDepth_ - idle.size() > ring.unsubmitted())
+   {
+      while (ok && next < size && !idle.empty())
+      {
+         const size_t i = idle.back();
+         idle.pop_back();
+         chunks[i].offset = next;
+         chunks[i].size = size_t(std::min(uint64_t(kChunkSize), size - next));
+         chunks[i].done = 0;
+         queue(i);
+         next += chunks[i].size;
+      }
+      if (ok && !ring.submitAndWait(fallback_))
+      {
+         ok = false;
+         continue;
+      }
+      if (!ok)
+      {
+         string error;
+         if (!ring.wait(error))
+         {
+            // The kernel may still write into the buffers of the reads in
+            // flight, they are given up instead of being freed under them.
+            storage.release();
+            (new vector<char>())->swap(data);
+            return false;
+         }
+      }
+
+      uint64_t user = 0;
+      int32_t result = 0;
+      while (ring.nextCompletion(user, result))
+      {
+         const size_t i = size_t(user);
+         Chunk& chunk = chunks[i];
+         if (result <= 0 && ok)
+         {
+            ok = false;
+            fallback_ = (result == 0) ? path + " became shorter while it was read"
+                      : systemError(direct ? "read with O_DIRECT" : "read", -result);
+         }
+         if (ok)
+         {
+            chunk.done = std::min(chunk.size, chunk.done + size_t(result));
+         }
+         if (ok && chunk.done < chunk.size)
+         {
+            // A short read, the rest has to start aligned as well.
+            if (!direct || chunk.done % kDirectAlignment == 0)
+            {
+               queue(i);
+               continue;
+            }
+            ok = false;
+            fallback_ = "unaligned short read with O_DIRECT";
+         }
+         if (ok && direct)
+         {
+            memcpy(&data[0] + chunk.offset, aligned + i * kChunkSize, chunk.size);
+         }
+         idle.push_back(i);
+      }
+   }
+   return ok;
+#else
+   (void)path;
+   (void)data;
+   fallback_ = "io_uring is not available in this build";
+   return false;
+#endif
+}
+
+//===========================================================================
+// Parse Method
+bool FLUMOREFileReader::parseMethod(const string& name, FLUMOREReadMethod& method)
+{
+   if (name == "AUTO")
+   {
+      method = kFLUMOREReadAuto;
+   }
+   else if (name == "BUFFERED")
+   {
+      method = kFLUMOREReadBuffered;
+   }
+   else if (name == "URING")
+   {
+      method = kFLUMOREReadUring;
+   }
+   else
+   {
+      return false;
+   }
+   return true;
+}
+
+//===========================================================================
+// Method Name
+const char* FLUMOREFileReader::methodName(FLUMOREReadMethod method)
+{
+   switch (method)
+   {
+   case kFLUMOREReadBuffered:
+      return "BUFFERED";
+   case kFLUMOREReadUring:
+      return "URING";
+   default:
+      return "AUTO";
+   }
+}
@@ -0,0 +1,125 @@
+#ifndef FLUMORE_FILE_READER_H
+#define FLUMORE_FILE_READER_H
+/*=============================================================================
+
+   Name     : flumorefilereader.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREFileReader, the file input of the
+              native parser
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// How FLUMOREFileReader reads a file.
+enum FLUMOREReadMethod
+{
+   kFLUMOREReadAuto = 0,   // io_uring for large files where available
+   kFLUMOREReadBuffered,   // one buffered read through the C++ streams
+   kFLUMOREReadUring       // io_uring, falling back to buffered
+};
+
+//=====================================================================
+// FLUMOREFileReader
+//
+// Reads a whole file into memory. With io_uring the file is read in
+// large chunks of which queueDepth() are in flight at once, with
+// O_DIRECT where the file system allows it, so the storage is kept busy
+// without the page cache or page faults in between. Completed chunks
+// are copied into place as they arrive.
+// io_uring is only available on Linux builds defining FLUMORE_WITH_URING;
+// the system calls are made directly, no library is linked. Kernels
+// without io_uring or its read operation, and any other failure of the
+// io_uring path, fall back to buffered reads; fallback() tells why.
+// Errors are reported by the return value; error() describes them.
+class FLUMOREFileReader
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREFileReader();
+
+   // -----------------------------------------------------------------------
+   // read()
+   // Replaces data with the content of the file at path.
+   bool read(const string& path, vector<char>& data);
+
+   // -----------------------------------------------------------------------
+   // Settings
+   void setMethod(FLUMOREReadMethod method) { method_ = method; }
+   void setQueueDepth(size_t chunks) { queueDepth_ = std::min(std::max(chunks, size_t(1)), kMaxQueueDepth); }
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   FLUMOREReadMethod method() const { return method_; }
+   size_t queueDepth() const { return queueDepth_; }
+   // The method which read the last file, never kFLUMOREReadAuto.
+   FLUMOREReadMethod used() const { return used_; }
+   // Why the last read did not use io_uring although it was asked for,
+   // empty otherwise.
+   const string& fallback() const { return fallback_; }
+   const string& error() const { return error_; }
+
+   // -----------------------------------------------------------------------
+   // parseMethod()
+   // The method named AUTO, BUFFERED or URING.
+   static bool parseMethod(const string& name, FLUMOREReadMethod& method);
+
+   // -----------------------------------------------------------------------
+   // methodName()
+   // The name of method as accepted by parseMethod().
+   static const char* methodName(FLUMOREReadMethod method);
+
+   // -----------------------------------------------------------------------
+   // The default and largest number of chunks in flight and the size of
+   // a chunk.
+   static const size_t kDefaultQueueDepth = 8;
+   static const size_t kMaxQueueDepth = 64;
+   static const size_t kChunkSize = size_t(2) << 20;
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREFileReader(const FLUMOREFileReader&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREFileReader &operator=(const FLUMOREFileReader&);
+
+   // -----------------------------------------------------------------------
+   // readBuffered()
+   // Reads the file with one read through an ifstream.
+   bool readBuffered(const string& path, vector<char>& data);
+
+   // -----------------------------------------------------------------------
+   // readUring()
+   // Reads the file through io_uring. Returns false if it is to be read
+   // buffered instead, data is undefined then: with kFLUMOREReadAuto if
+   // the file is small, otherwise with fallback_ telling why.
+   bool readUring(const string& path, vector<char>& data);
+
+   // Data members
+
+   FLUMOREReadMethod method_;
+   size_t queueDepth_;
+   FLUMOREReadMethod used_;
+   string fallback_;
+
+   // Describes why the last read failed.
+   string error_;
+};
+
+#endif
@@ -0,0 +1,949 @@
+/*=============================================================================
+
+   Name     : flumorefilewriter.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREFileWriter method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorefilewriter.h"
+#include "flumoreformat.h"
+#include "flumorethreadpool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#ifdef WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+   // The file is written in pieces of this size.
+   const size_t kBufferSize = 4 << 20;
+
+   // Rows per column chunk, about 3 MiB.
+   const size_t kChunkRows = 64 << 10;
+
+   // Rows a chunk needs to be packed when its block is left. Smaller
+   // chunks stay open for further rows, so blocks arriving interleaved
+   // don't end up in tiny chunks.
+   const size_t kMinPackedRows = 1 << 10;
+
+   // Bytes of one row in the columns of a chunk being filled.
+   const uint64_t kRowBytes = sizeof(int32_t) + 6 * sizeof(double);
+
+   // The characters of a row with the usual number of digits.
+   const size_t kTypicalRowLength = 72;
+
+   // The most characters of one line of the file.
+   const size_t kMaxLineLength = 64 + 6 * (FLUMOREFormat::kMaxDecimalLength + 1);
+
+   // The column definition line following every Teilbereich line.
+   const char* const kColumnLine = "     ID,          RW,          HW,       Z,     WSP,      H,   VRES\n";
+
+   // Widths of the id and the six values matching kColumnLine.
+   const int kIdWidth = 7;
+   const int kValueWidths[] = { 12, 12, 8, 8, 7, 7 };
+
+   // Names of the timestamp kinds in FLUMORETimestampKind order.
+   const char* const kTimestampKinds[] = { "SIM", "VHS", "SZO" };
+
+   // Names of the situation kinds in FLUMORESituationKind order.
+   const char* const kSituationKinds[] =
+   {
+      "Ueberstr.", "Bresche", "Deichentl.", "Folgebruch", "Innere Entl.", "Linien-SM", "Punkt-SM"
+   };
+
+   // Largest values of the fixed width numbers in the grammar.
+   const int32_t kMaxTimesteps = 999;
+   const int32_t kMaxCount = 99999;
+   const int32_t kMaxTeilbereich = 999;
+   const int32_t kMaxVersion = 99;
+   const double kMaxSituationValue = 9999999999.0;
+
+   //------------------------------------------------------------------------
+   // Values of the grammar are \d+\.\d+, there is no sign or exponent.
+   inline bool writable(double value)
+   {
+      return value >= 0.0 && value <= 1.7976931348623157e308;
+   }
+
+   //------------------------------------------------------------------------
+   bool sameSituation(const FLUMORESituation& a, const FLUMORESituation& b)
+   {
+      if (a.kind != b.kind || a.nlp != b.nlp || a.hasLocation != b.hasLocation ||
+          a.valueCount != b.valueCount)
+      {
+         return false;
+      }
+      if (a.hasLocation && (a.rw != b.rw || a.hw != b.hw))
+      {
+         return false;
+      }
+      for (int32_t i = 0; i < a.valueCount; ++i)
+      {
+         if (a.values[i] != b.values[i])
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // fseek() with 64 bit offsets, spill files can exceed 2 GB.
+   bool seekTo(FILE* file, uint64_t offset)
+   {
+#ifdef WIN32
+      return _fseeki64(file, __int64(offset), SEEK_SET) == 0;
+#else
+      return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+   }
+
+   //------------------------------------------------------------------------
+   int processId()
+   {
+#ifdef WIN32
+      return _getpid();
+#else
+      return int(getpid());
+#endif
+   }
+
+   //=====================================================================
+   // Text formatted in place by reserving room for a line and committing
+   // its end. With a file the buffer is written out whenever it is full,
+   // without one it grows and holds all text, e.g. a block formatted on
+   // a worker thread.
+   class OutputBuffer
+   {
+   public:
+      OutputBuffer() : file_(NULL), used_(0), bytes_(0), ok_(true) {}
+      ~OutputBuffer() { close(); }
+
+      bool open(const string& path)
+      {
+         file_ = fopen(path.c_str(), "wb");
+         if (file_ == NULL)
+         {
+            return false;
+         }
+         // Everything is buffered here already.
+         setvbuf(file_, NULL, _IONBF, 0);
+         buffer_.resize(kBufferSize);
+         return true;
+      }
+
+      // Returns room for at least length characters.
+      char* reserve(size_t length)
+      {
+         if (buffer_.size() - used_ < length)
+         {
+            if (file_ != NULL)
+            {
+               flush();
+            }
+            if (buffer_.size() - used_ < length)
+            {
+               buffer_.resize(std::max(2 * buffer_.size(), used_ + std::max(length, kMaxLineLength)));
+            }
+         }
+         return &buffer_[used_];
+      }
+
+      void commit(char* end)
+      {
+         used_ = size_t(end - &buffer_[0]);
+      }
+
+      void append(const char* text, size_t length)
+      {
+         char* out = reserve(length);
+         memcpy(out, text, length);
+         commit(out + length);
+      }
+
+      void append(const char* text)
+      {
+         append(text, strlen(text));
+      }
+
+      // Writes the text of other, large texts directly.
+      void append(const OutputBuffer& other)
+      {
+         if (file_ == NULL || other.used_ < kBufferSize / 4)
+         {
+            append(other.used_ > 0 ? &other.buffer_[0] : "", other.used_);
+            return;
+         }
+         flush();
+         if (ok_)
+         {
+            ok_ = fwrite(&other.buffer_[0], 1, other.used_, file_) == other.used_;
+            bytes_ += other.used_;
+         }
+      }
+
+      bool flush()
+      {
+         if (used_ > 0 && ok_)
+         {
+            ok_ = fwrite(&buffer_[0], 1, used_, file_) == used_;
+            bytes_ += used_;
+         }
+         used_ = 0;
+         return ok_;
+      }
+
+      bool close()
+      {
+         if (file_ == NULL)
+         {
+            return ok_;
+         }
+         flush();
+         ok_ = (fclose(file_) == 0) && ok_;
+         file_ = NULL;
+         return ok_;
+      }
+
+      uint64_t bytes() const { return bytes_; }
+
+   private:
+      OutputBuffer(const OutputBuffer&);
+      OutputBuffer &operator=(const OutputBuffer&);
+
+      FILE* file_;
+      vector<char> buffer_;
+      size_t used_;
+      uint64_t bytes_;
+      bool ok_;
+   };
+
+   //------------------------------------------------------------------------
+   // Writes the three lines of a situation header. The parser joins them
+   // without a separator, so every number is preceded by a space.
+   void writeSituation(OutputBuffer& output, const FLUMORESituation& situation)
+   {
+      char* out = output.reserve(kMaxLineLength);
+      *out++ = ' ';
+      *out++ = ' ';
+      const char* kind = kSituationKinds[situation.kind];
+      const size_t kindLength = strlen(kind);
+      memcpy(out, kind, kindLength);
+      out += kindLength;
+      *out++ = ' ';
+      out = FLUMOREFormat::appendInteger(out, situation.nlp, 5);
+      *out++ = '\n';
+
+      // The location is required exactly if nlp is 1.
+      if (situation.nlp == 1)
+      {
+         const double rw = situation.hasLocation ? situation.rw : 0.0;
+         const double hw = situation.hasLocation ? situation.hw : 0.0;
+         *out++ = ' ';
+         out = FLUMOREFormat::appendFixed(out, rw, 1, 11);
+         *out++ = ' ';
+         out = FLUMOREFormat::appendFixed(out, hw, 1, 11);
+      }
+      *out++ = '\n';
+
+      for (int32_t i = 0; i < situation.valueCount; ++i)
+      {
+         *out++ = ' ';
+         out = FLUMOREFormat::appendDecimal(out, situation.values[i], 7);
+      }
+      *out++ = '\n';
+      output.commit(out);
+   }
+
+   //------------------------------------------------------------------------
+   // Writes a Teilbereich line and the column line.
+   void writeBlockHeader(OutputBuffer& output, int32_t id, int32_t version, size_t rows)
+   {
+      char* out = output.reserve(kMaxLineLength);
+      memcpy(out, "Teilbereich ", 12);
+      out = FLUMOREFormat::appendInteger(out + 12, int64_t(rows), 8);
+      memcpy(out, " TB", 3);
+      out = FLUMOREFormat::appendDigits(out + 3, id, 3);
+      memcpy(out, "-V", 2);
+      out = FLUMOREFormat::appendDigits(out + 2, version, 2);
+      *out++ = '\n';
+      output.commit(out);
+      output.append(kColumnLine);
+   }
+
+   //------------------------------------------------------------------------
+   // Writes the rows of a column chunk.
+   void writeRows(OutputBuffer& output, const FLUMOREColumns& columns)
+   {
+      const size_t rows = columns.size();
+      for (size_t r = 0; r < rows; ++r)
+      {
+         char* out = output.reserve(kMaxLineLength);
+         out = FLUMOREFormat::appendInteger(out, columns.id[r], kIdWidth);
+         *out++ = ',';
+         out = FLUMOREFormat::appendDecimal(out, columns.x[r], kValueWidths[0]);
+         *out++ = ',';
+         out = FLUMOREFormat::appendDecimal(out, columns.y[r], kValueWidths[1]);
+         *out++ = ',';
+         out = FLUMOREFormat::appendDecimal(out, columns.z[r], kValueWidths[2]);
+         *out++ = ',';
+         out = FLUMOREFormat::appendDecimal(out, columns.wsp[r], kValueWidths[3]);
+         *out++ = ',';
+         out = FLUMOREFormat::appendDecimal(out, columns.h[r], kValueWidths[4]);
+         *out++ = ',';
+         out = FLUMOREFormat::appendDecimal(out, columns.vres[r], kValueWidths[5]);
+         *out++ = '\n';
+         output.commit(out);
+      }
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMOREFileWriter::FLUMOREFileWriter()
+:
+   current_(NULL),
+   currentTimestamp_(0),
+   currentSituation_(0),
+   rows_(0),
+   blocks_(0),
+   bytesWritten_(0),
+   memoryBytes_(0),
+   memoryLimit_(0),
+   spill_(NULL),
+   spillSize_(0),
+   threads_(1),
+   failed_(false)
+{
+}
+
+//===========================================================================
+// Destructor
+FLUMOREFileWriter::~FLUMOREFileWriter()
+{
+   closeSpill();
+}
+
+//===========================================================================
+// Clear
+void FLUMOREFileWriter::clear()
+{
+   vector<Timestamp>().swap(timestamps_);
+   timestampIndex_.clear();
+   current_ = NULL;
+   currentTimestamp_ = 0;
+   currentSituation_ = 0;
+   rows_ = 0;
+   blocks_ = 0;
+   memoryBytes_ = 0;
+   failed_ = false;
+   error_.clear();
+   closeSpill();
+}
+
+//===========================================================================
+// Set Memory Limit
+void FLUMOREFileWriter::setMemoryLimit(uint64_t limit, const string& directory)
+{
+   memoryLimit_ = limit;
+   spillDirectory_ = directory;
+}
+
+//===========================================================================
+// Set Threads
+void FLUMOREFileWriter::setThreads(size_t threads)
+{
+   threads_ = threads > 0 ? threads : FLUMOREThreadPool::defaultThreads();
+}
+
+//===========================================================================
+// Pack Chunk
+void FLUMOREFileWriter::packChunk(Chunk& chunk)
+{
+   memoryBytes_ -= chunk.columns.size() * kRowBytes;
+   chunk.rows.pack(chunk.columns);
+   chunk.columns = FLUMOREColumns();
+   chunk.packed = true;
+   memoryBytes_ += chunk.rows.bytes();
+}
+
+//===========================================================================
+// Spill
+bool FLUMOREFileWriter::spill()
+{
+   if (spill_ == NULL)
+   {
+      ostringstream path;
+      if (!spillDirectory_.empty())
+      {
+         path << spillDirectory_ << "/";
+      }
+      path << "flumore-" << processId() << "-" << static_cast<const void*>(this) << ".spill";
+      spillPath_ = path.str();
+      spill_ = fopen(spillPath_.c_str(), "w+b");
+      if (spill_ == NULL)
+      {
+         error_ = "Could not create the spill file " + spillPath_;
+         return false;
+      }
+      setvbuf(spill_, NULL, _IOFBF, kBufferSize);
+      spillSize_ = 0;
+   }
+   if (!seekTo(spill_, spillSize_))
+   {
+      error_ = "Could not write the spill file " + spillPath_;
+      return false;
+   }
+
+   for (size_t t = 0; t < timestamps_.size(); ++t)
+   {
+      vector<Situation>& situations = timestamps_[t].situations;
+      for (size_t s = 0; s < situations.size(); ++s)
+      {
+         vector<Block>& blocks = situations[s].blocks;
+         for (size_t b = 0; b < blocks.size(); ++b)
+         {
+            vector<Chunk>& chunks = blocks[b].chunks;
+            for (size_t c = 0; c < chunks.size(); ++c)
+            {
+               Chunk& chunk = chunks[c];
+               if (chunk.spilled)
+               {
+                  continue;
+               }
+               if (!chunk.packed)
+               {
+                  packChunk(chunk);
+               }
+               const size_t size = chunk.rows.dataSize();
+               if (size > 0 && fwrite(chunk.rows.data(), 1, size, spill_) != size)
+               {
+                  error_ = "Could not write the spill file " + spillPath_;
+                  return false;
+               }
+               chunk.spilled = true;
+               chunk.offset = spillSize_;
+               spillSize_ += size;
+               chunk.rows.release();
+            }
+         }
+      }
+   }
+   memoryBytes_ = 0;
+   return true;
+}
+
+//===========================================================================
+// Load Chunk
+bool FLUMOREFileWriter::loadChunk(const Chunk& chunk, FLUMOREColumns& columns, vector<char>& data)
+{
+   const size_t size = chunk.rows.dataSize();
+   data.resize(size);
+   if (fflush(spill_) != 0 || !seekTo(spill_, chunk.offset) ||
+       (size > 0 && fread(&data[0], 1, size, spill_) != size))
+   {
+      error_ = "Could not read the spill file " + spillPath_;
+      return false;
+   }
+   columns.clear();
+   chunk.rows.unpack(size > 0 ? &data[0] : NULL, columns);
+   return true;
+}
+
+//===========================================================================
+// Close Spill
+void FLUMOREFileWriter::closeSpill()
+{
+   if (spill_ != NULL)
+   {
+      fclose(spill_);
+      remove(spillPath_.c_str());
+      spill_ = NULL;
+   }
+   spillPath_.clear();
+   spillSize_ = 0;
+}
+
+//===========================================================================
+// Select Block
+bool FLUMOREFileWriter::selectBlock(const FLUMORETimestamp& timestamp,
+                                    const FLUMORESituation* situation,
+                                    int32_t id, int32_t version)
+{
+   if (id < 0 || id > kMaxTeilbereich || version < 0 || version > kMaxVersion)
+   {
+      error_ = "The Teilbereich id or version is out of range";
+      return false;
+   }
+   if (situation != NULL)
+   {
+      bool valid = situation->nlp >= 0 && situation->nlp <= kMaxCount &&
+                   situation->valueCount >= 0 && situation->valueCount <= 3;
+      for (int32_t i = 0; valid && i < situation->valueCount; ++i)
+      {
+         valid = situation->values[i] >= 0.0 && situation->values[i] <= kMaxSituationValue;
+      }
+      if (valid && situation->hasLocation)
+      {
+         valid = situation->rw >= 0.0 && situation->rw <= kMaxSituationValue &&
+                 situation->hw >= 0.0 && situation->hw <= kMaxSituationValue;
+      }
+      if (!valid)
+      {
+         error_ = "The situation values are out of range";
+         return false;
+      }
+   }
+
+   // Features usually arrive block by block, so most calls end here.
+   if (current_ != NULL)
+   {
+      const Timestamp& last = timestamps_[currentTimestamp_];
+      const Situation& lastSituation = last.situations[currentSituation_];
+      if (current_->id == id && current_->version == version &&
+          last.timestamp.kind == timestamp.kind && last.timestamp.fmeDate == timestamp.fmeDate &&
+          lastSituation.hasSituation == (situation != NULL) &&
+          (situation == NULL || sameSituation(lastSituation.situation, *situation)))
+      {
+         return true;
+      }
+   }
+
+   // The rows of the block left are usually complete.
+   if (current_ != NULL && !current_->chunks.empty() && !current_->chunks.back().packed &&
+       current_->chunks.back().columns.size() >= kMinPackedRows)
+   {
+      packChunk(current_->chunks.back());
+   }
+
+   const string key = timestamp.fmeDate + kTimestampKinds[timestamp.kind];
+   map<string, size_t>::const_iterator found = timestampIndex_.find(key);
+   if (found == timestampIndex_.end())
+   {
+      Timestamp added;
+      added.timestamp = timestamp;
+      timestamps_.push_back(added);
+      found = timestampIndex_.insert(make_pair(key, timestamps_.size() - 1)).first;
+   }
+   currentTimestamp_ = found->second;
+   vector<Situation>& situations = timestamps_[currentTimestamp_].situations;
+
+   size_t s = 0;
+   for (; s < situations.size(); ++s)
+   {
+      if (situations[s].hasSituation == (situation != NULL) &&
+          (situation == NULL || sameSituation(situations[s].situation, *situation)))
+      {
+         break;
+      }
+   }
+   if (s == situations.size())
+   {
+      Situation added;
+      added.hasSituation = (situation != NULL);
+      if (situation != NULL)
+      {
+         added.situation = *situation;
+      }
+      situations.push_back(added);
+   }
+   currentSituation_ = s;
+   vector<Block>& blocks = situations[s].blocks;
+
+   size_t b = 0;
+   for (; b < blocks.size(); ++b)
+   {
+      if (blocks[b].id == id && blocks[b].version == version)
+      {
+         break;
+      }
+   }
+   if (b == blocks.size())
+   {
+      blocks.push_back(Block());
+      blocks.back().id = id;
+      blocks.back().version = version;
+      blocks.back().rows = 0;
+      ++blocks_;
+   }
+   current_ = &blocks[b];
+   return true;
+}
+
+//===========================================================================
+// Add Row
+bool FLUMOREFileWriter::addRow(int32_t id, const double* values)
+{
+   if (failed_)
+   {
+      return false;
+   }
+   if (current_ == NULL)
+   {
+      error_ = "No block was selected";
+      return false;
+   }
+   if (id < 0 || !writable(values[0]) || !writable(values[1]) || !writable(values[2]) ||
+       !writable(values[3]) || !writable(values[4]) || !writable(values[5]))
+   {
+      error_ = "The row has negative or non finite values";
+      return false;
+   }
+
+   vector<Chunk>& chunks = current_->chunks;
+   if (chunks.empty() || chunks.back().packed)
+   {
+      chunks.push_back(Chunk());
+      chunks.back().packed = false;
+      chunks.back().spilled = false;
+      chunks.back().offset = 0;
+   }
+
+   Chunk& chunk = chunks.back();
+   FLUMOREColumns& columns = chunk.columns;
+   columns.id.push_back(id);
+   columns.x.push_back(values[0]);
+   columns.y.push_back(values[1]);
+   columns.z.push_back(values[2]);
+   columns.wsp.push_back(values[3]);
+   columns.h.push_back(values[4]);
+   columns.vres.push_back(values[5]);
+   ++current_->rows;
+   ++rows_;
+
+   memoryBytes_ += kRowBytes;
+   if (columns.size() >= kChunkRows)
+   {
+      packChunk(chunk);
+   }
+   if (memoryLimit_ > 0 && memoryBytes_ > memoryLimit_ && !spill())
+   {
+      failed_ = true;
+      return false;
+   }
+   return true;
+}
+
+//===========================================================================
+// Earliest
+const FLUMORETimestamp* FLUMOREFileWriter::earliest() const
+{
+   const FLUMORETimestamp* first = NULL;
+   for (size_t t = 0; t < timestamps_.size(); ++t)
+   {
+      if (first == NULL || timestamps_[t].timestamp.fmeDate < first->fmeDate)
+      {
+         first = &timestamps_[t].timestamp;
+      }
+   }
+   return first;
+}
+
+//===========================================================================
+// Has Kind
+bool FLUMOREFileWriter::hasKind(FLUMORETimestampKind kind) const
+{
+   for (size_t t = 0; t < timestamps_.size(); ++t)
+   {
+      if (timestamps_[t].timestamp.kind == kind)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+//===========================================================================
+// Write
+bool FLUMOREFileWriter::write(const string& path, const FLUMOREPackageHeader& header)
+{
+   bytesWritten_ = 0;
+   if (failed_)
+   {
+      return false;
+   }
+   error_.clear();
+
+   if (timestamps_.size() > size_t(kMaxTimesteps))
+   {
+      ostringstream msg;
+      msg << "FLUMORE files can't hold more than " << kMaxTimesteps << " timesteps, got "
+          << timestamps_.size();
+      error_ = msg.str();
+      return false;
+   }
+
+   // The map sorts by the UTC date, i.e. chronologically.
+   vector<size_t> order;
+   order.reserve(timestamps_.size());
+   for (map<string, size_t>::const_iterator it = timestampIndex_.begin(); it != timestampIndex_.end(); ++it)
+   {
+      order.push_back(it->second);
+   }
+
+   string created, createdUtc;
+   if (!FLUMOREFormat::flumoreDate(header.created, created, createdUtc) || created != header.created)
+   {
+      error_ = "The creation date is not of the form dd.MM.yyyy-HH:mm: " + header.created;
+      return false;
+   }
+
+   OutputBuffer output;
+   if (!output.open(path))
+   {
+      error_ = "Could not open " + path;
+      return false;
+   }
+
+   //=====================================================================
+   // A part of the file in the order of the file. A piece of header
+   // lines is formatted right away, a piece with a chunk by a worker.
+   struct Piece
+   {
+      OutputBuffer text;
+      const Chunk* chunk;
+      bool done;
+      bool ok;
+   };
+
+   // With more than one thread the lines around the rows are collected in
+   // pieces. Otherwise everything is formatted straight into output.
+   size_t chunkCount = 0;
+   for (size_t t = 0; t < timestamps_.size(); ++t)
+   {
+      const vector<Situation>& situations = timestamps_[t].situations;
+      for (size_t s = 0; s < situations.size(); ++s)
+      {
+         for (size_t b = 0; b < situations[s].blocks.size(); ++b)
+         {
+            chunkCount += situations[s].blocks[b].chunks.size();
+         }
+      }
+   }
+   const bool parallel = threads_ > 1 && chunkCount > 1;
+   vector<unique_ptr<Piece> > pieces;
+
+   // Returns where the next header lines go.
+   auto headerText = [&]() -> OutputBuffer&
+   {
+      if (!parallel)
+      {
+         return output;
+      }
+      if (pieces.empty() || pieces.back()->chunk != NULL)
+      {
+         pieces.push_back(unique_ptr<Piece>(new Piece()));
+         pieces.back()->chunk = NULL;
+         pieces.back()->done = true;
+         pieces.back()->ok = true;
+      }
+      return pieces.back()->text;
+   };
+
+   // Packed chunks are unpacked into this one at a time.
+   FLUMOREColumns loaded;
+   vector<char> spilled;
+
+   char* out = headerText().reserve(kMaxLineLength);
+   memcpy(out, "FLUMORE ", 8);
+   out += 8;
+   memcpy(out, created.data(), created.size());
+   out += created.size();
+   *out++ = ' ';
+   out = FLUMOREFormat::appendInteger(out, int64_t(timestamps_.size()), 3);
+   memcpy(out, " N", 2);
+   out = FLUMOREFormat::appendDigits(out + 2, header.variant, 3);
+   memcpy(out, "-P", 2);
+   out = FLUMOREFormat::appendDigits(out + 2, header.counter, 3);
+   *out++ = '\n';
+   headerText().commit(out);
+
+   for (size_t o = 0; o < order.size(); ++o)
+   {
+      const Timestamp& timestamp = timestamps_[order[o]];
+
+      int64_t situationCount = 0;
+      int64_t blockCount = 0;
+      for (size_t s = 0; s < timestamp.situations.size(); ++s)
+      {
+         situationCount += timestamp.situations[s].hasSituation ? 1 : 0;
+         blockCount += int64_t(timestamp.situations[s].blocks.size());
+      }
+
+      out = headerText().reserve(kMaxLineLength);
+      *out++ = ' ';
+      memcpy(out, timestamp.timestamp.date.data(), timestamp.timestamp.date.size());
+      out += timestamp.timestamp.date.size();
+      *out++ = ' ';
+      memcpy(out, kTimestampKinds[timestamp.timestamp.kind], 3);
+      out += 3;
+      *out++ = ' ';
+      out = FLUMOREFormat::appendInteger(out, std::min(situationCount, int64_t(kMaxCount)), 3);
+      *out++ = ' ';
+      out = FLUMOREFormat::appendInteger(out, std::min(blockCount, int64_t(kMaxCount)), 3);
+      *out++ = '\n';
+      headerText().commit(out);
+
+      // Blocks without a situation have to follow the timestamp line.
+      for (int pass = 0; pass < 2; ++pass)
+      {
+         for (size_t s = 0; s < timestamp.situations.size(); ++s)
+         {
+            const Situation& situation = timestamp.situations[s];
+            if (situation.hasSituation != (pass == 1))
+            {
+               continue;
+            }
+            if (situation.hasSituation)
+            {
+               writeSituation(headerText(), situation.situation);
+            }
+            for (size_t b = 0; b < situation.blocks.size(); ++b)
+            {
+               const Block& block = situation.blocks[b];
+               writeBlockHeader(headerText(), block.id, block.version, block.rows);
+               for (size_t c = 0; c < block.chunks.size(); ++c)
+               {
+                  const Chunk& chunk = block.chunks[c];
+                  if (parallel)
+                  {
+                     pieces.push_back(unique_ptr<Piece>(new Piece()));
+                     pieces.back()->chunk = &chunk;
+                     pieces.back()->done = false;
+                     pieces.back()->ok = true;
+                  }
+                  else if (!chunk.packed)
+                  {
+                     writeRows(output, chunk.columns);
+                  }
+                  else if (!chunk.spilled)
+                  {
+                     loaded.clear();
+                     chunk.rows.unpack(loaded);
+                     writeRows(output, loaded);
+                  }
+                  else if (loadChunk(chunk, loaded, spilled))
+                  {
+                     writeRows(output, loaded);
+                  }
+                  else
+                  {
+                     output.close();
+                     return false;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   if (parallel)
+   {
+      // The pieces are formatted in parallel and written in order as soon
+      // as they are done. At most window pieces are formatted ahead of the
+      // one written, which bounds the memory to a few chunks per thread.
+      // They run on the shared pool; failing, write() waits for the
+      // pieces in flight before it frees them.
+      mutex doneLock;
+      condition_variable doneSignal;
+      mutex spillLock;
+      bool failed = false;
+      size_t submittedTasks = 0;
+      size_t finishedTasks = 0;
+
+      FLUMOREThreadPool& pool = FLUMOREThreadPool::shared();
+      const size_t window = 2 * threads_;
+
+      auto format = [&](Piece* piece)
+      {
+         const Chunk& chunk = *piece->chunk;
+         bool ok = true;
+         FLUMOREColumns unpacked;
+         if (chunk.spilled)
+         {
+            vector<char> data;
+            lock_guard<mutex> guard(spillLock);
+            ok = loadChunk(chunk, unpacked, data);
+         }
+         else if (chunk.packed)
+         {
+            chunk.rows.unpack(unpacked);
+         }
+         if (ok)
+         {
+            const FLUMOREColumns& columns = chunk.packed ? unpacked : chunk.columns;
+            piece->text.reserve(columns.size() * kTypicalRowLength);
+            writeRows(piece->text, columns);
+         }
+         lock_guard<mutex> guard(doneLock);
+         piece->ok = ok;
+         piece->done = true;
+         ++finishedTasks;
+         doneSignal.notify_all();
+      };
+
+      size_t submitted = 0;
+      for (size_t p = 0; p < pieces.size() && !failed; ++p)
+      {
+         for (; submitted < pieces.size() && submitted < p + window; ++submitted)
+         {
+            if (pieces[submitted]->chunk != NULL)
+            {
+               pool.submit(std::bind(format, pieces[submitted].get()));
+               ++submittedTasks;
+            }
+         }
+
+         Piece& piece = *pieces[p];
+         {
+            unique_lock<mutex> guard(doneLock);
+            while (!piece.done)
+            {
+               doneSignal.wait(guard);
+            }
+            failed = !piece.ok;
+         }
+         if (!failed)
+         {
+            output.append(piece.text);
+         }
+         pieces[p].reset();
+      }
+      if (failed)
+      {
+         unique_lock<mutex> guard(doneLock);
+         while (finishedTasks < submittedTasks)
+         {
+            doneSignal.wait(guard);
+         }
+         guard.unlock();
+         output.close();
+         return false;
+      }
+   }
+
+   const bool ok = output.close();
+   bytesWritten_ = output.bytes();
+   if (!ok)
+   {
+      error_ = "Could not write " + path;
+   }
+   return ok;
+}
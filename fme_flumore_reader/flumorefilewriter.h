@@ -0,0 +1,237 @@
+#ifndef FLUMORE_FILE_WRITER_H
+#define FLUMORE_FILE_WRITER_H
+/*=============================================================================
+
+   Name     : flumorefilewriter.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREFileWriter
+
+=============================================================================*/
+
+#include "flumorecompactrows.h"
+#include "flumoreparser.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// FLUMOREFileWriter
+//
+// Collects the rows of one FLUMORE file and writes it. The grammar needs
+// the number of situations, blocks and rows before their content, so
+// the rows are kept per timestamp, situation and Teilbereich block until
+// write() is called. Timestamps are written in chronological order,
+// situations and blocks in the order they were first seen. The file is
+// formatted straight into a large buffer which is written in one piece
+// whenever it is full.
+// The rows of a block are held in column chunks, which are packed with
+// FLUMORECompactRows once they are full or the features move on to
+// another block. Once the chunks in memory
+// exceed the memory limit they are all packed and moved to a temporary
+// spill file and read back one at a time by write().
+// With more than one thread write() formats the chunks on a thread pool
+// and writes them in file order as they are done.
+// Errors are reported by the return value; error() describes them.
+class FLUMOREFileWriter
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREFileWriter();
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   ~FLUMOREFileWriter();
+
+   // -----------------------------------------------------------------------
+   // clear()
+   // Drops all collected rows.
+   void clear();
+
+   // -----------------------------------------------------------------------
+   // setMemoryLimit()
+   // Rows beyond limit bytes are spilled to a temporary file in
+   // directory, the current folder if it is empty. 0 keeps all rows in
+   // memory. Applies from the next addRow().
+   void setMemoryLimit(uint64_t limit, const string& directory);
+
+   // -----------------------------------------------------------------------
+   // setThreads()
+   // The number of threads of the shared pool write() formats the rows
+   // with, all of them if it is 0.
+   void setThreads(size_t threads);
+
+   // -----------------------------------------------------------------------
+   // selectBlock()
+   // The following rows belong to this block. Without a situation the
+   // block follows the timestamp line directly. Cheap if the block did not
+   // change. Fails if the values can't be written in FLUMORE, i.e. they
+   // are negative or have too many digits.
+   bool selectBlock(const FLUMORETimestamp& timestamp, const FLUMORESituation* situation,
+                    int32_t id, int32_t version);
+
+   // -----------------------------------------------------------------------
+   // addRow()
+   // Adds a row to the selected block, the values are x, y, z, wsp, h and
+   // vres. Fails if there is no block or the row can't be written in
+   // FLUMORE, i.e. it has negative or non finite values. Also fails if
+   // the spill file can't be written, failed() is set then.
+   bool addRow(int32_t id, const double* values);
+
+   // -----------------------------------------------------------------------
+   // write()
+   // Writes all collected rows to path. The creation date, variant and
+   // counter are taken from header, the number of timesteps is counted.
+   bool write(const string& path, const FLUMOREPackageHeader& header);
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   size_t rows() const { return rows_; }
+   size_t blocks() const { return blocks_; }
+   size_t timestamps() const { return timestamps_.size(); }
+   uint64_t bytesWritten() const { return bytesWritten_; }
+   uint64_t bytesSpilled() const { return spillSize_; }
+   uint64_t bytesInMemory() const { return memoryBytes_; }
+   size_t threads() const { return threads_; }
+   const string& error() const { return error_; }
+   bool failed() const { return failed_; }
+
+   // -----------------------------------------------------------------------
+   // earliest()
+   // The chronologically first timestamp, NULL if there are no rows.
+   const FLUMORETimestamp* earliest() const;
+
+   // -----------------------------------------------------------------------
+   // hasKind()
+   // Whether any timestamp is of the given kind.
+   bool hasKind(FLUMORETimestampKind kind) const;
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREFileWriter(const FLUMOREFileWriter&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREFileWriter &operator=(const FLUMOREFileWriter&);
+
+   //=====================================================================
+   struct Chunk;
+
+   // -----------------------------------------------------------------------
+   // packChunk()
+   // Replaces the columns of the chunk by their packed form.
+   void packChunk(Chunk& chunk);
+
+   // -----------------------------------------------------------------------
+   // spill()
+   // Moves all chunks held in memory to the spill file.
+   bool spill();
+
+   // -----------------------------------------------------------------------
+   // loadChunk()
+   // Reads a spilled chunk back into columns, data holds its packed
+   // values in between.
+   bool loadChunk(const Chunk& chunk, FLUMOREColumns& columns, vector<char>& data);
+
+   // -----------------------------------------------------------------------
+   // closeSpill()
+   // Closes and removes the spill file.
+   void closeSpill();
+
+   //=====================================================================
+   // A part of the rows of a block, in columns while it is filled and
+   // in rows once it is packed. Spilled chunks keep the packed values at
+   // offset in the spill file.
+   struct Chunk
+   {
+      FLUMOREColumns columns;
+      FLUMORECompactRows rows;
+      bool packed;
+      bool spilled;
+      uint64_t offset;
+   };
+
+   //=====================================================================
+   // The rows of one Teilbereich block, new rows go to the last chunk.
+   struct Block
+   {
+      int32_t id;
+      int32_t version;
+      size_t rows;
+      vector<Chunk> chunks;
+   };
+
+   //=====================================================================
+   // The blocks following a situation header, or the timestamp line if
+   // hasSituation is not set.
+   struct Situation
+   {
+      bool hasSituation;
+      FLUMORESituation situation;
+      vector<Block> blocks;
+   };
+
+   //=====================================================================
+   struct Timestamp
+   {
+      FLUMORETimestamp timestamp;
+      vector<Situation> situations;
+   };
+
+   // Data members
+
+   // All collected rows in the order the timestamps were first seen.
+   vector<Timestamp> timestamps_;
+
+   // Finds the timestamps by their UTC date and kind.
+   map<string, size_t> timestampIndex_;
+
+   // The block the rows are added to, NULL before the first selectBlock().
+   Block* current_;
+   size_t currentTimestamp_;
+   size_t currentSituation_;
+
+   // Counters of the collected rows and blocks.
+   size_t rows_;
+   size_t blocks_;
+
+   // Bytes written by the last write().
+   uint64_t bytesWritten_;
+
+   // Bytes of the rows held in memory and their limit, 0 if there is no
+   // limit.
+   uint64_t memoryBytes_;
+   uint64_t memoryLimit_;
+
+   // The spill file, NULL until the limit is first exceeded, and the
+   // number of bytes in it.
+   string spillDirectory_;
+   string spillPath_;
+   FILE* spill_;
+   uint64_t spillSize_;
+
+   // Threads used by write().
+   size_t threads_;
+
+   // Set if the spill file could not be written. The collected rows are
+   // incomplete, so write() fails until clear() is called.
+   bool failed_;
+
+   // Describes why the last operation failed.
+   string error_;
+};
+
+#endif
@@ -0,0 +1,615 @@
+/*=============================================================================
+
+   Name     : flumoreformat.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREFormat method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumoreformat.h"
+#include "flumoreparser.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+   // Exact powers of ten, 1e22 is the largest one representable as double.
+   const double kPowersOfTen[] =
+   {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+   };
+
+   // Integers below 2^53 are exact doubles.
+   const double kMaxExactInteger = 9007199254740992.0;
+
+   // Integers below 2^51 are at most a quarter unit apart from the next
+   // double, so a rounding interval holds at most one of them.
+   const double kMaxUniqueInteger = 2251799813685248.0;
+
+   // The fraction digits tried first by appendDecimal(). FLUMORE values
+   // have up to three.
+   const int kGuessScale = 4;
+
+   // The most fraction digits tried by the fast path of appendDecimal().
+   const int kMaxFastScale = 17;
+
+   //------------------------------------------------------------------------
+   inline bool isDigit(char c)
+   {
+      return c >= '0' && c <= '9';
+   }
+
+   // Powers of ten as integers, used to count digits.
+   const uint64_t kIntegerPowersOfTen[] =
+   {
+      1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+      100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+      10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+      100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+   };
+
+   // "00" to "99", digits are produced in pairs.
+   const char kDigitPairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+
+   //------------------------------------------------------------------------
+   // Writes [-]mantissa / 10^scale right aligned in width characters and
+   // returns the position behind it. The text is written back to front
+   // directly into out.
+   char* writeScaled(char* out, uint64_t mantissa, int scale, int width, bool negative)
+   {
+      int digits = 1;
+      while (digits < 20 && mantissa >= kIntegerPowersOfTen[digits])
+      {
+         ++digits;
+      }
+      if (digits < scale + 1)
+      {
+         digits = scale + 1;
+      }
+      const int length = digits + (scale > 0 ? 1 : 0) + (negative ? 1 : 0);
+      for (int i = length; i < width; ++i)
+      {
+         *out++ = ' ';
+      }
+
+      char* const end = out + length;
+      char* p = end;
+      int fraction = scale;
+      while (fraction >= 2)
+      {
+         const char* pair = kDigitPairs + 2 * (mantissa % 100);
+         mantissa /= 100;
+         *--p = pair[1];
+         *--p = pair[0];
+         fraction -= 2;
+      }
+      if (fraction == 1)
+      {
+         *--p = char('0' + mantissa % 10);
+         mantissa /= 10;
+      }
+      if (scale > 0)
+      {
+         *--p = '.';
+      }
+      char* const first = out + (negative ? 1 : 0);
+      while (p - first >= 2)
+      {
+         const char* pair = kDigitPairs + 2 * (mantissa % 100);
+         mantissa /= 100;
+         *--p = pair[1];
+         *--p = pair[0];
+      }
+      if (p > first)
+      {
+         *--p = char('0' + mantissa % 10);
+      }
+      if (negative)
+      {
+         *out = '-';
+      }
+      return end;
+   }
+
+   //------------------------------------------------------------------------
+   // Writes the significant digits and the decimal exponent of a value
+   // printed in scientific notation as positional \d+\.\d+, dropping
+   // trailing zeros of the fraction. Returns the length.
+   int expandScientific(char* out, const char* digits, int digitCount, int exponent)
+   {
+      int length = 0;
+      if (exponent >= 0)
+      {
+         for (int i = 0; i <= exponent; ++i)
+         {
+            out[length++] = (i < digitCount) ? digits[i] : '0';
+         }
+         out[length++] = '.';
+         for (int i = exponent + 1; i < digitCount; ++i)
+         {
+            out[length++] = digits[i];
+         }
+      }
+      else
+      {
+         out[length++] = '0';
+         out[length++] = '.';
+         for (int i = -1; i > exponent; --i)
+         {
+            out[length++] = '0';
+         }
+         for (int i = 0; i < digitCount; ++i)
+         {
+            out[length++] = digits[i];
+         }
+      }
+
+      while (out[length - 1] == '0' && out[length - 2] != '.')
+      {
+         --length;
+      }
+      if (out[length - 1] == '.')
+      {
+         out[length++] = '0';
+      }
+      return length;
+   }
+
+   //------------------------------------------------------------------------
+   // The general case of appendDecimal() for values which are very large,
+   // very small or need more than kMaxFastScale fraction digits. Tries 15
+   // to 17 significant digits, 17 always read back exactly.
+   int formatDecimalSlow(char* out, double value)
+   {
+      int length = 0;
+      for (int precision = 15; precision <= 17; ++precision)
+      {
+         char scientific[40];
+         snprintf(scientific, sizeof(scientific), "%.*e", precision - 1, value);
+
+         // The decimal point depends on the C locale, so only the digits
+         // and the exponent are taken.
+         char digits[24];
+         int digitCount = 0;
+         const char* p = scientific;
+         for (; *p != '\0' && *p != 'e' && *p != 'E'; ++p)
+         {
+            if (isDigit(*p))
+            {
+               digits[digitCount++] = *p;
+            }
+         }
+         const int exponent = (*p != '\0') ? atoi(p + 1) : 0;
+
+         length = expandScientific(out, digits, digitCount, exponent);
+
+         double parsed = 0.0;
+         const char* q = out;
+         if (FLUMOREParser::parseDecimal(q, out + length, parsed) && parsed == value)
+         {
+            break;
+         }
+      }
+      return length;
+   }
+
+   //------------------------------------------------------------------------
+   // Writes the text right aligned in width characters.
+   inline char* appendPadded(char* out, const char* text, int length, int width)
+   {
+      for (int i = length; i < width; ++i)
+      {
+         *out++ = ' ';
+      }
+      memcpy(out, text, size_t(length));
+      return out + length;
+   }
+
+   //------------------------------------------------------------------------
+   // Converts UTC to the local time of this machine, the inverse of
+   // FLUMOREFormat::universalDate(). Returns false if it isn't possible.
+   bool localDate(struct tm& date)
+   {
+#ifdef WIN32
+      const time_t seconds = _mkgmtime(&date);
+      return seconds != time_t(-1) && localtime_s(&date, &seconds) == 0;
+#else
+      const time_t seconds = timegm(&date);
+      return seconds != time_t(-1) && localtime_r(&seconds, &date) != NULL;
+#endif
+   }
+
+   //------------------------------------------------------------------------
+   // Days from 1970-01-01 to a date of the Gregorian calendar.
+   int64_t daysFromCivil(int32_t year, int32_t month, int32_t day)
+   {
+      const int64_t y = year - (month <= 2 ? 1 : 0);
+      const int64_t era = (y >= 0 ? y : y - 399) / 400;
+      const int64_t yearOfEra = y - era * 400;
+      const int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+      const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+      return era * 146097 + dayOfEra - 719468;
+   }
+
+   //------------------------------------------------------------------------
+   // Splits minutes from 1970-01-01 00:00 into the date and time.
+   void splitMinutes(int64_t minutes, int32_t& year, int32_t& month, int32_t& day,
+                     int32_t& hour, int32_t& minute)
+   {
+      int64_t days = (minutes >= 0 ? minutes : minutes - 1439) / 1440;
+      const int64_t time = minutes - days * 1440;
+      hour = int32_t(time / 60);
+      minute = int32_t(time % 60);
+
+      days += 719468;
+      const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+      const int64_t dayOfEra = days - era * 146097;
+      const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+      const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+      const int64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+      day = int32_t(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+      month = int32_t(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+      year = int32_t(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+   }
+
+   //------------------------------------------------------------------------
+   // The last Sunday of a month in days from 1970-01-01, a Thursday.
+   int64_t lastSunday(int32_t year, int32_t month)
+   {
+      const int64_t last = (month == 12 ? daysFromCivil(year + 1, 1, 1) : daysFromCivil(year, month + 1, 1)) - 1;
+      return last - ((last + 4) % 7 + 7) % 7;
+   }
+
+   //------------------------------------------------------------------------
+   // Minutes east of UTC of a zone other than the local one. The time is
+   // given in minutes from 1970, in UTC if universal is set and in the
+   // time of the zone otherwise.
+   int32_t zoneOffset(const FLUMORETimeZone& zone, int32_t year, int64_t minutes, bool universal)
+   {
+      switch (zone.kind)
+      {
+      case kFLUMOREZoneFixed:
+         return zone.offset;
+      case kFLUMOREZoneCentralEurope:
+      {
+         // Summer time lasts from 01:00 UTC on the last Sunday of March to
+         // 01:00 UTC on the last Sunday of October, as in the EU since
+         // 1996. In local time that is 03:00 to 02:00; the skipped hour
+         // before and the repeated hour after are standard time.
+         const int64_t begin = lastSunday(year, 3) * 1440 + (universal ? 60 : 180);
+         const int64_t end = lastSunday(year, 10) * 1440 + (universal ? 60 : 120);
+         return (minutes >= begin && minutes < end) ? 120 : 60;
+      }
+      default:
+         return 0;
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // Reads count digits at p.
+   bool readDigits(const char* p, int count, int32_t& value)
+   {
+      value = 0;
+      for (int i = 0; i < count; ++i)
+      {
+         if (!isDigit(p[i]))
+         {
+            return false;
+         }
+         value = value * 10 + (p[i] - '0');
+      }
+      return true;
+   }
+}
+
+//===========================================================================
+// Append Decimal
+char* FLUMOREFormat::appendDecimal(char* out, double value, int width)
+{
+   // Values with few fraction digits, i.e. nearly all FLUMORE values, are
+   // written as mantissa / 10^scale which divides back to the value. That
+   // is the computation of the parser's fast path and correctly rounded,
+   // so every exact parser reads the same double.
+   //
+   // Below 2^51 at most one mantissa of a scale divides back to the value.
+   // If one with kGuessScale digits does, it is the shortest one with its
+   // trailing zeros removed, so the common case needs a single division.
+   const double guessed = value * kPowersOfTen[kGuessScale];
+   int scale = 1;
+   if (guessed < kMaxUniqueInteger)
+   {
+      uint64_t mantissa = uint64_t(guessed);
+      if (guessed - double(mantissa) >= 0.5)
+      {
+         ++mantissa;
+      }
+      if (double(mantissa) / kPowersOfTen[kGuessScale] == value)
+      {
+         int shortest = kGuessScale;
+         while (shortest > 1 && mantissa % 10 == 0)
+         {
+            mantissa /= 10;
+            --shortest;
+         }
+         return writeScaled(out, mantissa, shortest, width, false);
+      }
+      scale = kGuessScale + 1;
+   }
+
+   for (; scale <= kMaxFastScale; ++scale)
+   {
+      const double scaled = value * kPowersOfTen[scale];
+      if (!(scaled < kMaxExactInteger))
+      {
+         break;
+      }
+      uint64_t mantissa = uint64_t(scaled);
+      if (scaled - double(mantissa) >= 0.5)
+      {
+         ++mantissa;
+      }
+      if (double(mantissa) / kPowersOfTen[scale] == value)
+      {
+         return writeScaled(out, mantissa, scale, width, false);
+      }
+   }
+
+   char text[kMaxDecimalLength];
+   const int length = formatDecimalSlow(text, value);
+   return appendPadded(out, text, length, width);
+}
+
+//===========================================================================
+// Append Fixed
+char* FLUMOREFormat::appendFixed(char* out, double value, int scale, int width)
+{
+   const double scaled = value * kPowersOfTen[scale];
+   if (scaled < kMaxExactInteger)
+   {
+      return writeScaled(out, uint64_t(scaled + 0.5), scale, width, false);
+   }
+
+   char text[kMaxDecimalLength];
+   const int length = snprintf(text, sizeof(text), "%.*f", scale, value);
+   for (int i = 0; i < length; ++i)
+   {
+      if (!isDigit(text[i]))
+      {
+         text[i] = '.';
+      }
+   }
+   return appendPadded(out, text, length, width);
+}
+
+//===========================================================================
+// Append Integer
+char* FLUMOREFormat::appendInteger(char* out, int64_t value, int width)
+{
+   const bool negative = value < 0;
+   const uint64_t magnitude = negative ? uint64_t(0) - uint64_t(value) : uint64_t(value);
+   return writeScaled(out, magnitude, 0, width, negative);
+}
+
+//===========================================================================
+// Append Digits
+char* FLUMOREFormat::appendDigits(char* out, int32_t value, int count)
+{
+   for (int i = count - 1; i >= 0; --i)
+   {
+      out[i] = char('0' + value % 10);
+      value /= 10;
+   }
+   return out + count;
+}
+
+//===========================================================================
+// Valid Date
+bool FLUMOREFormat::validDate(int32_t day, int32_t month, int32_t year, int32_t hour, int32_t minute)
+{
+   static const int32_t kDaysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+   if (year < 1 || month < 1 || month > 12 || hour > 23 || minute > 59 || day < 1)
+   {
+      return false;
+   }
+   const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+   const int32_t days = kDaysInMonth[month - 1] + ((month == 2 && leap) ? 1 : 0);
+   return day <= days;
+}
+
+//===========================================================================
+// Universal Date
+string FLUMOREFormat::universalDate(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute,
+                                    const FLUMORETimeZone& zone)
+{
+   if (zone.kind != kFLUMOREZoneLocal)
+   {
+      const int64_t minutes = daysFromCivil(year, month, day) * 1440 + hour * 60 + minute;
+      splitMinutes(minutes - zoneOffset(zone, year, minutes, false), year, month, day, hour, minute);
+   }
+   else
+   {
+      struct tm local = tm();
+      local.tm_year = year - 1900;
+      local.tm_mon = month - 1;
+      local.tm_mday = day;
+      local.tm_hour = hour;
+      local.tm_min = minute;
+      local.tm_isdst = -1;
+
+      struct tm utc = tm();
+      const time_t seconds = mktime(&local);
+#ifdef WIN32
+      const bool converted = seconds != time_t(-1) && gmtime_s(&utc, &seconds) == 0;
+#else
+      const bool converted = seconds != time_t(-1) && gmtime_r(&seconds, &utc) != NULL;
+#endif
+      if (converted)
+      {
+         year = utc.tm_year + 1900;
+         month = utc.tm_mon + 1;
+         day = utc.tm_mday;
+         hour = utc.tm_hour;
+         minute = utc.tm_min;
+      }
+   }
+
+   char fme[14];
+   appendDigits(fme, year, 4);
+   appendDigits(fme + 4, month, 2);
+   appendDigits(fme + 6, day, 2);
+   appendDigits(fme + 8, hour, 2);
+   appendDigits(fme + 10, minute, 2);
+   appendDigits(fme + 12, 0, 2);
+   return string(fme, sizeof(fme));
+}
+
+//===========================================================================
+// FLUMORE Date
+bool FLUMOREFormat::flumoreDate(const string& value, string& date, string& fmeDate,
+                                const FLUMORETimeZone& zone)
+{
+   int32_t day, month, year, hour, minute;
+   const char* const p = value.c_str();
+
+   // dd.MM.yyyy-HH:mm, e.g. a date attribute written by a workspace.
+   if (value.size() == 16 && p[2] == '.' && p[5] == '.' && p[10] == '-' && p[13] == ':')
+   {
+      if (!readDigits(p, 2, day) || !readDigits(p + 3, 2, month) || !readDigits(p + 6, 4, year) ||
+          !readDigits(p + 11, 2, hour) || !readDigits(p + 14, 2, minute) ||
+          !validDate(day, month, year, hour, minute))
+      {
+         return false;
+      }
+      date = value;
+      fmeDate = universalDate(year, month, day, hour, minute, zone);
+      return true;
+   }
+
+   // yyyyMMddHHmm with optional seconds and fraction, which are dropped.
+   if (value.size() < 12 || !readDigits(p, 4, year) || !readDigits(p + 4, 2, month) ||
+       !readDigits(p + 6, 2, day) || !readDigits(p + 8, 2, hour) || !readDigits(p + 10, 2, minute) ||
+       !validDate(day, month, year, hour, minute))
+   {
+      return false;
+   }
+
+   if (zone.kind != kFLUMOREZoneLocal)
+   {
+      const int64_t minutes = daysFromCivil(year, month, day) * 1440 + hour * 60 + minute;
+      splitMinutes(minutes + zoneOffset(zone, year, minutes, true), year, month, day, hour, minute);
+   }
+   else
+   {
+      struct tm local = tm();
+      local.tm_year = year - 1900;
+      local.tm_mon = month - 1;
+      local.tm_mday = day;
+      local.tm_hour = hour;
+      local.tm_min = minute;
+      if (localDate(local))
+      {
+         year = local.tm_year + 1900;
+         month = local.tm_mon + 1;
+         day = local.tm_mday;
+         hour = local.tm_hour;
+         minute = local.tm_min;
+      }
+   }
+
+   char text[16];
+   appendDigits(text, day, 2);
+   text[2] = '.';
+   appendDigits(text + 3, month, 2);
+   text[5] = '.';
+   appendDigits(text + 6, year, 4);
+   text[10] = '-';
+   appendDigits(text + 11, hour, 2);
+   text[13] = ':';
+   appendDigits(text + 14, minute, 2);
+   date.assign(text, sizeof(text));
+
+   fmeDate.assign(p, 12);
+   fmeDate += "00";
+   return true;
+}
+
+//===========================================================================
+// Parse Time Zone
+bool FLUMOREFormat::parseTimeZone(const string& name, FLUMORETimeZone& zone)
+{
+   string upper;
+   for (size_t i = 0; i < name.size(); ++i)
+   {
+      if (name[i] != ' ')
+      {
+         upper += char(toupper(static_cast<unsigned char>(name[i])));
+      }
+   }
+
+   FLUMORETimeZone parsed;
+   if (upper == "LOCAL")
+   {
+      parsed.kind = kFLUMOREZoneLocal;
+   }
+   else if (upper == "UTC" || upper == "GMT" || upper == "Z")
+   {
+      parsed.kind = kFLUMOREZoneUtc;
+   }
+   else if (upper == "CET" || upper == "CEST" || upper == "MEZ" || upper == "EUROPE/BERLIN")
+   {
+      parsed.kind = kFLUMOREZoneCentralEurope;
+   }
+   else
+   {
+      // [UTC|GMT](+|-)h[h][[:]mm]
+      const char* p = upper.c_str();
+      if (upper.compare(0, 3, "UTC") == 0 || upper.compare(0, 3, "GMT") == 0)
+      {
+         p += 3;
+      }
+      if (*p != '+' && *p != '-')
+      {
+         return false;
+      }
+      const int32_t sign = (*p++ == '-') ? -1 : 1;
+      int32_t hours = 0, minutes = 0;
+      int digits = 0;
+      for (; isDigit(*p) && digits < 2; ++p, ++digits)
+      {
+         hours = hours * 10 + (*p - '0');
+      }
+      if (digits == 0)
+      {
+         return false;
+      }
+      if (*p == ':')
+      {
+         ++p;
+      }
+      if (*p != '\0' && !readDigits(p, 2, minutes))
+      {
+         return false;
+      }
+      if ((*p != '\0' && p[2] != '\0') || hours > 14 || minutes > 59)
+      {
+         return false;
+      }
+      parsed.kind = kFLUMOREZoneFixed;
+      parsed.offset = sign * (hours * 60 + minutes);
+   }
+   zone = parsed;
+   return true;
+}
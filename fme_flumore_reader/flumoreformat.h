@@ -0,0 +1,119 @@
+#ifndef FLUMORE_FORMAT_H
+#define FLUMORE_FORMAT_H
+/*=============================================================================
+
+   Name     : flumoreformat.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREFormat, number and date formatting for
+              the FLUMORE writer
+
+=============================================================================*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+//=====================================================================
+// How the dates of a FLUMORE file relate to UTC.
+enum FLUMORETimeZoneKind
+{
+   kFLUMOREZoneLocal = 0,        // the time zone of this machine, like the F# parser
+   kFLUMOREZoneUtc,              // the dates are UTC
+   kFLUMOREZoneFixed,            // a fixed offset from UTC
+   kFLUMOREZoneCentralEurope     // CET/CEST with the EU daylight saving rules
+};
+
+//=====================================================================
+struct FLUMORETimeZone
+{
+   FLUMORETimeZone() : kind(kFLUMOREZoneLocal), offset(0) {}
+
+   FLUMORETimeZoneKind kind;
+   // Minutes east of UTC for kFLUMOREZoneFixed.
+   int32_t offset;
+};
+
+//=====================================================================
+// FLUMOREFormat
+//
+// Formats the values of a FLUMORE file. The number functions write into
+// a caller owned buffer and return the position behind the text, so the
+// writer can fill large output buffers without any temporary strings.
+class FLUMOREFormat
+{
+
+public:
+
+   // The most characters appendDecimal() writes without padding. The
+   // largest doubles have 309 integer digits.
+   static const size_t kMaxDecimalLength = 352;
+
+   // -----------------------------------------------------------------------
+   // appendDecimal()
+   // Writes value as \d+\.\d+ with the fewest fraction digits which read
+   // back to exactly the same double, right aligned in width characters.
+   // The value must be finite and not negative.
+   static char* appendDecimal(char* out, double value, int width = 0);
+
+   // -----------------------------------------------------------------------
+   // appendFixed()
+   // Writes value rounded to scale fraction digits, right aligned in width
+   // characters. Used where the grammar prescribes the number of digits,
+   // e.g. \d{1,10}\.\d for the situation location.
+   static char* appendFixed(char* out, double value, int scale, int width = 0);
+
+   // -----------------------------------------------------------------------
+   // appendInteger()
+   // Writes value right aligned in width characters.
+   static char* appendInteger(char* out, int64_t value, int width = 0);
+
+   // -----------------------------------------------------------------------
+   // appendDigits()
+   // Writes value with exactly count digits, zero padded.
+   static char* appendDigits(char* out, int32_t value, int count);
+
+   // -----------------------------------------------------------------------
+   // validDate()
+   // Checks the date parts the way DateTime.TryParse would.
+   static bool validDate(int32_t day, int32_t month, int32_t year, int32_t hour, int32_t minute);
+
+   // -----------------------------------------------------------------------
+   // universalDate()
+   // Converts a time of the given zone to UTC and formats it as
+   // yyyyMMddHHmmss. With the local zone this is DateTime.ToUniversalTime
+   // of the F# parser and the time is kept if the conversion fails. Times
+   // which are skipped or repeated when daylight saving time starts or
+   // ends are taken as standard time.
+   static string universalDate(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute,
+                               const FLUMORETimeZone& zone = FLUMORETimeZone());
+
+   // -----------------------------------------------------------------------
+   // flumoreDate()
+   // Converts an FME date yyyyMMddHHmm[ss] in UTC, as set by the reader,
+   // into the dd.MM.yyyy-HH:mm of a FLUMORE file in the given zone. A date
+   // which is already in the FLUMORE form is taken as is. The normalized
+   // UTC date yyyyMMddHHmmss is returned in fmeDate, it sorts
+   // chronologically.
+   static bool flumoreDate(const string& value, string& date, string& fmeDate,
+                           const FLUMORETimeZone& zone = FLUMORETimeZone());
+
+   // -----------------------------------------------------------------------
+   // parseTimeZone()
+   // The zone named LOCAL, UTC, CET (or Europe/Berlin) or given as an
+   // offset such as +01:00, -0330 or UTC+2. Case is ignored.
+   static bool parseTimeZone(const string& name, FLUMORETimeZone& zone);
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREFormat();
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*=============================================================================
+
+   Name     : flumorelog.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMORELog method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorelog.h"
+#include "flumorepriv.h"
+
+#include <ifeature.h>
+#include <ilogfile.h>
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+//===========================================================================
+// Constructor
+FLUMORELog::FLUMORELog()
+:
+   logFile_(NULL),
+   level_(kFLUMORELogSummary),
+   sampleInterval_(kDefaultLogSampleInterval),
+   untilNextSample_(1),
+   featuresRead_(0),
+   featuresLogged_(0),
+   messagesSuppressed_(0),
+   warnings_(0),
+   summaryPending_(FME_FALSE)
+{
+}
+
+//===========================================================================
+// Open
+void FLUMORELog::open(IFMELogFile* logFile)
+{
+   logFile_ = logFile;
+   untilNextSample_ = (level_ == kFLUMORELogFull) ? 1 : sampleInterval_;
+   featuresRead_ = 0;
+   featuresLogged_ = 0;
+   messagesSuppressed_ = 0;
+   warnings_ = 0;
+   summaryPending_ = FME_TRUE;
+}
+
+//===========================================================================
+// Set Level
+FME_Boolean FLUMORELog::setLevel(const string& level)
+{
+   string upper(level);
+   std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+   if (upper == kLogLevelOff)
+   {
+      level_ = kFLUMORELogOff;
+   }
+   else if (upper == kLogLevelSummary)
+   {
+      level_ = kFLUMORELogSummary;
+   }
+   else if (upper == kLogLevelSample)
+   {
+      level_ = kFLUMORELogSample;
+   }
+   else if (upper == kLogLevelFull)
+   {
+      level_ = kFLUMORELogFull;
+   }
+   else
+   {
+      return FME_FALSE;
+   }
+   untilNextSample_ = (level_ == kFLUMORELogFull) ? 1 : sampleInterval_;
+   return FME_TRUE;
+}
+
+//===========================================================================
+// Set Sample Interval
+void FLUMORELog::setSampleInterval(FME_UInt32 interval)
+{
+   sampleInterval_ = (interval == 0) ? 1 : interval;
+   untilNextSample_ = (level_ == kFLUMORELogFull) ? 1 : sampleInterval_;
+}
+
+//===========================================================================
+// Message
+void FLUMORELog::message(const char* msg, FME_MsgLevel severity)
+{
+   if (logFile_ == NULL)
+   {
+      return;
+   }
+   if (severity != FME_INFORM)
+   {
+      ++warnings_;
+   }
+   else if (level_ < kFLUMORELogSummary)
+   {
+      ++messagesSuppressed_;
+      return;
+   }
+   logFile_->logMessageString(msg, severity);
+}
+
+//===========================================================================
+// Detail
+void FLUMORELog::detail(const char* msg)
+{
+   if (logFile_ == NULL)
+   {
+      return;
+   }
+   if (level_ < kFLUMORELogFull)
+   {
+      ++messagesSuppressed_;
+      return;
+   }
+   logFile_->logMessageString(msg, FME_INFORM);
+}
+
+//===========================================================================
+// Log Feature
+void FLUMORELog::logFeature(IFMEFeature& feature)
+{
+   if (logFile_ == NULL)
+   {
+      return;
+   }
+   logFile_->logFeature(feature);
+   ++featuresLogged_;
+   untilNextSample_ = (level_ == kFLUMORELogFull) ? 1 : sampleInterval_;
+}
+
+//===========================================================================
+// Flush
+void FLUMORELog::flush(const string& dataset)
+{
+   if (logFile_ == NULL || !summaryPending_ || level_ < kFLUMORELogSummary)
+   {
+      return;
+   }
+   summaryPending_ = FME_FALSE;
+
+   ostringstream summary;
+   summary << kMsgLogSummary << dataset << ": "
+           << featuresRead_ << " features read, "
+           << featuresLogged_ << " features logged, "
+           << warnings_ << " warnings, "
+           << messagesSuppressed_ << " messages suppressed";
+   logFile_->logMessageString(summary.str().c_str(), FME_INFORM);
+}
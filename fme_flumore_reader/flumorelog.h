@@ -0,0 +1,160 @@
+#ifndef FLUMORE_LOG_H
+#define FLUMORE_LOG_H
+/*=============================================================================
+
+   Name     : flumorelog.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMORELog
+
+=============================================================================*/
+
+#include <fmetypes.h>
+#include <string>
+
+using namespace std;
+
+// Forward declarations
+class IFMEFeature;
+class IFMELogFile;
+
+//=====================================================================
+// The verbosity of the reader log. The values are shared with the Log
+// module of the F# parser, so keep both in sync.
+enum FLUMORELogLevel
+{
+   // Only warnings and errors are logged.
+   kFLUMORELogOff     = 0,
+   // Opening / closing messages and one summary at close().
+   kFLUMORELogSummary = 1,
+   // Like summary, additionally every n-th feature is logged.
+   kFLUMORELogSample  = 2,
+   // Everything, including every single feature.
+   kFLUMORELogFull    = 3
+};
+
+//=====================================================================
+// The severity of the messages of the F# parser, see Log_lastSeverities().
+// The values are shared with the Log module of the F# parser.
+enum FLUMOREParserSeverity
+{
+   kFLUMOREParserInfo    = 0,
+   kFLUMOREParserWarning = 1
+};
+
+//=====================================================================
+// FLUMORELog
+//
+// Keeps logging out of the read() hot path. Features and messages are
+// only counted there; what actually reaches the FME log file depends on
+// the configured level, and the counters are written as one summary
+// when the reader is closed.
+class FLUMORELog
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMORELog();
+
+   // -----------------------------------------------------------------------
+   // open()
+   // Attaches the log file and resets all counters.
+   void open(IFMELogFile* logFile);
+
+   // -----------------------------------------------------------------------
+   // setLevel()
+   // Accepts OFF, SUMMARY, SAMPLE and FULL (case insensitive). Returns
+   // FME_FALSE and keeps the current level for any other value.
+   FME_Boolean setLevel(const string& level);
+
+   // -----------------------------------------------------------------------
+   // setSampleInterval()
+   // Every n-th feature is logged in SAMPLE mode. Zero is treated as one.
+   void setSampleInterval(FME_UInt32 interval);
+
+   // -----------------------------------------------------------------------
+   // level()
+   FLUMORELogLevel level() const { return level_; }
+
+   // -----------------------------------------------------------------------
+   // message()
+   // Informational messages are logged from SUMMARY on, warnings and
+   // errors are always logged.
+   void message(const char* msg, FME_MsgLevel severity = FME_INFORM);
+
+   // -----------------------------------------------------------------------
+   // detail()
+   // Debug output which is only logged in FULL mode.
+   void detail(const char* msg);
+
+   // -----------------------------------------------------------------------
+   // feature()
+   // Counts a feature handed out by the reader and logs it if the level
+   // asks for it. Cheap enough to be called for every feature.
+   void feature(IFMEFeature& feature)
+   {
+      ++featuresRead_;
+      if (level_ >= kFLUMORELogSample && --untilNextSample_ == 0)
+      {
+         logFeature(feature);
+      }
+   }
+
+   // -----------------------------------------------------------------------
+   // flush()
+   // Writes the summary of the counters collected since open().
+   void flush(const string& dataset);
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMORELog(const FLUMORELog&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMORELog &operator=(const FLUMORELog&);
+
+   // -----------------------------------------------------------------------
+   // logFeature()
+   // Logs the feature and rearms the sample counter.
+   void logFeature(IFMEFeature& feature);
+
+   // Data members
+
+   // The FME log file all output goes to, NULL until open(); nothing is
+   // logged then.
+   IFMELogFile* logFile_;
+
+   // The configured verbosity.
+   FLUMORELogLevel level_;
+
+   // Every n-th feature is logged in SAMPLE mode.
+   FME_UInt32 sampleInterval_;
+
+   // Countdown to the next sampled feature.
+   FME_UInt32 untilNextSample_;
+
+   // Number of features passed to feature().
+   FME_UInt64 featuresRead_;
+
+   // Number of features written to the log file.
+   FME_UInt64 featuresLogged_;
+
+   // Number of messages dropped because of the level.
+   FME_UInt64 messagesSuppressed_;
+
+   // Number of warnings and errors seen.
+   FME_UInt64 warnings_;
+
+   // Set by open(), cleared once the summary has been written so closing
+   // a reader twice does not log it twice.
+   FME_Boolean summaryPending_;
+};
+
+#endif
@@ -0,0 +1,1530 @@
+/*=============================================================================
+
+   Name     : flumoreparser.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREParser method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumoreparser.h"
+#include "flumoredecompressor.h"
+#include "flumoreformat.h"
+#include "flumorethreadpool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <locale>
+#include <sstream>
+
+namespace
+{
+   // Number of warnings kept by the parser, further ones are only counted.
+   const size_t kMaxWarnings = 100;
+
+   // Exact powers of ten, 1e22 is the largest one representable as double.
+   const double kPowersOfTen[] =
+   {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+   };
+
+   // Mantissas up to 2^53 are exact doubles.
+   const uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+
+   // The largest number of fractional digits with a fixed scale parser.
+   const int kMaxFixedScale = 6;
+
+   // Digits of a fixed scale value. 15 digits stay below 2^53, so the
+   // result is the same as that of FLUMOREParser::parseDecimal().
+   const ptrdiff_t kMaxFixedDigits = 15;
+
+   //------------------------------------------------------------------------
+   // The characters matched by \s in .NET regular expressions, as far as
+   // they can occur in a single byte encoding.
+   inline bool isSpace(char c)
+   {
+      return c == ' ' || (c >= '\t' && c <= '\r');
+   }
+
+   //------------------------------------------------------------------------
+   inline bool isDigit(char c)
+   {
+      return c >= '0' && c <= '9';
+   }
+
+   //------------------------------------------------------------------------
+   // Characters matched by \w, restricted to ASCII.
+   inline bool isWord(char c)
+   {
+      return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+   }
+
+   //------------------------------------------------------------------------
+   // Skips \s+, fails if there is no whitespace at p.
+   inline bool skipSpaces(const char*& p, const char* end)
+   {
+      const char* start = p;
+      while (p < end && isSpace(*p))
+      {
+         ++p;
+      }
+      return p != start;
+   }
+
+   //------------------------------------------------------------------------
+   // Matches the literal at p and advances p behind it. The length is
+   // known at compile time, so the comparison is inlined.
+   template <size_t N>
+   inline bool skipLiteral(const char*& p, const char* end, const char (&literal)[N])
+   {
+      const size_t length = N - 1;
+      if (size_t(end - p) < length || memcmp(p, literal, length) != 0)
+      {
+         return false;
+      }
+      p += length;
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // The alternatives of the objKind group of the situation pattern.
+   struct SituationKindName
+   {
+      const char* name;
+      size_t length;
+      FLUMORESituationKind kind;
+   };
+
+   template <size_t N>
+   constexpr SituationKindName situationKindName(const char (&name)[N], FLUMORESituationKind kind)
+   {
+      return SituationKindName{ name, N - 1, kind };
+   }
+
+   constexpr SituationKindName kSituationKinds[] =
+   {
+      situationKindName("Ueberstr.",    kFLUMORESituationUeberstr),
+      situationKindName("Bresche",      kFLUMORESituationBresche),
+      situationKindName("Deichentl.",   kFLUMORESituationDeichentl),
+      situationKindName("Folgebruch",   kFLUMORESituationFolgebruch),
+      situationKindName("Innere Entl.", kFLUMORESituationInnereEntl),
+      situationKindName("Linien-SM",    kFLUMORESituationLinienSM),
+      situationKindName("Punkt-SM",     kFLUMORESituationPunktSM)
+   };
+
+   const int kSituationKindCount = int(sizeof(kSituationKinds) / sizeof(kSituationKinds[0]));
+
+   //------------------------------------------------------------------------
+   // The kind whose name starts with c, -1 if there is none. The names
+   // differ in their first character, so one comparison of the whole
+   // name decides the group without trying the alternatives in turn.
+   constexpr int situationKindIndex(char c)
+   {
+      for (int k = 0; k < kSituationKindCount; ++k)
+      {
+         if (kSituationKinds[k].name[0] == c)
+         {
+            return k;
+         }
+      }
+      return -1;
+   }
+
+   //------------------------------------------------------------------------
+   // situationKindIndex() of every character, computed by the compiler.
+   struct SituationKindTable
+   {
+      signed char index[256];
+   };
+
+   constexpr SituationKindTable makeSituationKindTable()
+   {
+      SituationKindTable table = {};
+      for (int c = 0; c < 256; ++c)
+      {
+         table.index[c] = static_cast<signed char>(situationKindIndex(static_cast<char>(c)));
+      }
+      return table;
+   }
+
+   constexpr SituationKindTable kSituationKindTable = makeSituationKindTable();
+
+   inline int situationKindAt(char c)
+   {
+      return kSituationKindTable.index[static_cast<unsigned char>(c)];
+   }
+
+   static_assert(situationKindIndex('U') == 0 && situationKindIndex('P') == kSituationKindCount - 1,
+                 "The situation kinds must start with distinct characters");
+
+   //------------------------------------------------------------------------
+   // Matches \d{min,max} greedily. If the pattern continues with \s the
+   // digits must be followed by whitespace, as backtracking into the
+   // digits can never produce a match then.
+   bool matchDigits(const char*& p, const char* end, int minDigits, int maxDigits,
+                    bool spaceFollows, int64_t& value)
+   {
+      const char* start = p;
+      value = 0;
+      while (p < end && isDigit(*p) && p - start < maxDigits)
+      {
+         value = value * 10 + (*p - '0');
+         ++p;
+      }
+      if (p - start < minDigits)
+      {
+         return false;
+      }
+      return !spaceFollows || (p < end && isSpace(*p));
+   }
+
+   //------------------------------------------------------------------------
+   // Matches exactly count digits.
+   inline bool matchFixedDigits(const char*& p, const char* end, int count, int32_t& value)
+   {
+      int64_t parsed = 0;
+      const char* start = p;
+      if (!matchDigits(p, end, count, count, false, parsed))
+      {
+         p = start;
+         return false;
+      }
+      value = int32_t(parsed);
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Matches \d{1,10}\.\d* (exactly one fractional digit if oneDecimal is
+   // set) followed by whitespace if spaceFollows is set, and converts it.
+   bool matchValue(const char*& p, const char* end, bool oneDecimal, bool spaceFollows,
+                   double& value)
+   {
+      const char* start = p;
+      int64_t integral = 0;
+      if (!matchDigits(p, end, 1, 10, false, integral) || p == end || *p != '.')
+      {
+         return false;
+      }
+      ++p;
+      if (oneDecimal)
+      {
+         if (p == end || !isDigit(*p))
+         {
+            return false;
+         }
+         ++p;
+      }
+      else
+      {
+         while (p < end && isDigit(*p))
+         {
+            ++p;
+         }
+      }
+      if (spaceFollows && (p == end || !isSpace(*p)))
+      {
+         return false;
+      }
+
+      // "12." is a valid match but not a valid number for parseDecimal(),
+      // so convert it with a zero appended.
+      string text(start, p);
+      if (text[text.size() - 1] == '.')
+      {
+         text += '0';
+      }
+      const char* q = text.c_str();
+      return FLUMOREParser::parseDecimal(q, q + text.size(), value);
+   }
+
+   //------------------------------------------------------------------------
+   // Matches [0-9]{2}.[0-9]{2}.[0-9]{4}-[0-9]{2}:[0-9]{2} at p. If strict
+   // is set the separators have to be '.' instead of any character.
+   bool matchDate(const char*& p, const char* end, bool strict, string& date)
+   {
+      const char* start = p;
+      int32_t day, month, year, hour, minute;
+      if (!matchFixedDigits(p, end, 2, day) || p == end || *p == '\n' || (strict && *p != '.'))
+      {
+         return false;
+      }
+      ++p;
+      if (!matchFixedDigits(p, end, 2, month) || p == end || *p == '\n' || (strict && *p != '.'))
+      {
+         return false;
+      }
+      ++p;
+      if (!matchFixedDigits(p, end, 4, year) || !skipLiteral(p, end, "-") ||
+          !matchFixedDigits(p, end, 2, hour) || !skipLiteral(p, end, ":") ||
+          !matchFixedDigits(p, end, 2, minute))
+      {
+         return false;
+      }
+      if (!FLUMOREFormat::validDate(day, month, year, hour, minute))
+      {
+         return false;
+      }
+
+      date.assign(start, p);
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Whether the line has a letter or any other byte from 0x40 on. Every
+   // timestamp, situation and Teilbereich header has one, data rows only
+   // have digits, separators and whitespace. These bytes are the ones
+   // with bit 6 or 7 set, so the line is tested eight bytes at a time.
+   inline bool hasLetter(const char* p, const char* end)
+   {
+      uint64_t bits = 0;
+      for (; end - p >= 8; p += 8)
+      {
+         uint64_t word;
+         memcpy(&word, p, sizeof(word));
+         bits |= word;
+      }
+      for (; p < end; ++p)
+      {
+         bits |= uint64_t(static_cast<unsigned char>(*p));
+      }
+      return (bits & UINT64_C(0xC0C0C0C0C0C0C0C0)) != 0;
+   }
+
+   //------------------------------------------------------------------------
+   // Returns the end of the line starting at p, i.e. the position of the
+   // '\n' or end.
+   inline const char* lineEnd(const char* p, const char* end)
+   {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      return newline ? newline : end;
+   }
+
+   //------------------------------------------------------------------------
+   // Strips a trailing '\r' of a CRLF line.
+   inline const char* trimCarriageReturn(const char* begin, const char* end)
+   {
+      return (end > begin && end[-1] == '\r') ? end - 1 : end;
+   }
+
+   //------------------------------------------------------------------------
+   // Tries the situation pattern at p, the start of the objKind group.
+   bool matchSituationAt(const char* p, const char* end, FLUMORESituation& situation)
+   {
+      const int k = situationKindAt(*p);
+      if (k < 0 || size_t(end - p) < kSituationKinds[k].length ||
+          memcmp(p, kSituationKinds[k].name, kSituationKinds[k].length) != 0)
+      {
+         return false;
+      }
+      p += kSituationKinds[k].length;
+      situation.kind = kSituationKinds[k].kind;
+
+      if (!skipSpaces(p, end))
+      {
+         return false;
+      }
+      int64_t nlp = 0;
+      const char* const nlpStart = p;
+      if (!matchDigits(p, end, 1, 5, true, nlp))
+      {
+         return false;
+      }
+      situation.nlp = int32_t(nlp);
+
+      // (?(?<=\b1) ...): nlp is exactly "1" as it follows whitespace.
+      situation.hasLocation = (p - nlpStart == 1 && *nlpStart == '1');
+      situation.rw = 0.0;
+      situation.hw = 0.0;
+      if (situation.hasLocation)
+      {
+         if (!skipSpaces(p, end) || !matchValue(p, end, true, true, situation.rw) ||
+             !skipSpaces(p, end) || !matchValue(p, end, true, true, situation.hw))
+         {
+            return false;
+         }
+      }
+
+      if (!skipSpaces(p, end))
+      {
+         return false;
+      }
+      switch (situation.kind)
+      {
+      case kFLUMORESituationUeberstr:
+         situation.valueCount = 2;
+         break;
+      case kFLUMORESituationLinienSM:
+      case kFLUMORESituationPunktSM:
+         situation.valueCount = 1;
+         break;
+      default:
+         situation.valueCount = 3;
+      }
+      for (int32_t i = 0; i < situation.valueCount; ++i)
+      {
+         const bool last = (i + 1 == situation.valueCount);
+         if (!matchValue(p, end, false, !last, situation.values[i]))
+         {
+            return false;
+         }
+         if (!last)
+         {
+            skipSpaces(p, end);
+         }
+      }
+      for (int32_t i = situation.valueCount; i < 3; ++i)
+      {
+         situation.values[i] = 0.0;
+      }
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Whether the lines, read as one, contain whitespace followed by the
+   // first two characters of a situation kind. Every match of the
+   // situation pattern does, so lines failing this need not be copied
+   // and matched. ranges holds the begin and end of each line.
+   bool maySituation(const char* const ranges[][2], int lines)
+   {
+      char previous = '\0';
+      bool spaceBeforePrevious = false;
+      for (int i = 0; i < lines; ++i)
+      {
+         // The kinds are letters, so without any only the last two
+         // characters of the line matter for the next one.
+         if (ranges[i][1] - ranges[i][0] >= 2 && !hasLetter(ranges[i][0], ranges[i][1]))
+         {
+            spaceBeforePrevious = isSpace(ranges[i][1][-2]);
+            previous = ranges[i][1][-1];
+            continue;
+         }
+         for (const char* p = ranges[i][0]; p < ranges[i][1]; ++p)
+         {
+            const int k = situationKindAt(previous);
+            if (spaceBeforePrevious && k >= 0 && kSituationKinds[k].name[1] == *p)
+            {
+               return true;
+            }
+            spaceBeforePrevious = isSpace(previous);
+            previous = *p;
+         }
+      }
+      return false;
+   }
+
+   //------------------------------------------------------------------------
+   // Whether the line may hold the start of a situation kind: its first
+   // two characters, or its first one at the end where the next line
+   // may continue it.
+   bool mayHoldSituationKind(const char* p, const char* end)
+   {
+      for (; p < end; ++p)
+      {
+         const int k = situationKindAt(*p);
+         if (k >= 0 && (p + 1 == end || p[1] == kSituationKinds[k].name[1]))
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   //------------------------------------------------------------------------
+   // Converts \d+\.\d+ with the invariant culture, used for the rare
+   // values which cannot be converted exactly by the fast path.
+   bool parseDecimalSlow(const char* begin, const char* end, double& value)
+   {
+      istringstream stream(string(begin, end));
+      stream.imbue(std::locale::classic());
+      stream >> value;
+      return !stream.fail();
+   }
+
+   //------------------------------------------------------------------------
+   // Parses \d+\.\d{Scale} at p and advances p behind it. Fails without
+   // moving p if the value has another number of fractional digits or
+   // too many digits, the caller then uses the general parser.
+   template <int Scale>
+   bool parseFixed(const char*& p, const char* end, double& value)
+   {
+      const char* q = p;
+      uint64_t mantissa = 0;
+      while (q < end && isDigit(*q))
+      {
+         mantissa = mantissa * 10 + uint64_t(*q - '0');
+         ++q;
+      }
+      if (q == p || q - p > kMaxFixedDigits - Scale || end - q <= Scale || *q != '.')
+      {
+         return false;
+      }
+      ++q;
+      for (int i = 0; i < Scale; ++i)
+      {
+         if (!isDigit(q[i]))
+         {
+            return false;
+         }
+         mantissa = mantissa * 10 + uint64_t(q[i] - '0');
+      }
+      q += Scale;
+      if (q < end && isDigit(*q))
+      {
+         return false;
+      }
+      value = double(mantissa) / kPowersOfTen[Scale];
+      p = q;
+      return true;
+   }
+
+   //------------------------------------------------------------------------
+   // Dispatches to the fixed scale parser of scale, which are inlined.
+   inline bool parseScaled(int scale, const char*& p, const char* end, double& value)
+   {
+      switch (scale)
+      {
+      case 1: return parseFixed<1>(p, end, value);
+      case 2: return parseFixed<2>(p, end, value);
+      case 3: return parseFixed<3>(p, end, value);
+      case 4: return parseFixed<4>(p, end, value);
+      case 5: return parseFixed<5>(p, end, value);
+      case 6: return parseFixed<6>(p, end, value);
+      default: return FLUMOREParser::parseDecimal(p, end, value);
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // \s*(\d+)\s*,\s*(\d+\.\d+)\s*, ... ,\s*(\d+\.\d+)\s*
+   // The decimal values are converted by parseValue(column, p, end, value).
+   template <typename ParseValue>
+   bool parseRowWith(const char* begin, const char* end, int32_t& id, double* values,
+                     ParseValue parseValue)
+   {
+      const char* p = begin;
+      while (p < end && isSpace(*p))
+      {
+         ++p;
+      }
+
+      int64_t parsedId = 0;
+      const char* digits = p;
+      while (p < end && isDigit(*p))
+      {
+         parsedId = parsedId * 10 + (*p - '0');
+         if (parsedId > INT_MAX)
+         {
+            return false;
+         }
+         ++p;
+      }
+      if (p == digits)
+      {
+         return false;
+      }
+      id = int32_t(parsedId);
+
+      for (int i = 0; i < 6; ++i)
+      {
+         while (p < end && isSpace(*p))
+         {
+            ++p;
+         }
+         if (p == end || *p != ',')
+         {
+            return false;
+         }
+         ++p;
+         while (p < end && isSpace(*p))
+         {
+            ++p;
+         }
+         if (!parseValue(i, p, end, values[i]))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // The parallel scan gives every thread at least this many bytes.
+   const size_t kMinScanPiece = size_t(4) << 20;
+
+   // The parallel scan keeps the offset of every this many lines.
+   const size_t kLineMarkInterval = 64;
+
+   //------------------------------------------------------------------------
+   // The start of the line after the one at p, or end.
+   inline const char* nextLine(const char* p, const char* end)
+   {
+      const char* eol = lineEnd(p, end);
+      return (eol < end) ? eol + 1 : end;
+   }
+
+   //------------------------------------------------------------------------
+   // The start of the line containing p.
+   inline const char* lineStart(const char* begin, const char* p)
+   {
+      while (p > begin && p[-1] != '\n')
+      {
+         --p;
+      }
+      return p;
+   }
+
+   //------------------------------------------------------------------------
+   // What a line outside the rows of a block is.
+   enum LineKind
+   {
+      kLineUnknown,
+      kLineTimestamp,
+      kLineSituation,
+      kLineTeilbereich
+   };
+
+   //=====================================================================
+   // The header found at a line and the values matched from it.
+   struct LineMatch
+   {
+      LineKind kind;
+      FLUMORETimestamp timestamp;
+      FLUMORESituation situation;
+      FLUMOREBlock block;
+   };
+
+   //------------------------------------------------------------------------
+   // Tries the header patterns on the line at p in the order of the F#
+   // parser. The situation header spans this and the two following lines,
+   // which are matched as one; at least one of them has to exist.
+   // Without a letter in the line itself, see hasLetter(), only the
+   // situation can match. situationLines is scratch space.
+   LineKind matchLine(const char* p, const char* end, bool letters, string& situationLines,
+                      LineMatch& match)
+   {
+      const char* eol = lineEnd(p, end);
+      const char* contentEnd = trimCarriageReturn(p, eol);
+      const char* next = (eol < end) ? eol + 1 : end;
+
+      match.kind = kLineUnknown;
+      if (letters && FLUMOREParser::matchTimestamp(p, contentEnd, match.timestamp))
+      {
+         match.kind = kLineTimestamp;
+         return match.kind;
+      }
+
+      if (next < end)
+      {
+         const char* second = next;
+         const char* secondEol = lineEnd(second, end);
+         const char* third = (secondEol < end) ? secondEol + 1 : end;
+         const char* thirdEol = lineEnd(third, end);
+         const char* const ranges[3][2] =
+         {
+            { p, contentEnd },
+            { second, trimCarriageReturn(second, secondEol) },
+            { third, trimCarriageReturn(third, thirdEol) }
+         };
+         if (maySituation(ranges, 3))
+         {
+            situationLines.assign(ranges[0][0], ranges[0][1]);
+            situationLines.append(ranges[1][0], ranges[1][1]);
+            situationLines.append(ranges[2][0], ranges[2][1]);
+            if (FLUMOREParser::matchSituation(situationLines, match.situation))
+            {
+               match.kind = kLineSituation;
+               return match.kind;
+            }
+         }
+      }
+
+      if (letters && FLUMOREParser::matchTeilbereich(p, contentEnd, match.block))
+      {
+         match.kind = kLineTeilbereich;
+      }
+      return match.kind;
+   }
+
+   //=====================================================================
+   // A header found by the parallel scan. The line number is relative to
+   // its piece until the pieces are put together and may be negative for
+   // the two lines before the piece.
+   struct ScanHeader
+   {
+      int64_t line;
+      size_t offset;
+      LineMatch match;
+   };
+
+   //=====================================================================
+   // A byte range of the parallel scan, starting at a line start.
+   struct ScanPiece
+   {
+      size_t begin;
+      size_t end;
+      // The number of lines starting within the range and the number of
+      // the first one in the file.
+      size_t lines;
+      size_t firstLine;
+      // The offset of every kLineMarkInterval-th line of the range.
+      vector<size_t> marks;
+      // The headers at the lines with a letter and the two lines before
+      // each of them, where a situation could begin. The same header is
+      // found by the sequential scan if it reaches the line.
+      vector<ScanHeader> headers;
+   };
+
+   //------------------------------------------------------------------------
+   // Moves header into headers, which are ordered by line, unless the
+   // line is there already. Only the lines before a piece come out of
+   // order.
+   void addHeader(vector<ScanHeader>& headers, ScanHeader& header)
+   {
+      vector<ScanHeader>::iterator position = headers.end();
+      while (position != headers.begin() && (position - 1)->line >= header.line)
+      {
+         --position;
+      }
+      if (position == headers.end() || position->line != header.line)
+      {
+         headers.insert(position, std::move(header));
+      }
+   }
+
+   //------------------------------------------------------------------------
+   // Counts the lines of piece and matches the headers it may contain,
+   // without knowing what the lines before it are. begin and end are the
+   // whole buffer, the situation window may cross the end of the piece.
+   // Every line with a letter is tried. A line without one can only begin
+   // a situation whose kind is in one of the two lines after it, so it is
+   // only tried if one of them may hold a kind.
+   void scanPiece(const char* begin, const char* end, bool first, ScanPiece& piece)
+   {
+      // The starts of the line before the previous one, the previous and
+      // the current line and whether they have letters. Before the first
+      // line of the file there is the package header, which is no
+      // candidate.
+      const char* recent[3] = { NULL, NULL, NULL };
+      bool letters[3] = { true, true, false };
+      if (!first)
+      {
+         recent[1] = lineStart(begin, begin + piece.begin - 1);
+         recent[0] = (recent[1] > begin) ? lineStart(begin, recent[1] - 1) : NULL;
+         for (int i = 0; i < 2; ++i)
+         {
+            letters[i] = recent[i] == NULL || hasLetter(recent[i], lineEnd(recent[i], end));
+         }
+      }
+
+      const char* const pieceEnd = begin + piece.end;
+      const char* p = begin + piece.begin;
+      int64_t line = 0;
+      // The last line without letters tried.
+      int64_t tried = -3;
+      string situationLines;
+      while (p < pieceEnd)
+      {
+         if (size_t(line) % kLineMarkInterval == 0)
+         {
+            piece.marks.push_back(size_t(p - begin));
+         }
+         const char* eol = lineEnd(p, pieceEnd);
+         recent[2] = p;
+         letters[2] = hasLetter(p, eol);
+         if (letters[2])
+         {
+            const int64_t from = mayHoldSituationKind(p, trimCarriageReturn(p, eol)) ? line - 2 : line;
+            for (int64_t candidate = from; candidate <= line; ++candidate)
+            {
+               const int i = int(candidate - line + 2);
+               if (candidate < line && (letters[i] || candidate <= tried))
+               {
+                  continue;
+               }
+               ScanHeader header;
+               if (matchLine(recent[i], end, letters[i], situationLines, header.match) != kLineUnknown)
+               {
+                  header.line = candidate;
+                  header.offset = size_t(recent[i] - begin);
+                  addHeader(piece.headers, header);
+               }
+               if (!letters[i])
+               {
+                  tried = candidate;
+               }
+            }
+         }
+         recent[0] = recent[1];
+         recent[1] = recent[2];
+         letters[0] = letters[1];
+         letters[1] = letters[2];
+         p = (eol < pieceEnd) ? eol + 1 : pieceEnd;
+         ++line;
+      }
+      piece.lines = size_t(line);
+   }
+}
+
+//===========================================================================
+// Columns: Clear
+void FLUMOREColumns::clear()
+{
+   id.clear();
+   x.clear();
+   y.clear();
+   z.clear();
+   wsp.clear();
+   h.clear();
+   vres.clear();
+}
+
+//===========================================================================
+// Columns: Reserve
+void FLUMOREColumns::reserve(size_t rows)
+{
+   id.reserve(rows);
+   x.reserve(rows);
+   y.reserve(rows);
+   z.reserve(rows);
+   wsp.reserve(rows);
+   h.reserve(rows);
+   vres.reserve(rows);
+}
+
+//===========================================================================
+// Constructor
+FLUMOREParser::FLUMOREParser()
+:
+   warningCount_(0)
+{
+   header_.timesteps = 0;
+   header_.variant = 0;
+   header_.counter = 0;
+}
+
+//===========================================================================
+// Load
+bool FLUMOREParser::load(const string& path, size_t threads)
+{
+   buffer_.clear();
+   error_.clear();
+
+   if (!file_.read(path, buffer_))
+   {
+      error_ = file_.error();
+      return false;
+   }
+
+   // Compressed files are recognized by their content, not their name.
+   if (FLUMOREDecompressor::detect(buffer_.data(), buffer_.size()) != kFLUMORECompressionNone)
+   {
+      vector<char> text;
+      string error;
+      if (!FLUMOREDecompressor::decompress(buffer_, text, threads, error))
+      {
+         vector<char>().swap(buffer_);
+         error_ = "Could not unpack " + path + ": " + error;
+         return false;
+      }
+      buffer_.swap(text);
+   }
+   return true;
+}
+
+//===========================================================================
+// Assign
+void FLUMOREParser::assign(vector<char>& text)
+{
+   buffer_.swap(text);
+   error_.clear();
+}
+
+//===========================================================================
+// Clear
+void FLUMOREParser::clear()
+{
+   vector<char>().swap(buffer_);
+   vector<FLUMORETimestamp>().swap(timestamps_);
+   vector<FLUMORESituation>().swap(situations_);
+   vector<FLUMOREBlock>().swap(blocks_);
+   fmeDates_.clear();
+   warnings_.clear();
+   warningCount_ = 0;
+   error_.clear();
+}
+
+//===========================================================================
+// Set Time Zone
+void FLUMOREParser::setTimeZone(const FLUMORETimeZone& zone)
+{
+   timeZone_ = zone;
+   fmeDates_.clear();
+}
+
+//===========================================================================
+// Warn
+void FLUMOREParser::warn(const string& message)
+{
+   if (warnings_.size() < kMaxWarnings)
+   {
+      warnings_.push_back(message);
+   }
+   ++warningCount_;
+}
+
+//===========================================================================
+// Warn Line
+void FLUMOREParser::warnLine(size_t line, const char* begin, const char* end)
+{
+   if (end != begin)
+   {
+      ostringstream msg;
+      msg << "Parsing line " << line << " with content \"" << string(begin, end) << "\" failed";
+      warn(msg.str());
+   }
+}
+
+//===========================================================================
+// Add Timestamp
+void FLUMOREParser::addTimestamp(const FLUMORETimestamp& timestamp)
+{
+   timestamps_.push_back(timestamp);
+   const string& date = timestamp.date;
+   map<string, string>::iterator found = fmeDates_.find(date);
+   if (found == fmeDates_.end())
+   {
+      // matchTimestamp() found dd?MM?yyyy-HH:mm with valid digits.
+      const char* const p = date.c_str();
+      const auto number = [p](size_t at, size_t count)
+      {
+         int32_t value = 0;
+         for (size_t i = at; i < at + count; ++i)
+         {
+            value = value * 10 + (p[i] - '0');
+         }
+         return value;
+      };
+      const string fmeDate = FLUMOREFormat::universalDate(number(6, 4), number(3, 2), number(0, 2),
+                                                          number(11, 2), number(14, 2), timeZone_);
+      found = fmeDates_.insert(make_pair(date, fmeDate)).first;
+   }
+   timestamps_.back().fmeDate = found->second;
+}
+
+//===========================================================================
+// Add Block
+void FLUMOREParser::addBlock(FLUMOREBlock& block, int32_t rows)
+{
+   if (rows < block.count)
+   {
+      ostringstream msg;
+      msg << "Teilbereich in line " << block.line << " announces " << block.count
+          << " rows but the file ends after " << rows;
+      warn(msg.str());
+      block.count = rows;
+   }
+   blocks_.push_back(block);
+}
+
+//===========================================================================
+// Scan
+bool FLUMOREParser::scan(size_t threads)
+{
+   timestamps_.clear();
+   situations_.clear();
+   blocks_.clear();
+   warnings_.clear();
+   warningCount_ = 0;
+   error_.clear();
+
+   const char* const begin = data();
+   const char* const end = begin + buffer_.size();
+   const char* p = begin;
+
+   const char* eol = lineEnd(p, end);
+   if (!matchPackageHeader(p, trimCarriageReturn(p, eol), header_))
+   {
+      error_ = "The first line is not a FLUMORE header";
+      return false;
+   }
+   p = (eol < end) ? eol + 1 : end;
+
+   if (threads == 0)
+   {
+      threads = FLUMOREThreadPool::defaultThreads();
+   }
+   threads = std::min(threads, size_t(end - p) / kMinScanPiece);
+   if (threads > 1)
+   {
+      scanPieces(p, threads);
+   }
+   else
+   {
+      scanLines(p);
+   }
+   return true;
+}
+
+//===========================================================================
+// Scan Lines
+void FLUMOREParser::scanLines(const char* p)
+{
+   const char* const begin = data();
+   const char* const end = begin + buffer_.size();
+
+   int32_t timestamp = -1;
+   int32_t situation = -1;
+   size_t line = 1;
+   string situationLines;
+   LineMatch match;
+
+   while (p < end)
+   {
+      switch (matchLine(p, end, true, situationLines, match))
+      {
+      case kLineTimestamp:
+         addTimestamp(match.timestamp);
+         timestamp = int32_t(timestamps_.size() - 1);
+         situation = -1;
+         p = nextLine(p, end);
+         ++line;
+         break;
+
+      case kLineSituation:
+         situations_.push_back(match.situation);
+         situation = int32_t(situations_.size() - 1);
+         p = nextLine(nextLine(nextLine(p, end), end), end);
+         line += 3;
+         break;
+
+      case kLineTeilbereich:
+      {
+         FLUMOREBlock& block = match.block;
+         block.timestamp = timestamp;
+         block.situation = situation;
+         block.line = line;
+
+         // Skip the column definition line, the rows follow.
+         p = nextLine(nextLine(p, end), end);
+         block.begin = size_t(p - begin);
+         int32_t rows = 0;
+         while (rows < block.count && p < end)
+         {
+            p = nextLine(p, end);
+            ++rows;
+         }
+         block.end = size_t(p - begin);
+         addBlock(block, rows);
+         line += 2 + size_t(rows);
+         break;
+      }
+
+      default:
+      {
+         const char* eol = lineEnd(p, end);
+         warnLine(line, p, trimCarriageReturn(p, eol));
+         p = (eol < end) ? eol + 1 : end;
+         ++line;
+         break;
+      }
+      }
+   }
+}
+
+//===========================================================================
+// Scan Pieces
+void FLUMOREParser::scanPieces(const char* p, size_t threads)
+{
+   const char* const begin = data();
+   const char* const end = begin + buffer_.size();
+
+   // Equal byte ranges, each moved to the next line start.
+   vector<ScanPiece> pieces;
+   const size_t first = size_t(p - begin);
+   size_t start = first;
+   for (size_t i = 1; i <= threads && start < buffer_.size(); ++i)
+   {
+      size_t stop = buffer_.size();
+      if (i < threads)
+      {
+         const size_t target = first + (buffer_.size() - first) / threads * i;
+         const char* newline = lineEnd(begin + std::max(target, start + 1) - 1, end);
+         stop = (newline < end) ? size_t(newline - begin) + 1 : buffer_.size();
+      }
+      pieces.push_back(ScanPiece());
+      pieces.back().begin = start;
+      pieces.back().end = stop;
+      start = stop;
+   }
+
+   FLUMOREThreadPool::forEach(pieces.size(), threads, [&](size_t i)
+   {
+      scanPiece(begin, end, i == 0, pieces[i]);
+      return true;
+   });
+
+   // Number the lines and put the headers in order. The lines before a
+   // piece may have been tried by the piece before as well.
+   vector<ScanHeader> headers;
+   size_t lines = 1;
+   for (size_t i = 0; i < pieces.size(); ++i)
+   {
+      ScanPiece& piece = pieces[i];
+      piece.firstLine = lines;
+      for (size_t h = 0; h < piece.headers.size(); ++h)
+      {
+         ScanHeader& header = piece.headers[h];
+         header.line += int64_t(lines);
+         addHeader(headers, header);
+      }
+      vector<ScanHeader>().swap(piece.headers);
+      lines += piece.lines;
+   }
+
+   // The offset of a line, from the headers or the marks of its piece.
+   const auto lineOffset = [&](size_t line) -> size_t
+   {
+      if (line >= lines)
+      {
+         return buffer_.size();
+      }
+      const auto header = std::lower_bound(headers.begin(), headers.end(), line,
+         [](const ScanHeader& h, size_t l) { return h.line < int64_t(l); });
+      if (header != headers.end() && header->line == int64_t(line))
+      {
+         return header->offset;
+      }
+      size_t i = pieces.size() - 1;
+      while (pieces[i].firstLine > line)
+      {
+         --i;
+      }
+      const size_t local = line - pieces[i].firstLine;
+      const char* q = begin + pieces[i].marks[local / kLineMarkInterval];
+      for (size_t skip = local % kLineMarkInterval; skip > 0; --skip)
+      {
+         q = nextLine(q, end);
+      }
+      return size_t(q - begin);
+   };
+
+   // Walk the lines like scanLines() does, jumping from header to header.
+   // Headers within the rows of a block or a situation are left out, the
+   // lines between the headers are unknown.
+   int32_t timestamp = -1;
+   int32_t situation = -1;
+   size_t line = 1;
+   size_t h = 0;
+   while (line < lines)
+   {
+      while (h < headers.size() && headers[h].line < int64_t(line))
+      {
+         ++h;
+      }
+      const size_t next = (h < headers.size()) ? size_t(headers[h].line) : lines;
+      for (; line < next; ++line)
+      {
+         const char* eol = lineEnd(p, end);
+         warnLine(line, p, trimCarriageReturn(p, eol));
+         p = (eol < end) ? eol + 1 : end;
+      }
+      if (line == lines)
+      {
+         break;
+      }
+
+      LineMatch& match = headers[h].match;
+      switch (match.kind)
+      {
+      case kLineTimestamp:
+         addTimestamp(match.timestamp);
+         timestamp = int32_t(timestamps_.size() - 1);
+         situation = -1;
+         p = nextLine(p, end);
+         ++line;
+         break;
+
+      case kLineSituation:
+         situations_.push_back(match.situation);
+         situation = int32_t(situations_.size() - 1);
+         p = nextLine(nextLine(nextLine(p, end), end), end);
+         line += 3;
+         break;
+
+      default:
+      {
+         FLUMOREBlock& block = match.block;
+         block.timestamp = timestamp;
+         block.situation = situation;
+         block.line = line;
+
+         p = nextLine(nextLine(p, end), end);
+         block.begin = size_t(p - begin);
+         const size_t rowsLine = line + 2;
+         const int32_t rows = (rowsLine < lines)
+                            ? int32_t(std::min(size_t(block.count), lines - rowsLine)) : 0;
+         block.end = lineOffset(rowsLine + size_t(rows));
+         p = begin + block.end;
+         addBlock(block, rows);
+         line = rowsLine + size_t(rows);
+         break;
+      }
+      }
+   }
+}
+
+//===========================================================================
+// Decode
+size_t FLUMOREParser::decode(const FLUMOREBlock& block, FLUMOREColumns& columns) const
+{
+   const char* p = data() + block.begin;
+   const char* const end = data() + block.end;
+
+   columns.reserve(columns.size() + size_t(block.count));
+
+   // The columns nearly always keep their number of fractional digits
+   // within a block. They are taken from the first row and again from
+   // any row which doesn't fit them; such rows use the general parser.
+   // 0 if a column has no fixed scale.
+   int scales[6];
+   bool haveScales = false;
+   const auto parseFixedRow = [&scales](int column, const char*& p, const char* end, double& value)
+   {
+      return parseScaled(scales[column], p, end, value);
+   };
+   const auto parseDetect = [&scales](int column, const char*& p, const char* end, double& value)
+   {
+      const char* const start = p;
+      if (!parseDecimal(p, end, value))
+      {
+         return false;
+      }
+      const char* point = p;
+      while (*--point != '.')
+      {
+      }
+      const ptrdiff_t scale = p - point - 1;
+      scales[column] = (scale <= kMaxFixedScale && p - start - 1 <= kMaxFixedDigits) ? int(scale) : 0;
+      return true;
+   };
+
+   size_t rejected = 0;
+   int32_t id = 0;
+   double values[6];
+   while (p < end)
+   {
+      const char* eol = lineEnd(p, end);
+      bool parsed = haveScales && parseRowWith(p, eol, id, values, parseFixedRow);
+      if (!parsed)
+      {
+         parsed = parseRowWith(p, eol, id, values, parseDetect);
+         haveScales = parsed;
+      }
+      if (parsed)
+      {
+         columns.id.push_back(id);
+         columns.x.push_back(values[0]);
+         columns.y.push_back(values[1]);
+         columns.z.push_back(values[2]);
+         columns.wsp.push_back(values[3]);
+         columns.h.push_back(values[4]);
+         columns.vres.push_back(values[5]);
+      }
+      else
+      {
+         ++rejected;
+      }
+      p = (eol < end) ? eol + 1 : end;
+   }
+   return rejected;
+}
+
+//===========================================================================
+// Match Package Header
+// FLUMORE\s+(\d{2}\.\d{2}\.\d{4}\-\d{2}\:\d{2})\s+(\d{1,3})\s+N(\d{3})\-P(\d{3})
+bool FLUMOREParser::matchPackageHeader(const char* begin, const char* end,
+                                       FLUMOREPackageHeader& header)
+{
+   for (const char* start = begin; start < end; ++start)
+   {
+      const char* p = start;
+      if (!skipLiteral(p, end, "FLUMORE") || !skipSpaces(p, end))
+      {
+         continue;
+      }
+      string date;
+      int64_t timesteps = 0;
+      int32_t variant = 0, counter = 0;
+      if (matchDate(p, end, true, date) && skipSpaces(p, end) &&
+          matchDigits(p, end, 1, 3, true, timesteps) && skipSpaces(p, end) &&
+          skipLiteral(p, end, "N") && matchFixedDigits(p, end, 3, variant) &&
+          skipLiteral(p, end, "-P") && matchFixedDigits(p, end, 3, counter))
+      {
+         header.created = date;
+         header.timesteps = int32_t(timesteps);
+         header.variant = variant;
+         header.counter = counter;
+         return true;
+      }
+   }
+   return false;
+}
+
+//===========================================================================
+// Match Timestamp
+// \s?(date)\s+([SIM|VHS|SZO]{3})\s+(\d{1,5})\s+(\d{1,5})
+bool FLUMOREParser::matchTimestamp(const char* begin, const char* end, FLUMORETimestamp& timestamp)
+{
+   for (const char* start = begin; start < end; ++start)
+   {
+      if (!isDigit(*start))
+      {
+         continue;
+      }
+      const char* p = start;
+      if (!matchDate(p, end, false, timestamp.date) || !skipSpaces(p, end))
+      {
+         continue;
+      }
+
+      // The character class accepts any three of S I M | V H Z O, only the
+      // three kinds are valid though. Like the regex the first match wins.
+      const char* kind = p;
+      int32_t i = 0;
+      for (; i < 3 && p < end && *p != '\0' && strchr("SIM|VHZO", *p) != NULL; ++i)
+      {
+         ++p;
+      }
+      int64_t subspanCount = 0, count2D = 0;
+      if (i < 3 || !skipSpaces(p, end) ||
+          !matchDigits(p, end, 1, 5, true, subspanCount) || !skipSpaces(p, end) ||
+          !matchDigits(p, end, 1, 5, false, count2D))
+      {
+         continue;
+      }
+
+      if (memcmp(kind, "SIM", 3) == 0)
+      {
+         timestamp.kind = kFLUMORETimestampSimulation;
+      }
+      else if (memcmp(kind, "VHS", 3) == 0)
+      {
+         timestamp.kind = kFLUMORETimestampPrediction;
+      }
+      else if (memcmp(kind, "SZO", 3) == 0)
+      {
+         timestamp.kind = kFLUMORETimestampScenario;
+      }
+      else
+      {
+         return false;
+      }
+      timestamp.subspanCount = int32_t(subspanCount);
+      timestamp.count2D = int32_t(count2D);
+      return true;
+   }
+   return false;
+}
+
+//===========================================================================
+// Match Situation
+// \s+(Ueberstr\.|Bresche|...)\s+(\d{1,5})(?(?<=\b1)\s+rw\s+hw)\s+values
+bool FLUMOREParser::matchSituation(const string& lines, FLUMORESituation& situation)
+{
+   const char* const begin = lines.c_str();
+   const char* const end = begin + lines.size();
+   const char* p = begin;
+   while (p < end)
+   {
+      if (!isSpace(*p))
+      {
+         ++p;
+         continue;
+      }
+      skipSpaces(p, end);
+      if (p < end && matchSituationAt(p, end, situation))
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+//===========================================================================
+// Match Teilbereich
+// \bTeilbereich\s+(\d{1,10})\s+TB(\d{3})\-V(\d{2})
+bool FLUMOREParser::matchTeilbereich(const char* begin, const char* end, FLUMOREBlock& block)
+{
+   for (const char* start = begin; start < end; ++start)
+   {
+      if (*start != 'T' || (start > begin && isWord(start[-1])))
+      {
+         continue;
+      }
+      const char* p = start;
+      int64_t count = 0;
+      if (skipLiteral(p, end, "Teilbereich") && skipSpaces(p, end) &&
+          matchDigits(p, end, 1, 10, true, count) && skipSpaces(p, end) &&
+          skipLiteral(p, end, "TB") && matchFixedDigits(p, end, 3, block.id) &&
+          skipLiteral(p, end, "-V") && matchFixedDigits(p, end, 2, block.version))
+      {
+         // Convert.tryToInt32 rejects counts which do not fit.
+         if (count > INT_MAX)
+         {
+            return false;
+         }
+         block.count = int32_t(count);
+         block.timestamp = -1;
+         block.situation = -1;
+         block.line = 0;
+         block.begin = 0;
+         block.end = 0;
+         return true;
+      }
+   }
+   return false;
+}
+
+//===========================================================================
+// Parse Row
+// \s*(\d+)\s*,\s*(\d+\.\d+)\s*, ... ,\s*(\d+\.\d+)\s*
+bool FLUMOREParser::parseRow(const char* begin, const char* end, int32_t& id, double* values)
+{
+   return parseRowWith(begin, end, id, values,
+                       [](int, const char*& p, const char* end, double& value)
+                       {
+                          return parseDecimal(p, end, value);
+                       });
+}
+
+//===========================================================================
+// Parse Decimal
+bool FLUMOREParser::parseDecimal(const char*& p, const char* end, double& value)
+{
+   const char* const start = p;
+   uint64_t mantissa = 0;
+   int significant = 0;
+
+   while (p < end && isDigit(*p))
+   {
+      if (significant < 19)
+      {
+         mantissa = mantissa * 10 + uint64_t(*p - '0');
+         if (mantissa != 0)
+         {
+            ++significant;
+         }
+      }
+      else
+      {
+         significant = 20;
+      }
+      ++p;
+   }
+   if (p == start || p == end || *p != '.')
+   {
+      p = start;
+      return false;
+   }
+   ++p;
+
+   const char* const fraction = p;
+   while (p < end && isDigit(*p))
+   {
+      if (significant < 19)
+      {
+         mantissa = mantissa * 10 + uint64_t(*p - '0');
+         if (mantissa != 0)
+         {
+            ++significant;
+         }
+      }
+      else
+      {
+         significant = 20;
+      }
+      ++p;
+   }
+   const ptrdiff_t scale = p - fraction;
+   if (scale == 0)
+   {
+      p = start;
+      return false;
+   }
+
+   // Both operands are exact, so the division is correctly rounded.
+   if (significant < 19 && mantissa <= kMaxExactMantissa && scale <= 22)
+   {
+      value = double(mantissa) / kPowersOfTen[scale];
+      return true;
+   }
+   return parseDecimalSlow(start, p, value);
+}
+
+//===========================================================================
+// Partition
+void FLUMOREParser::partition(const vector<FLUMOREBlock>& blocks, FLUMOREPartitionUnit unit, size_t index,
+                              size_t count, vector<size_t>& selected)
+{
+   selected.clear();
+   if (count == 0 || index >= count)
+   {
+      return;
+   }
+   // Every block weighs at least one row, so empty blocks are spread too.
+   const auto weight = [](const FLUMOREBlock& block) { return uint64_t(std::max(block.count, 0)) + 1; };
+   uint64_t total = 0;
+   for (size_t b = 0; b < blocks.size(); ++b)
+   {
+      total += weight(blocks[b]);
+   }
+
+   uint64_t before = 0;
+   size_t first = 0;
+   while (first < blocks.size())
+   {
+      size_t last = first + 1;
+      uint64_t rows = weight(blocks[first]);
+      if (unit == kFLUMOREPartitionTimestep)
+      {
+         for (; last < blocks.size() && blocks[last].timestamp == blocks[first].timestamp; ++last)
+         {
+            rows += weight(blocks[last]);
+         }
+      }
+      // The unit belongs to the partition its middle row falls into.
+      const uint64_t owner = std::min((2 * before + rows) * count / (2 * total), uint64_t(count - 1));
+      if (owner == index)
+      {
+         for (size_t b = first; b < last; ++b)
+         {
+            selected.push_back(b);
+         }
+      }
+      before += rows;
+      first = last;
+   }
+}
+
+//===========================================================================
+// Parse Partition Unit
+bool FLUMOREParser::parsePartitionUnit(const string& name, FLUMOREPartitionUnit& unit)
+{
+   if (name == "BLOCK")
+   {
+      unit = kFLUMOREPartitionBlock;
+   }
+   else if (name == "TIMESTEP")
+   {
+      unit = kFLUMOREPartitionTimestep;
+   }
+   else
+   {
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,320 @@
+#ifndef FLUMORE_PARSER_H
+#define FLUMORE_PARSER_H
+/*=============================================================================
+
+   Name     : flumoreparser.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREParser, the native FLUMORE parser
+
+=============================================================================*/
+
+#include "flumorefilereader.h"
+#include "flumoreformat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// The first line of a FLUMORE file, e.g.
+//    FLUMORE 01.03.2017-12:00 24 N001-P001
+struct FLUMOREPackageHeader
+{
+   // The creation date as written in the file, dd.MM.yyyy-HH:mm.
+   string created;
+   int32_t timesteps;
+   int32_t variant;
+   int32_t counter;
+};
+
+//=====================================================================
+// The kind of a timestamp header.
+enum FLUMORETimestampKind
+{
+   kFLUMORETimestampSimulation = 0,   // SIM
+   kFLUMORETimestampPrediction,       // VHS
+   kFLUMORETimestampScenario          // SZO
+};
+
+//=====================================================================
+// A timestamp header line, e.g.
+//    01.03.2017-13:00 SIM 3 6
+struct FLUMORETimestamp
+{
+   // The date as written in the file, dd.MM.yyyy-HH:mm.
+   string date;
+   // The same date converted from the time zone of the parser to UTC in
+   // the FME representation, yyyyMMddHHmmss.
+   string fmeDate;
+   FLUMORETimestampKind kind;
+   int32_t subspanCount;
+   int32_t count2D;
+};
+
+//=====================================================================
+// The kind of a situation (sub span) header, see SituationIdentifier
+// in Definitions.fs.
+enum FLUMORESituationKind
+{
+   kFLUMORESituationUeberstr = 0,     // Ueberstr.
+   kFLUMORESituationBresche,          // Bresche
+   kFLUMORESituationDeichentl,        // Deichentl.
+   kFLUMORESituationFolgebruch,       // Folgebruch
+   kFLUMORESituationInnereEntl,       // Innere Entl.
+   kFLUMORESituationLinienSM,         // Linien-SM
+   kFLUMORESituationPunktSM           // Punkt-SM
+};
+
+//=====================================================================
+// A situation header spanning three lines. Depending on the kind the
+// values are (hm, q), (smw) or (bb, btm, q).
+struct FLUMORESituation
+{
+   FLUMORESituationKind kind;
+   int32_t nlp;
+   // Only set if nlp is 1.
+   bool hasLocation;
+   double rw;
+   double hw;
+   double values[3];
+   int32_t valueCount;
+};
+
+//=====================================================================
+// A Teilbereich block, i.e. the line "Teilbereich <count> TBnnn-Vnn",
+// the column definition line and <count> data rows.
+struct FLUMOREBlock
+{
+   // Index into FLUMOREParser::timestamps(), -1 if there was none yet.
+   int32_t timestamp;
+   // Index into FLUMOREParser::situations(), -1 if there was none yet
+   // within the current timestamp.
+   int32_t situation;
+   // The number of rows announced by the Teilbereich line.
+   int32_t count;
+   int32_t id;
+   int32_t version;
+   // Zero based line number of the Teilbereich line.
+   size_t line;
+   // Byte range of the data rows within the buffer.
+   size_t begin;
+   size_t end;
+};
+
+//=====================================================================
+// What FLUMOREParser::partition() hands out to the partitions: single
+// Teilbereich blocks or timesteps with all their blocks.
+enum FLUMOREPartitionUnit
+{
+   kFLUMOREPartitionBlock = 0,
+   kFLUMOREPartitionTimestep
+};
+
+//=====================================================================
+// The decoded rows of a block, one vector per column.
+struct FLUMOREColumns
+{
+   vector<int32_t> id;
+   vector<double> x;
+   vector<double> y;
+   vector<double> z;
+   vector<double> wsp;
+   vector<double> h;
+   vector<double> vres;
+
+   size_t size() const { return id.size(); }
+   void clear();
+   void reserve(size_t rows);
+};
+
+//=====================================================================
+// FLUMOREParser
+//
+// Parses FLUMORE files without the F# parser. The work is split into
+// stages which can be run and timed separately:
+//   load()   reads the whole file into memory, unpacking it if needed,
+//   scan()   finds the headers and the byte ranges of all blocks,
+//   decode() turns the rows of one block into columns.
+// decode() is const and may run for several blocks in parallel.
+// Errors are reported by the return value; error() describes them.
+class FLUMOREParser
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREParser();
+
+   // -----------------------------------------------------------------------
+   // load()
+   // Reads the file into the internal buffer with fileReader(). gzip and
+   // zstd files are unpacked on up to threads threads, those of the
+   // shared pool if it is 0.
+   bool load(const string& path, size_t threads = 0);
+
+   // -----------------------------------------------------------------------
+   // assign()
+   // Takes over an in-memory FLUMORE text instead of loading a file.
+   void assign(vector<char>& text);
+
+   // -----------------------------------------------------------------------
+   // clear()
+   // Releases the buffer and all results.
+   void clear();
+
+   // -----------------------------------------------------------------------
+   // scan()
+   // Structural pass over the buffer. Fails if the package header is
+   // missing, unknown lines are only reported as warnings. Large buffers
+   // are split into byte ranges scanned on up to threads threads, those
+   // of the shared pool if it is 0; the results are the same as with one.
+   bool scan(size_t threads = 0);
+
+   // -----------------------------------------------------------------------
+   // setTimeZone()
+   // The zone of the dates of the file, the local one by default. Applies
+   // from the next scan().
+   void setTimeZone(const FLUMORETimeZone& zone);
+
+   // -----------------------------------------------------------------------
+   // decode()
+   // Appends the rows of the block to the columns and returns the number
+   // of rows which could not be parsed. Values with the number of
+   // fractional digits their column had in the previous row are converted
+   // by a fixed scale path, with the same results as parseDecimal().
+   size_t decode(const FLUMOREBlock& block, FLUMOREColumns& columns) const;
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   const char* data() const { return buffer_.empty() ? NULL : &buffer_[0]; }
+   size_t size() const { return buffer_.size(); }
+   const FLUMOREPackageHeader& header() const { return header_; }
+   const FLUMORETimeZone& timeZone() const { return timeZone_; }
+   const vector<FLUMORETimestamp>& timestamps() const { return timestamps_; }
+   const vector<FLUMORESituation>& situations() const { return situations_; }
+   const vector<FLUMOREBlock>& blocks() const { return blocks_; }
+   const vector<string>& warnings() const { return warnings_; }
+   size_t warningCount() const { return warningCount_; }
+   const string& error() const { return error_; }
+   FLUMOREFileReader& fileReader() { return file_; }
+   const FLUMOREFileReader& fileReader() const { return file_; }
+
+   // -----------------------------------------------------------------------
+   // Line matchers, also used by the benchmark and the writer checks.
+   // Each mirrors the corresponding regular expression in Patterns.fs.
+   // matchTimestamp() leaves fmeDate empty, scan() converts the dates.
+   static bool matchPackageHeader(const char* begin, const char* end, FLUMOREPackageHeader& header);
+   static bool matchTimestamp(const char* begin, const char* end, FLUMORETimestamp& timestamp);
+   static bool matchSituation(const string& lines, FLUMORESituation& situation);
+   static bool matchTeilbereich(const char* begin, const char* end, FLUMOREBlock& block);
+
+   // -----------------------------------------------------------------------
+   // parseRow()
+   // Parses one data row "id, x, y, z, wsp, h, vres".
+   static bool parseRow(const char* begin, const char* end, int32_t& id, double* values);
+
+   // -----------------------------------------------------------------------
+   // parseDecimal()
+   // Parses \d+\.\d+ at p and advances p behind it. Exact for all inputs,
+   // common values avoid the slow general conversion.
+   static bool parseDecimal(const char*& p, const char* end, double& value);
+
+   // -----------------------------------------------------------------------
+   // partition()
+   // The indices of the blocks which partition index of count reads, so
+   // count engines can share one dataset. The blocks or timesteps are
+   // split into count ranges in file order with about the same number of
+   // rows, by the counts of the Teilbereich lines. The split only depends
+   // on the blocks, every engine finds the same one from the scan or the
+   // cache, and every block is in exactly one partition.
+   static void partition(const vector<FLUMOREBlock>& blocks, FLUMOREPartitionUnit unit, size_t index,
+                         size_t count, vector<size_t>& selected);
+
+   // -----------------------------------------------------------------------
+   // parsePartitionUnit()
+   // Reads BLOCK or TIMESTEP into unit.
+   static bool parsePartitionUnit(const string& name, FLUMOREPartitionUnit& unit);
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREParser(const FLUMOREParser&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREParser &operator=(const FLUMOREParser&);
+
+   // -----------------------------------------------------------------------
+   // warn()
+   // Keeps the first warnings and counts all of them.
+   void warn(const string& message);
+
+   // -----------------------------------------------------------------------
+   // warnLine()
+   // Reports the line number line with the content begin to end as
+   // unknown unless it is empty.
+   void warnLine(size_t line, const char* begin, const char* end);
+
+   // -----------------------------------------------------------------------
+   // addTimestamp()
+   // Adds the timestamp with its date converted to UTC. Every distinct
+   // date of the file is converted only once.
+   void addTimestamp(const FLUMORETimestamp& timestamp);
+
+   // -----------------------------------------------------------------------
+   // addBlock()
+   // Adds the block of which rows rows exist, reporting it if the file
+   // ended before its announced count.
+   void addBlock(FLUMOREBlock& block, int32_t rows);
+
+   // -----------------------------------------------------------------------
+   // scanLines()
+   // The sequential scan of the lines from p, the line after the package
+   // header.
+   void scanLines(const char* p);
+
+   // -----------------------------------------------------------------------
+   // scanPieces()
+   // The parallel scan of the lines from p. Each of threads byte ranges
+   // is searched for the lines which may be headers, ignorant of the
+   // lines before it. A sequential pass then follows the headers from the
+   // start, skipping the rows of each block by their count, and keeps the
+   // headers the sequential scan would have reached.
+   void scanPieces(const char* p, size_t threads);
+
+   // Data members
+
+   // The complete file content and how it is read.
+   vector<char> buffer_;
+   FLUMOREFileReader file_;
+
+   // The zone of the dates and their conversions so far, by the date as
+   // written in the file.
+   FLUMORETimeZone timeZone_;
+   map<string, string> fmeDates_;
+
+   // Results of scan().
+   FLUMOREPackageHeader header_;
+   vector<FLUMORETimestamp> timestamps_;
+   vector<FLUMORESituation> situations_;
+   vector<FLUMOREBlock> blocks_;
+
+   // The first warnings of scan() and the total number of warnings.
+   vector<string> warnings_;
+   size_t warningCount_;
+
+   // Describes why the last operation failed.
+   string error_;
+};
+
+#endif
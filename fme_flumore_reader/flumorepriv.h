@@ -45,14 +45,224 @@ const static char* const kMsgClosingReader = "Closing reader on dataset ";
 
 const static char* const kMsgOpeningWriter = "Opening writer on dataset ";
 const static char* const kMsgClosingWriter = "Closing writer on dataset ";
-const static char* const kMsgWriteError    = "Error writing geometry";
+const static char* const kMsgWriteError    = "Error writing FLUMORE file";
 
 const static char* const kMsgStartVisiting = "Starting visit to geometry type ";
 const static char* const kMsgVisiting      = "Visiting geometry type ";
 const static char* const kMsgEndVisiting   = "Finishing visit to geometry type ";
 
+const static char* const kMsgLogSummary    = "FLUMORE summary for dataset ";
+const static char* const kMsgBadLogLevel   = "Unknown FLUMORE log level, keeping the default: ";
+const static char* const kMsgStatsSummary  = "FLUMORE statistics for dataset ";
+const static char* const kMsgStatsFileError = "Could not write the FLUMORE statistics file ";
+
 const static char* const kMyFormatParamTag = "MyFormat Parameters: ";
 const static char* const kSrcMyFormatParamTag = "_SOURCE_MYFORMAT_PARAM";
 const static char* const kMsgNoMyFormatParam = "No MyFormat Parameters was entered.";
 
+//-------------------------------------------------------------------------
+// Reader parameters controlling the log output.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcLogLevelTag          = "_SOURCE_LOG_LEVEL";
+const static char* const kSrcLogSampleIntervalTag = "_SOURCE_LOG_SAMPLE_INTERVAL";
+const static char* const kSrcStatsFileTag         = "_SOURCE_STATS_FILE";
+
+const static char* const kLogLevelOff     = "OFF";
+const static char* const kLogLevelSummary = "SUMMARY";
+const static char* const kLogLevelSample  = "SAMPLE";
+const static char* const kLogLevelFull    = "FULL";
+
+const static FME_UInt32 kDefaultLogSampleInterval = 100000;
+
+//-------------------------------------------------------------------------
+// Reader parameter choosing the parser. MONO runs the F# parser, NATIVE
+// the C++ FLUMOREParser. Builds without Mono always use NATIVE.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcParserTag = "_SOURCE_PARSER";
+const static char* const kParserMono   = "MONO";
+const static char* const kParserNative = "NATIVE";
+
+#ifdef FLUMORE_NO_MONO
+const static FME_Boolean kDefaultNativeParser = FME_TRUE;
+#else
+const static FME_Boolean kDefaultNativeParser = FME_FALSE;
+#endif
+
+const static char* const kMsgBadParser           = "Unknown or unavailable FLUMORE parser, keeping the default: ";
+const static char* const kMsgParseFailed         = "The FLUMORE dataset could not be parsed, no features will be read: ";
+const static char* const kMsgParserWarningsCount = "Further FLUMORE parser warnings suppressed: ";
+const static char* const kMsgCompressedNative    = "Reading compressed FLUMORE dataset with the NATIVE parser: ";
+
+//-------------------------------------------------------------------------
+// Reader parameter naming the directory of the binary dataset caches
+// kept by the NATIVE parser. Empty disables the cache.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcCacheDirectoryTag = "_SOURCE_CACHE_DIRECTORY";
+
+const static char* const kMsgCacheRead       = "Reading FLUMORE dataset from cache ";
+const static char* const kMsgCacheWritten    = "Wrote FLUMORE cache ";
+const static char* const kMsgCacheWriteError = "Could not write the FLUMORE cache: ";
+const static char* const kMsgCacheUnused     = "Not reading the FLUMORE cache: ";
+const static char* const kMsgCacheDamaged    = "The FLUMORE cache is damaged, deleted it and reading the dataset instead: ";
+const static char* const kMsgCacheMismatch   = "The FLUMORE dataset doesn't match its cache any more, no further features will be read: ";
+
+//-------------------------------------------------------------------------
+// Reader parameters choosing how the NATIVE parser reads the dataset,
+// see FLUMOREFileReader. URING reads through io_uring with up to
+// QUEUE_DEPTH chunks in flight, AUTO does so for large datasets; both
+// fall back to buffered reads where io_uring is not available.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcReadMethodTag = "_SOURCE_READ_METHOD";
+const static char* const kSrcQueueDepthTag = "_SOURCE_QUEUE_DEPTH";
+
+const static char* const kMsgBadReadMethod = "Unknown FLUMORE read method, keeping the default: ";
+const static char* const kMsgReadFallback  = "Reading the FLUMORE dataset buffered, io_uring is not used: ";
+
+//-------------------------------------------------------------------------
+// Reader parameter naming the time zone of the dates in the dataset:
+// LOCAL, UTC, CET (CET/CEST with the EU daylight saving rules) or a
+// fixed offset such as +01:00, see FLUMOREFormat::parseTimeZone(). The
+// MONO parser only converts from the local time zone.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcTimeZoneTag = "_SOURCE_TIME_ZONE";
+
+const static char* const kMsgBadTimeZone    = "Unknown FLUMORE time zone, keeping LOCAL: ";
+const static char* const kMsgTimeZoneNative = "Reading FLUMORE dataset with a time zone other than LOCAL with the NATIVE parser: ";
+
+//-------------------------------------------------------------------------
+// Reader parameters for the coordinate system. COORDINATE_SYSTEM is
+// assigned to every feature, empty for none. REPROJECT UTM32 reprojects
+// x and y from GK3 to ETRS89 / UTM zone 32N while reading, see
+// FLUMOREReprojector, with the NTv2 grid DATUM_GRID if one is given.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcCoordSysTag  = "_SOURCE_COORDINATE_SYSTEM";
+const static char* const kSrcReprojectTag = "_SOURCE_REPROJECT";
+const static char* const kSrcDatumGridTag = "_SOURCE_DATUM_GRID";
+const static char* const kDefaultCoordSys = "EPSG:31467";
+const static char* const kReprojectNone   = "NONE";
+const static char* const kReprojectUtm32  = "UTM32";
+
+const static char* const kMsgBadReproject       = "Unknown FLUMORE reprojection, keeping NONE: ";
+const static char* const kMsgReprojectCoordSys  = "FLUMORE features are only reprojected from EPSG:31467, not from ";
+const static char* const kMsgDatumGridError     = "Shifting the FLUMORE datum with the Helmert parameters: ";
+const static char* const kMsgOutsideDatumGrid   = "FLUMORE points outside the datum grid, shifted with the Helmert parameters: ";
+
+//-------------------------------------------------------------------------
+// Reader parameters sizing the thread pool all FLUMORE readers and
+// writers of the process share, see FLUMOREThreadPool::shared(): THREADS
+// workers pinned to the cpus of CPU_SET, e.g. 0-3,8. 0 and empty keep
+// the size from FLUMORE_THREADS and FLUMORE_CPU_SET or all cpus. The
+// last reader setting them decides for all.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcThreadsTag = "_SOURCE_THREADS";
+const static char* const kSrcCpuSetTag  = "_SOURCE_CPU_SET";
+
+const static char* const kMsgThreadsError = "FLUMORE threads not pinned: ";
+
+//-------------------------------------------------------------------------
+// Reader parameters for reading one dataset on several engines. Engine
+// PARTITION_INDEX of PARTITION_COUNT, counted from 0, reads its share of
+// the Teilbereich blocks or, with PARTITION_BY TIMESTEP, of the
+// timesteps, see FLUMOREParser::partition(). Only the NATIVE parser
+// partitions; a partitioned read doesn't write the dataset cache.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcPartitionIndexTag = "_SOURCE_PARTITION_INDEX";
+const static char* const kSrcPartitionCountTag = "_SOURCE_PARTITION_COUNT";
+const static char* const kSrcPartitionByTag    = "_SOURCE_PARTITION_BY";
+
+const static char* const kMsgBadPartition    = "Invalid FLUMORE partition, reading the whole dataset: ";
+const static char* const kMsgBadPartitionBy  = "Unknown FLUMORE partition unit, keeping BLOCK: ";
+const static char* const kMsgPartitionNative = "Reading FLUMORE dataset partitioned with the NATIVE parser: ";
+const static char* const kMsgPartition       = "Reading FLUMORE partition ";
+
+//-------------------------------------------------------------------------
+// Reader parameter: YES sets the flumore_* attributes of the structure
+// around the rows on every feature, which the writer needs to write the
+// timesteps, situations and Teilbereich blocks again. Off by default as
+// every feature pays for them. Only the NATIVE parser knows them.
+//-------------------------------------------------------------------------
+
+const static char* const kSrcStructureAttributesTag = "_SOURCE_STRUCTURE_ATTRIBUTES";
+const static char* const kStructureAttributesYes    = "YES";
+const static char* const kStructureAttributesNo     = "NO";
+
+const static char* const kMsgBadStructureAttributes = "Unknown FLUMORE structure attributes setting, keeping NO: ";
+
+
+//-------------------------------------------------------------------------
+// Feature type and attribute names of the FLUMORE features. These are
+// shared by the reader, the schema and the feature builder so the names
+// only exist once.
+//-------------------------------------------------------------------------
+
+const static char* const kFeatureTypeFLUMORE = "FLUMORE";
+const static char* const kAttrGeometry = "fme_geometry{0}";
+const static char* const kAttrId       = "id";
+const static char* const kAttrH        = "h";
+const static char* const kAttrVres     = "vres";
+const static char* const kAttrWsp      = "wsp";
+const static char* const kAttrX        = "x";
+const static char* const kAttrY        = "y";
+const static char* const kAttrZ        = "z";
+const static char* const kAttrDate     = "date";
+
+
+// The structure of the file around the rows. The writer falls back to a
+// SIM timestamp and block TB001-V01 without a situation if they are
+// missing. The situation values are (hm, q) for Ueberstr., (minkrh) for
+// Linien-SM, (maxsh) for Punkt-SM and (bb, btm, q) for the others.
+const static char* const kAttrTimestampKind     = "flumore_timestamp_kind";
+const static char* const kAttrSituationKind     = "flumore_situation_kind";
+const static char* const kAttrSituationNlp      = "flumore_situation_nlp";
+const static char* const kAttrSituationRw       = "flumore_situation_rw";
+const static char* const kAttrSituationHw       = "flumore_situation_hw";
+const static char* const kAttrSituationValue1   = "flumore_situation_value1";
+const static char* const kAttrSituationValue2   = "flumore_situation_value2";
+const static char* const kAttrSituationValue3   = "flumore_situation_value3";
+const static char* const kAttrTeilbereich       = "flumore_teilbereich";
+const static char* const kAttrTeilbereichVersion = "flumore_teilbereich_version";
+
+// The attribute types of the schema, see ATTR_TYPE_MAP in flumore.fmf.
+// The longest situation kind is "Innere Entl.".
+const static char* const kAttrTypeInt32         = "int32";
+const static char* const kAttrTypeReal64        = "real64";
+const static char* const kAttrTypeDateTime      = "datetime";
+const static char* const kAttrTypeTimestampKind = "char(3)";
+const static char* const kAttrTypeSituationKind = "char(12)";
+
+//-------------------------------------------------------------------------
+// Writer parameters, messages and defaults.
+//-------------------------------------------------------------------------
+
+const static char* const kDestCreatedTag = "_DEST_CREATED";
+const static char* const kDestVariantTag = "_DEST_VARIANT";
+const static char* const kDestCounterTag = "_DEST_COUNTER";
+const static char* const kDestMemoryLimitTag = "_DEST_MEMORY_LIMIT";
+const static char* const kDestThreadsTag = "_DEST_THREADS";
+const static char* const kDestTimeZoneTag = "_DEST_TIME_ZONE";
+
+const static FME_Int32 kDefaultVariant = 1;
+const static FME_Int32 kDefaultCounter = 1;
+
+// Megabytes of rows the writer keeps in memory before it spills them to
+// a temporary file in FME_TEMP or the destination folder. 0 disables it.
+const static FME_Int32 kDefaultMemoryLimit = 1024;
+
+// Threads formatting the rows at close(), 0 for all of the shared pool.
+const static FME_Int32 kDefaultWriterThreads = 0;
+
+const static char* const kMsgBadWriterParameter = "Invalid FLUMORE writer parameter, keeping the default: ";
+const static char* const kMsgFeatureRejected    = "FLUMORE feature not written: ";
+const static char* const kMsgFeaturesRejected   = "FLUMORE features not written: ";
+const static char* const kMsgNothingWritten     = "No FLUMORE features to write to dataset ";
+const static char* const kMsgWroteFile          = "Wrote FLUMORE file ";
+
 #endif
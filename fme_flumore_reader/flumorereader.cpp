@@ -35,7 +35,9 @@
 
 // Include Files
 #include "flumorereader.h"
+#include "flumoredecompressor.h"
 #include "flumorepriv.h"
+#include "flumorethreadpool.h"
 
 #include <fmestring.h>
 #include <igeometrytools.h>
@@ -43,6 +45,11 @@
 #include <fmemap.h>
 #include <isession.h>
 #include <ifeature.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
 #include <vector>
 #include <tuple>
 
@@ -60,8 +67,33 @@ FLUMOREReader::FLUMOREReader(const char* readerTypeName, const char* readerKeywo
    readerTypeName_(readerTypeName),
    readerKeyword_(readerKeyword),
    dataset_(""),
-   coordSys_(""),
-   fmeGeometryTools_(NULL)
+   coordSys_(kDefaultCoordSys),
+   reproject_(FME_FALSE),
+   reprojecting_(FME_FALSE),
+   datumGrid_(""),
+   outsideDatumGrid_(0),
+   threads_(0),
+   cpuSet_(""),
+   fmeGeometryTools_(NULL),
+   nativeParser_(kDefaultNativeParser),
+   useNative_(kDefaultNativeParser),
+   cacheDirectory_(""),
+   usingCache_(FME_FALSE),
+   partitionIndex_(0),
+   partitionCount_(1),
+   partitionUnit_(kFLUMOREPartitionBlock),
+   nextBlock_(0),
+   nextRow_(0),
+   parsed_(FME_FALSE),
+   schemaRead_(FME_FALSE),
+#ifndef FLUMORE_NO_MONO
+   nextTable_(0),
+   nextTableRow_(0),
+   monoParsed_(FME_FALSE),
+#endif
+   statsFile_(""),
+   lastReadEnd_(),
+   open_(FME_FALSE)
 {
 }
 
@@ -70,29 +102,78 @@ FLUMOREReader::FLUMOREReader(const char* readerTypeName, const char* readerKeywo
 // Open
 FME_Status FLUMOREReader::open(const char* datasetName, const IFMEStringArray& parameters)
 {
+   stats_.reset();
+   FLUMOREStats::Timer openTimer(stats_, kFLUMOREPhaseOpen);
+   lastReadEnd_ = FLUMOREStats::Clock::time_point();
+   open_ = FME_TRUE;
+
    // Get geometry tools
    fmeGeometryTools_ = gFMESession->getGeometryTools();
    FMEString::setSession(gFMESession);
    dataset_ = datasetName;
+   featureBuilder_.open(gFMESession);
+   nextBlock_ = 0;
+   nextRow_ = 0;
+   usingCache_ = FME_FALSE;
+   parsed_ = FME_FALSE;
+   schemaRead_ = FME_FALSE;
+   log_.open(gLogFile);
 
    // -----------------------------------------------------------------------
    // Add additional setup here
    // -----------------------------------------------------------------------
 
-   // Log an opening reader message
-   gLogFile->logMessageString((kMsgOpeningReader + dataset_).c_str());
-
-   // -----------------------------------------------------------------------
-   // Open the dataset here, e.g. inputFile.open(dataSetName, ios::in);
-   // -----------------------------------------------------------------------
-
-   // Read the mapping file parameters if there is one specified.
+   // Read the mapping file parameters if there is one specified. This
+   // happens first as the parameters decide what gets logged.
    if (parameters.entries() < 1)
    {
       // We are in "open to read data features" mode.
       readParametersDialog();
    }
 
+   // Log an opening reader message
+   log_.message((kMsgOpeningReader + dataset_).c_str());
+
+   // The configured parser, unless the F# parser can't read the dataset.
+   // It reads plain text only.
+   useNative_ = nativeParser_;
+   if (!useNative_ && FLUMOREDecompressor::compressedName(dataset_))
+   {
+      useNative_ = FME_TRUE;
+      log_.message((kMsgCompressedNative + dataset_).c_str());
+   }
+
+   // The F# parser converts the dates in the local time zone only.
+   if (!useNative_ && parser_.timeZone().kind != kFLUMOREZoneLocal)
+   {
+      useNative_ = FME_TRUE;
+      log_.message((kMsgTimeZoneNative + dataset_).c_str());
+   }
+
+   // Only the blocks of the native parser can be partitioned.
+   if (!useNative_ && partitionCount_ > 1)
+   {
+      useNative_ = FME_TRUE;
+      log_.message((kMsgPartitionNative + dataset_).c_str());
+   }
+
+#ifndef FLUMORE_NO_MONO
+   // Mono is started and the F# parser's entry points compiled once per
+   // process, by the first reader which uses them.
+   if (!useNative_)
+   {
+      static once_flag monoStarted;
+      call_once(monoStarted, ImportSimulationData_warmUp);
+   }
+#endif
+
+   openThreads();
+   openReprojection();
+
+   // -----------------------------------------------------------------------
+   // Open the dataset here, e.g. inputFile.open(dataSetName, ios::in);
+   // -----------------------------------------------------------------------
+
    return FME_SUCCESS;
 }
 
@@ -117,104 +198,452 @@ FME_Status FLUMOREReader::close()
    // Perform any closing operations / cleanup here; e.g. close opened files
    // -----------------------------------------------------------------------
 
-   // Log that the reader is done
-   gLogFile->logMessageString((kMsgClosingReader + dataset_).c_str());
+   featureBuilder_.close();
+#ifndef FLUMORE_NO_MONO
+   releaseMonoTables();
+#endif
+   parser_.clear();
+   cache_.clear();
+   columns_ = FLUMOREColumns();
+   blockArena_.clear();
+
+   if (open_)
+   {
+      open_ = FME_FALSE;
+      if (outsideDatumGrid_ > 0)
+      {
+         ostringstream msg;
+         msg << kMsgOutsideDatumGrid << outsideDatumGrid_;
+         log_.message(msg.str().c_str(), FME_WARN);
+      }
+      logStatistics();
+
+      // Log that the reader is done
+      log_.message((kMsgClosingReader + dataset_).c_str());
+      log_.flush(dataset_);
+   }
 
    return FME_SUCCESS;
 }
 
-int32_t _outer_iterator = 0;
-int32_t _inner_iterator = 0;
-bool initialized = false;
-
-std::vector<std::tuple<_DataRowFLUMOREArray, const char*>> __parserResult_dataRows;
-
 //===========================================================================
 // Read
 FME_Status FLUMOREReader::read(IFMEFeature& feature, FME_Boolean& endOfFile)
 {
-    if (!initialized) {
-        parserResult = Parser_getSimulationFileData(dataset_.c_str());
-        initialized = true;
-        __parserResult_dataRows.reserve(parserResult.array->len);
-        for (int _i = 0; _i < parserResult.array->len; ++_i) {
-            gLogFile->logMessageString((kMsgClosingReader + dataset_).c_str());
-            Parser* __parserResult_array_element = g_array_index(parserResult.array, DataTableFLUMORE*, _i);
-            _DataRowFLUMOREArray dataRows = DataTableFLUMORE_get_data(__parserResult_array_element);
-            let date = DataTableFLUMORE_get_time(__parserResult_array_element);
-            __parserResult_dataRows.push_back(std::make_tuple(dataRows, date));
-            //mono_embeddinator_destroy_object(__parserResult_array_element);
-        }
+    let readStart = FLUMOREStats::Clock::now();
+    if (lastReadEnd_ != FLUMOREStats::Clock::time_point()) {
+        // Everything since the previous read() returned was spent in FME.
+        stats_.addTime(kFLUMOREPhaseCallback, readStart - lastReadEnd_);
     }
+
     endOfFile = FME_FALSE;
-    if (parserResult.array->len > _outer_iterator) {
-        _DataRowFLUMOREArray dataRows = std::get<_DataRowFLUMOREArray>(__parserResult_dataRows[_outer_iterator]);
-        //FLUMOREReader::gLogFile->logMessageString("reading");
-
-        DataRowFLUMORE* __parserResult_dataRows_array_element = g_array_index(dataRows.array, DataRowFLUMORE*, _inner_iterator);
-
-        let id = DataRowFLUMORE_get_id(__parserResult_dataRows_array_element);
-        let h = DataRowFLUMORE_get_h(__parserResult_dataRows_array_element);
-        let vres = DataRowFLUMORE_get_vres(__parserResult_dataRows_array_element);
-        let wsp = DataRowFLUMORE_get_wsp(__parserResult_dataRows_array_element);
-        let x = DataRowFLUMORE_get_x(__parserResult_dataRows_array_element);
-        let y = DataRowFLUMORE_get_y(__parserResult_dataRows_array_element);
-        let z = DataRowFLUMORE_get_z(__parserResult_dataRows_array_element);
-        let date = std::get<const char*>(__parserResult_dataRows[_outer_iterator]);
-
-        //mono_embeddinator_destroy_object(__parserResult_dataRows_array_element);
-
-        feature.setAttribute("id", (FME_Int32)id);
-        feature.setAttribute("h", h);
-        feature.setAttribute("vres", vres);
-        feature.setAttribute("wsp", wsp);
-        feature.setAttribute("x", x);
-        feature.setAttribute("y", y);
-        feature.setAttribute("z", z);
-        feature.setAttribute("date", date);
-        feature.setFeatureType("FLUMORE");
-
-        if (_inner_iterator + 1 == dataRows.array->len)
-        {
-            ++_outer_iterator;
-            _inner_iterator = 0;
+#ifdef FLUMORE_NO_MONO
+    let status = readNative(feature, endOfFile);
+#else
+    let status = useNative_ ? readNative(feature, endOfFile) : readMono(feature, endOfFile, readStart);
+#endif
+    if (status != FME_SUCCESS || endOfFile) {
+        lastReadEnd_ = FLUMOREStats::Clock::time_point();
+        return status;
+    }
+
+    // Log the feature, depending on the log level
+    log_.feature(feature);
+    stats_.addRows(1);
+
+    lastReadEnd_ = FLUMOREStats::Clock::now();
+    return FME_SUCCESS;
+}
+
+//===========================================================================
+// readNative
+
+FME_Status FLUMOREReader::readNative(IFMEFeature& feature, FME_Boolean& endOfFile)
+{
+    if (!parsed_) {
+        parsed_ = FME_TRUE;
+        if (!parseNative()) {
+            endOfFile = FME_TRUE;
+            return FME_SUCCESS;
+        }
+        selectPartition();
+    }
+
+    while (nextRow_ >= columns_.size()) {
+        let& blocks = usingCache_ ? cache_.blocks() : parser_.blocks();
+        let partitioned = partitionCount_ > 1;
+        if (nextBlock_ >= (partitioned ? partition_.size() : blocks.size())) {
+            if (cache_.writing()) {
+                let path = FLUMORECache::cachePath(cacheDirectory_, dataset_);
+                if (cache_.finish(parser_)) {
+                    log_.message((kMsgCacheWritten + path).c_str());
+                } else {
+                    log_.message((kMsgCacheWriteError + cache_.error()).c_str(), FME_WARN);
+                }
+            }
+            endOfFile = FME_TRUE;
+            return FME_SUCCESS;
+        }
+
+        let index = partitioned ? partition_[nextBlock_++] : nextBlock_++;
+        bool cached = false;
+        if (usingCache_) {
+            FLUMOREStats::Timer decodeTimer(stats_, kFLUMOREPhaseDecode);
+            // The previous block has been read completely.
+            blockArena_.reset();
+            columns_.clear();
+            size_t rejected = 0;
+            cached = cache_.decode(index, columns_, rejected, blockArena_);
+            if (cached) {
+                stats_.addRowsFiltered(rejected);
+            }
         }
-        else
-        {
-            ++_inner_iterator;
+        // The features read so far are fine, the rest come from the dataset.
+        if (usingCache_ && !cached && !leaveCache()) {
+            return FME_FAILURE;
         }
+        if (!cached) {
+            FLUMOREStats::Timer decodeTimer(stats_, kFLUMOREPhaseDecode);
+            blockArena_.reset();
+            columns_.clear();
+            let rejected = parser_.decode(parser_.blocks()[index], columns_);
+            stats_.addRowsFiltered(rejected);
+            if (cache_.writing() && !cache_.addBlock(columns_, rejected)) {
+                log_.message((kMsgCacheWriteError + cache_.error()).c_str(), FME_WARN);
+            }
+        }
+        if (reprojecting_ && columns_.size() > 0) {
+            // The cache keeps the coordinates of the dataset.
+            FLUMOREStats::Timer reprojectTimer(stats_, kFLUMOREPhaseReproject);
+            outsideDatumGrid_ += reprojector_.transform(&columns_.x[0], &columns_.y[0], columns_.size(), 0);
+        }
+        nextRow_ = 0;
+
+        // Unlike the F# parser every block gets the date of its timestamp,
+        // not only the first one following a situation header.
+        let& block = (usingCache_ ? cache_.blocks() : parser_.blocks())[index];
+        let& timestamps = usingCache_ ? cache_.timestamps() : parser_.timestamps();
+        let& situations = usingCache_ ? cache_.situations() : parser_.situations();
+        featureBuilder_.beginBlock(block.timestamp < 0 ? NULL : &timestamps[block.timestamp],
+                                   block.situation < 0 ? NULL : &situations[block.situation], block);
     }
-    /*else if (parserResult.array->len == _outer_iterator) 
-    {
-        ++_outer_iterator;
-    }*/
-    else {
+
+    FLUMOREStats::Timer buildTimer(stats_, kFLUMOREPhaseFeatureBuild);
+    let row = nextRow_++;
+    featureBuilder_.build(feature, columns_.id[row], columns_.x[row], columns_.y[row], columns_.z[row],
+                          columns_.wsp[row], columns_.h[row], columns_.vres[row]);
+    return FME_SUCCESS;
+}
+
+//===========================================================================
+// parseNative
+
+FME_Boolean FLUMOREReader::parseNative()
+{
+   // A cache matching the dataset replaces loading and scanning.
+   const string cachePath = cacheDirectory_.empty() ? "" : FLUMORECache::cachePath(cacheDirectory_, dataset_);
+   if (!cachePath.empty())
+   {
+      FME_Boolean cached = FME_FALSE;
+      {
+         FLUMOREStats::Timer readTimer(stats_, kFLUMOREPhaseRead);
+         cached = cache_.open(cachePath, dataset_, parser_.timeZone()) ? FME_TRUE : FME_FALSE;
+      }
+      if (cached)
+      {
+         usingCache_ = FME_TRUE;
+         stats_.addBytes(cache_.size());
+         log_.message((kMsgCacheRead + cachePath).c_str());
+         return FME_TRUE;
+      }
+      // Out of date or damaged, it is written again.
+      log_.message((kMsgCacheUnused + cache_.error()).c_str());
+      remove(cachePath.c_str());
+   }
+
+   if (!scanNative())
+   {
+      return FME_FALSE;
+   }
+
+   // The blocks are added to the cache as they are decoded; a partition
+   // doesn't decode all of them.
+   if (!cachePath.empty() && partitionCount_ <= 1 && !cache_.create(cachePath, dataset_))
+   {
+      log_.message((kMsgCacheWriteError + cache_.error()).c_str(), FME_WARN);
+   }
+   return FME_TRUE;
+}
+
+//===========================================================================
+// scanNative
+
+FME_Boolean FLUMOREReader::scanNative()
+{
+   FME_Boolean loaded = FME_FALSE;
+   {
+      FLUMOREStats::Timer readTimer(stats_, kFLUMOREPhaseRead);
+      loaded = parser_.load(dataset_) ? FME_TRUE : FME_FALSE;
+   }
+   stats_.addBytes(parser_.size());
+   if (!parser_.fileReader().fallback().empty())
+   {
+      log_.message((kMsgReadFallback + parser_.fileReader().fallback()).c_str());
+   }
+
+   FME_Boolean scanned = FME_FALSE;
+   if (loaded)
+   {
+      FLUMOREStats::Timer scanTimer(stats_, kFLUMOREPhaseScan);
+      scanned = parser_.scan() ? FME_TRUE : FME_FALSE;
+   }
+
+   // Reported like the warnings of the F# parser.
+   let& warnings = parser_.warnings();
+   for (size_t i = 0; i < warnings.size(); ++i)
+   {
+      log_.message(warnings[i].c_str(), FME_WARN);
+   }
+   if (parser_.warningCount() > warnings.size())
+   {
+      ostringstream msg;
+      msg << kMsgParserWarningsCount << (parser_.warningCount() - warnings.size());
+      log_.message(msg.str().c_str(), FME_WARN);
+   }
+
+   if (!scanned)
+   {
+      log_.message((kMsgParseFailed + parser_.error()).c_str(), FME_WARN);
+      return FME_FALSE;
+   }
+   return FME_TRUE;
+}
+
+//===========================================================================
+// leaveCache
+
+FME_Boolean FLUMOREReader::leaveCache()
+{
+   const string cachePath = FLUMORECache::cachePath(cacheDirectory_, dataset_);
+   log_.message((kMsgCacheDamaged + cachePath).c_str(), FME_WARN);
+   const size_t blockCount = cache_.blocks().size();
+   cache_.clear();
+   remove(cachePath.c_str());
+   usingCache_ = FME_FALSE;
+
+   // The partition and the blocks read so far are those of the cache.
+   if (!scanNative())
+   {
+      return FME_FALSE;
+   }
+   if (parser_.blocks().size() != blockCount)
+   {
+      log_.message((kMsgCacheMismatch + dataset_).c_str(), FME_WARN);
+      return FME_FALSE;
+   }
+   return FME_TRUE;
+}
+
+//===========================================================================
+// selectPartition
+
+void FLUMOREReader::selectPartition()
+{
+   partition_.clear();
+   if (partitionCount_ <= 1)
+   {
+      return;
+   }
+   let& blocks = usingCache_ ? cache_.blocks() : parser_.blocks();
+   FLUMOREParser::partition(blocks, partitionUnit_, partitionIndex_, partitionCount_, partition_);
+
+   FME_UInt64 rows = 0;
+   FME_UInt64 totalRows = 0;
+   for (size_t b = 0; b < blocks.size(); ++b)
+   {
+      totalRows += FME_UInt64(std::max(blocks[b].count, 0));
+   }
+   for (size_t i = 0; i < partition_.size(); ++i)
+   {
+      rows += FME_UInt64(std::max(blocks[partition_[i]].count, 0));
+   }
+   ostringstream msg;
+   msg << kMsgPartition << partitionIndex_ << " of " << partitionCount_ << ": " << partition_.size()
+       << " of " << blocks.size() << " blocks, " << rows << " of " << totalRows << " rows";
+   log_.message(msg.str().c_str());
+}
+
+//===========================================================================
+// openReprojection
+
+void FLUMOREReader::openReprojection()
+{
+   outsideDatumGrid_ = 0;
+   reprojector_.clear();
+   reprojecting_ = reproject_;
+   if (reprojecting_ && coordSys_ != FLUMOREReprojector::kSourceCoordSys)
+   {
+      log_.message((kMsgReprojectCoordSys + coordSys_).c_str(), FME_WARN);
+      reprojecting_ = FME_FALSE;
+   }
+   if (reprojecting_ && !datumGrid_.empty() && !reprojector_.loadGrid(datumGrid_))
+   {
+      log_.message((kMsgDatumGridError + reprojector_.error()).c_str(), FME_WARN);
+   }
+   featureBuilder_.setCoordSys(reprojecting_ ? FLUMOREReprojector::kTargetCoordSys : coordSys_.c_str());
+}
+
+//===========================================================================
+// openThreads
+
+void FLUMOREReader::openThreads()
+{
+   if (threads_ == 0 && cpuSet_.empty())
+   {
+      return;
+   }
+   string error;
+   if (!FLUMOREThreadPool::configureShared(threads_, cpuSet_, error))
+   {
+      log_.message((kMsgThreadsError + error).c_str(), FME_WARN);
+   }
+}
+
+#ifndef FLUMORE_NO_MONO
+//===========================================================================
+// readMono
+
+FME_Status FLUMOREReader::readMono(IFMEFeature& feature, FME_Boolean& endOfFile,
+                                   FLUMOREStats::Clock::time_point readStart)
+{
+    if (!monoParsed_) {
+        Log_setLevel(log_.level());
+        Parser_setMaxThreads(int32_t(FLUMOREThreadPool::defaultThreads()));
+        let parserResult = Parser_getSimulationFileData(dataset_.c_str());
+        forwardParserMessages();
+        collectParserStatistics(FLUMOREStats::Clock::now() - readStart);
+        monoParsed_ = FME_TRUE;
+        monoTables_.reserve(parserResult.array->len);
+        for (guint _i = 0; _i < parserResult.array->len; ++_i) {
+            DataTableFLUMORE* __parserResult_array_element = g_array_index(parserResult.array, DataTableFLUMORE*, _i);
+            // The rows are copied out as plain values, so neither they nor the
+            // table need a GC handle once this loop is done.
+            MonoTable table;
+            table.rows = DataTableFLUMORE_get_data_values(__parserResult_array_element);
+            table.date = DataTableFLUMORE_get_time(__parserResult_array_element);
+            monoTables_.push_back(table);
+            mono_embeddinator_destroy_object(__parserResult_array_element);
+        }
+        g_array_free(parserResult.array, TRUE);
+    }
+    FLUMOREStats::Timer buildTimer(stats_, kFLUMOREPhaseFeatureBuild);
+
+    // Skip and release tables without rows.
+    while (nextTable_ < monoTables_.size() && monoTables_[nextTable_].rows.array->len == 0) {
+        releaseMonoTable(nextTable_++);
+    }
+    if (nextTable_ == monoTables_.size()) {
         endOfFile = FME_TRUE;
+        return FME_SUCCESS;
+    }
+
+    const MonoTable& table = monoTables_[nextTable_];
+    const DataRowFLUMOREValue& row = g_array_index(table.rows.array, DataRowFLUMOREValue, nextTableRow_);
+    if (nextTableRow_ == 0)
+    {
+        // The date is the same for all rows of a table.
+        featureBuilder_.beginBlock(table.date);
+    }
+    double x = row.x;
+    double y = row.y;
+    if (reprojecting_) {
+        outsideDatumGrid_ += reprojector_.transform(&x, &y, 1);
+    }
+    featureBuilder_.build(feature, (FME_Int32)row.id, x, y, row.z, row.wsp, row.h, row.vres);
+
+    if (++nextTableRow_ == table.rows.array->len)
+    {
+        // The feature holds copies of the values, so the table can go.
+        releaseMonoTable(nextTable_++);
+        nextTableRow_ = 0;
     }
-    // Log the feature
-    gLogFile->logFeature(feature);
     return FME_SUCCESS;
 }
 
-bool featureRead = false;
+//===========================================================================
+// releaseMonoTable
+
+void FLUMOREReader::releaseMonoTable(size_t index)
+{
+   MonoTable& table = monoTables_[index];
+   if (table.rows.array)
+   {
+      g_array_free(table.rows.array, TRUE);
+      table.rows.array = NULL;
+   }
+   if (table.date)
+   {
+      mono_free((void*)table.date);
+      table.date = NULL;
+   }
+}
+
+//===========================================================================
+// releaseMonoTables
+
+void FLUMOREReader::releaseMonoTables()
+{
+   for (size_t i = nextTable_; i < monoTables_.size(); ++i)
+   {
+      releaseMonoTable(i);
+   }
+   // Swap to give back the table list itself.
+   vector<MonoTable>().swap(monoTables_);
+   nextTable_ = 0;
+   nextTableRow_ = 0;
+   monoParsed_ = FME_FALSE;
+}
+#endif
 
 //===========================================================================
 // readSchema
 FME_Status FLUMOREReader::readSchema(IFMEFeature& feature, FME_Boolean& endOfSchema)
 {
-    feature.setAttribute("fme_geometry{0}", "flumore_none");
-    feature.setAttribute("id");
-    feature.setAttribute("h");
-    feature.setAttribute("vres");
-    feature.setAttribute("wsp");
-    feature.setAttribute("x");
-    feature.setAttribute("y");
-    feature.setAttribute("z");
-    feature.setAttribute("date");
-    feature.setFeatureType("FLUMORE");
-   endOfSchema = FME_Boolean(featureRead);
-   featureRead = true;
-   
+   // The flumore_* attributes describe the structure around the rows;
+   // only the NATIVE parser sets them.
+   static const char* const kSchema[][2] =
+   {
+      { kAttrId,                 kAttrTypeInt32 },
+      { kAttrH,                  kAttrTypeReal64 },
+      { kAttrVres,               kAttrTypeReal64 },
+      { kAttrWsp,                kAttrTypeReal64 },
+      { kAttrX,                  kAttrTypeReal64 },
+      { kAttrY,                  kAttrTypeReal64 },
+      { kAttrZ,                  kAttrTypeReal64 },
+      { kAttrDate,               kAttrTypeDateTime },
+      { kAttrTimestampKind,      kAttrTypeTimestampKind },
+      { kAttrSituationKind,      kAttrTypeSituationKind },
+      { kAttrSituationNlp,       kAttrTypeInt32 },
+      { kAttrSituationRw,        kAttrTypeReal64 },
+      { kAttrSituationHw,        kAttrTypeReal64 },
+      { kAttrSituationValue1,    kAttrTypeReal64 },
+      { kAttrSituationValue2,    kAttrTypeReal64 },
+      { kAttrSituationValue3,    kAttrTypeReal64 },
+      { kAttrTeilbereich,        kAttrTypeInt32 },
+      { kAttrTeilbereichVersion, kAttrTypeInt32 }
+   };
+
+   feature.setAttribute(kAttrGeometry, "flumore_none");
+   for (size_t i = 0; i < sizeof(kSchema) / sizeof(kSchema[0]); ++i)
+   {
+      feature.setAttribute(kSchema[i][0], kSchema[i][1]);
+   }
+   feature.setFeatureType(kFeatureTypeFLUMORE);
+
+   // One schema feature per dataset.
+   endOfSchema = schemaRead_;
+   schemaRead_ = FME_TRUE;
+
    return FME_SUCCESS;
 }
 
@@ -243,17 +672,236 @@ void FLUMOREReader::readParametersDialog()
       // Log that no parameter value was entered.
       gLogFile->logMessageString(kMsgNoMyFormatParam, FME_INFORM);
    }
+
+   string logLevel;
+   if (fetchParameter(kSrcLogLevelTag, logLevel) && !logLevel.empty())
+   {
+      if (!log_.setLevel(logLevel))
+      {
+         gLogFile->logMessageString((kMsgBadLogLevel + logLevel).c_str(), FME_WARN);
+      }
+   }
+
+   fetchParameter(kSrcStatsFileTag, statsFile_);
+   fetchParameter(kSrcCacheDirectoryTag, cacheDirectory_);
+
+   string parser;
+   if (fetchParameter(kSrcParserTag, parser) && !parser.empty())
+   {
+      if (parser == kParserNative)
+      {
+         nativeParser_ = FME_TRUE;
+      }
+#ifndef FLUMORE_NO_MONO
+      else if (parser == kParserMono)
+      {
+         nativeParser_ = FME_FALSE;
+      }
+#endif
+      else
+      {
+         gLogFile->logMessageString((kMsgBadParser + parser).c_str(), FME_WARN);
+      }
+   }
+
+   string readMethod;
+   if (fetchParameter(kSrcReadMethodTag, readMethod) && !readMethod.empty())
+   {
+      FLUMOREReadMethod method = kFLUMOREReadAuto;
+      if (FLUMOREFileReader::parseMethod(readMethod, method))
+      {
+         parser_.fileReader().setMethod(method);
+      }
+      else
+      {
+         gLogFile->logMessageString((kMsgBadReadMethod + readMethod).c_str(), FME_WARN);
+      }
+   }
+
+   string queueDepth;
+   if (fetchParameter(kSrcQueueDepthTag, queueDepth) && !queueDepth.empty())
+   {
+      parser_.fileReader().setQueueDepth(size_t(strtoul(queueDepth.c_str(), NULL, 10)));
+   }
+
+   string timeZone;
+   if (fetchParameter(kSrcTimeZoneTag, timeZone) && !timeZone.empty())
+   {
+      FLUMORETimeZone zone;
+      if (FLUMOREFormat::parseTimeZone(timeZone, zone))
+      {
+         parser_.setTimeZone(zone);
+      }
+      else
+      {
+         gLogFile->logMessageString((kMsgBadTimeZone + timeZone).c_str(), FME_WARN);
+      }
+   }
+
+   fetchParameter(kSrcCoordSysTag, coordSys_);
+   fetchParameter(kSrcDatumGridTag, datumGrid_);
+   string reproject;
+   if (fetchParameter(kSrcReprojectTag, reproject) && !reproject.empty())
+   {
+      if (reproject == kReprojectUtm32)
+      {
+         reproject_ = FME_TRUE;
+      }
+      else if (reproject == kReprojectNone)
+      {
+         reproject_ = FME_FALSE;
+      }
+      else
+      {
+         gLogFile->logMessageString((kMsgBadReproject + reproject).c_str(), FME_WARN);
+      }
+   }
+
+   string threads;
+   if (fetchParameter(kSrcThreadsTag, threads) && !threads.empty())
+   {
+      threads_ = FME_UInt32(strtoul(threads.c_str(), NULL, 10));
+   }
+   fetchParameter(kSrcCpuSetTag, cpuSet_);
+
+   string partitionIndex;
+   string partitionCount;
+   const bool hasIndex = fetchParameter(kSrcPartitionIndexTag, partitionIndex) && !partitionIndex.empty();
+   const bool hasCount = fetchParameter(kSrcPartitionCountTag, partitionCount) && !partitionCount.empty();
+   if (hasIndex || hasCount)
+   {
+      char* indexEnd = NULL;
+      char* countEnd = NULL;
+      const long index = hasIndex ? strtol(partitionIndex.c_str(), &indexEnd, 10) : 0;
+      const long count = hasCount ? strtol(partitionCount.c_str(), &countEnd, 10) : 1;
+      if ((hasIndex && *indexEnd != '\0') || (hasCount && *countEnd != '\0') ||
+          count < 1 || count > 0xffff || index < 0 || index >= count)
+      {
+         gLogFile->logMessageString((kMsgBadPartition + partitionIndex + "/" + partitionCount).c_str(), FME_WARN);
+         partitionIndex_ = 0;
+         partitionCount_ = 1;
+      }
+      else
+      {
+         partitionIndex_ = FME_UInt32(index);
+         partitionCount_ = FME_UInt32(count);
+      }
+   }
+   string partitionBy;
+   if (fetchParameter(kSrcPartitionByTag, partitionBy) && !partitionBy.empty() &&
+       !FLUMOREParser::parsePartitionUnit(partitionBy, partitionUnit_))
+   {
+      gLogFile->logMessageString((kMsgBadPartitionBy + partitionBy).c_str(), FME_WARN);
+   }
+
+   string structureAttributes;
+   if (fetchParameter(kSrcStructureAttributesTag, structureAttributes) && !structureAttributes.empty())
+   {
+      if (structureAttributes == kStructureAttributesYes || structureAttributes == kStructureAttributesNo)
+      {
+         featureBuilder_.setStructureAttributes(structureAttributes == kStructureAttributesYes);
+      }
+      else
+      {
+         gLogFile->logMessageString((kMsgBadStructureAttributes + structureAttributes).c_str(), FME_WARN);
+         featureBuilder_.setStructureAttributes(false);
+      }
+   }
+
+   string sampleInterval;
+   if (fetchParameter(kSrcLogSampleIntervalTag, sampleInterval) && !sampleInterval.empty())
+   {
+      log_.setSampleInterval(FME_UInt32(strtoul(sampleInterval.c_str(), NULL, 10)));
+   }
+}
+
+//===========================================================================
+// fetchParameter
+
+FME_Boolean FLUMOREReader::fetchParameter(const char* tag, string& value) const
+{
+   FMEString paramValue;
+   if (gMappingFile->fetchWithPrefix(readerKeyword_.c_str(), readerTypeName_.c_str(), tag, *paramValue))
+   {
+      value = paramValue->data();
+      return FME_TRUE;
+   }
+   return FME_FALSE;
+}
+
+#ifndef FLUMORE_NO_MONO
+//===========================================================================
+// forwardParserMessages
+
+void FLUMOREReader::forwardParserMessages()
+{
+   _StringArray messages = Log_drain();
+   _Int32Array severities = Log_lastSeverities();
+   for (gint i = 0; i < messages.array->len; ++i)
+   {
+      char* msg = g_array_index(messages.array, char*, i);
+      const bool warning = i < gint(severities.array->len) &&
+                           g_array_index(severities.array, int32_t, i) == kFLUMOREParserWarning;
+      log_.message(msg, warning ? FME_WARN : FME_INFORM);
+      mono_free(msg);
+   }
+   g_array_free(severities.array, TRUE);
+   g_array_free(messages.array, TRUE);
+}
+
+
+//===========================================================================
+// collectParserStatistics
+
+void FLUMOREReader::collectParserStatistics(FLUMOREStats::Clock::duration loadTime)
+{
+   _Int64Array parserStats = Parser_lastStatistics();
+   if (parserStats.array->len >= kFLUMOREParserStatCount)
+   {
+      const int64_t* values = (const int64_t*)parserStats.array->data;
+      stats_.addMilliseconds(kFLUMOREPhaseRead, values[kFLUMOREParserStatReadMilliseconds]);
+      stats_.addMilliseconds(kFLUMOREPhaseScan, values[kFLUMOREParserStatScanMilliseconds]);
+      stats_.addMilliseconds(kFLUMOREPhaseDecode, values[kFLUMOREParserStatDecodeMilliseconds]);
+      stats_.addRowsFiltered(FME_UInt64(values[kFLUMOREParserStatRowsRejected]));
+      stats_.noteThreads(FME_UInt32(values[kFLUMOREParserStatThreads]));
+
+      // Whatever the parser didn't account for went into marshalling the
+      // result to C, which is part of decoding from the reader's view.
+      let parserTime = std::chrono::milliseconds(values[kFLUMOREParserStatReadMilliseconds]
+         + values[kFLUMOREParserStatScanMilliseconds] + values[kFLUMOREParserStatDecodeMilliseconds]);
+      if (loadTime > parserTime)
+      {
+         stats_.addTime(kFLUMOREPhaseDecode, loadTime - parserTime);
+      }
+   }
+   g_array_free(parserStats.array, TRUE);
+
+   ifstream input(dataset_.c_str(), ios::in | ios::binary | ios::ate);
+   if (input)
+   {
+      stats_.addBytes(FME_UInt64(input.tellg()));
+   }
 }
+#endif
+
+//===========================================================================
+// logStatistics
 
+void FLUMOREReader::logStatistics()
+{
+   if (log_.level() >= kFLUMORELogSummary)
+   {
+      log_.message(stats_.summary(dataset_).c_str());
+   }
+   if (!statsFile_.empty() && !stats_.writeJson(statsFile_, dataset_))
+   {
+      log_.message((kMsgStatsFileError + statsFile_).c_str(), FME_WARN);
+   }
+}
 
 //===========================================================================
 // Destructor
 FLUMOREReader::~FLUMOREReader()
 {
-    /*for (int i = 0; i < __parserResult_dataRows.size(); i++) {
-        let dataRow = __parserResult_dataRows[i];
-        mono_embeddinator_array
-        g_array_free(dataRow.array, true);
-    }*/
     close();
 }
\ No newline at end of file
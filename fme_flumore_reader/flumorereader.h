@@ -38,8 +38,18 @@
 #include <fmeread.h>
 #include <sstream>
 #include <string>
+#include <vector>
+#ifndef FLUMORE_NO_MONO
 #include <ImportSimulationData.h>
+#endif
 #include "Utils.hpp"
+#include "flumorearena.h"
+#include "flumorecache.h"
+#include "flumorefeaturebuilder.h"
+#include "flumorelog.h"
+#include "flumoreparser.h"
+#include "flumorereprojector.h"
+#include "flumorestats.h"
 
 using namespace std;
 
@@ -155,6 +165,108 @@ private:
    // FME_DEV_HOME/pluginbuilder/cpp/apidoc/classIFMEMappingFile.html
    void readParametersDialog();
 
+   // -----------------------------------------------------------------------
+   // fetchParameter
+   //
+   // Looks up a reader parameter from the mapping file using the reader
+   // keyword and type name as prefix. Returns FME_FALSE if it isn't set.
+   FME_Boolean fetchParameter(const char* tag, string& value) const;
+
+   // -----------------------------------------------------------------------
+   // readNative
+   //
+   // read() using FLUMOREParser. The dataset is scanned on the first call,
+   // the rows are decoded one Teilbereich block at a time.
+   FME_Status readNative(IFMEFeature& feature, FME_Boolean& endOfFile);
+
+   // -----------------------------------------------------------------------
+   // parseNative
+   //
+   // Opens the cache of the dataset or loads and scans the dataset with
+   // FLUMOREParser. Returns FME_FALSE if the dataset can't be read.
+   FME_Boolean parseNative();
+
+   // -----------------------------------------------------------------------
+   // scanNative
+   //
+   // Loads and scans the dataset with FLUMOREParser and logs its warnings.
+   // Returns FME_FALSE if the dataset can't be read.
+   FME_Boolean scanNative();
+
+   // -----------------------------------------------------------------------
+   // leaveCache
+   //
+   // Deletes the damaged cache and scans the dataset, whose blocks are
+   // read from the one the cache failed at on. Returns FME_FALSE if the
+   // dataset can't be read or doesn't have the blocks of the cache.
+   FME_Boolean leaveCache();
+
+   // -----------------------------------------------------------------------
+   // openReprojection
+   //
+   // Checks the reprojection parameters against the coordinate system,
+   // loads the datum grid and sets the coordinate system of the features.
+   void openReprojection();
+
+   // -----------------------------------------------------------------------
+   // openThreads
+   //
+   // Sizes the shared thread pool if the THREADS or CPU_SET parameter is
+   // set.
+   void openThreads();
+
+   // -----------------------------------------------------------------------
+   // selectPartition
+   //
+   // Picks the blocks of the partition from the scanned or cached blocks
+   // and logs its share of the dataset.
+   void selectPartition();
+
+#ifndef FLUMORE_NO_MONO
+   // -----------------------------------------------------------------------
+   // readMono
+   //
+   // read() using the F# parser through Mono. readStart is when the
+   // current read() call began.
+   FME_Status readMono(IFMEFeature& feature, FME_Boolean& endOfFile,
+                       FLUMOREStats::Clock::time_point readStart);
+
+   // -----------------------------------------------------------------------
+   // forwardParserMessages
+   //
+   // Moves the messages collected by the F# parser into the reader log,
+   // its warnings as warnings.
+   void forwardParserMessages();
+
+   // -----------------------------------------------------------------------
+   // collectParserStatistics
+   //
+   // Adds the timings and counters of the F# parser to stats_. The load
+   // time is the time the whole parser call took. The parser keeps them
+   // per thread, so this has to run on the thread which called it.
+   void collectParserStatistics(FLUMOREStats::Clock::duration loadTime);
+
+   // -----------------------------------------------------------------------
+   // releaseMonoTable
+   //
+   // Frees the rows and time of table index of the F# parser. Called as
+   // soon as read() has returned the last row of the table.
+   void releaseMonoTable(size_t index);
+
+   // -----------------------------------------------------------------------
+   // releaseMonoTables
+   //
+   // Frees all tables of the F# parser not returned yet, so the next
+   // dataset is parsed again.
+   void releaseMonoTables();
+#endif
+
+   // -----------------------------------------------------------------------
+   // logStatistics
+   //
+   // Logs the summary of stats_ and writes the JSON file if requested.
+   void logStatistics();
+
    // -----------------------------------------------------------------------
    // Insert additional private methods here
    // -----------------------------------------------------------------------
@@ -177,10 +289,25 @@ private:
    // passed in by the FME in the open() method.
    string dataset_;
 
-   // Stores the coordinate system of all the features in the file being read.
-   // Initialized to an empty string. Not used in this implementation.
+   // Stores the coordinate system of all the features in the file being read,
+   // from the COORDINATE_SYSTEM parameter. Empty if none is assigned.
    string coordSys_;
 
+   // Set if x and y are reprojected from GK3 to UTM zone 32N while
+   // reading, with the NTv2 grid at datumGrid_ if it is not empty.
+   // outsideDatumGrid_ counts the points the grid did not cover.
+   // reprojecting_ is set while reading the dataset open if it is in
+   // the source coordinate system, reproject_ stays as configured.
+   FME_Boolean reproject_;
+   FME_Boolean reprojecting_;
+   string datumGrid_;
+   FLUMOREReprojector reprojector_;
+   FME_UInt64 outsideDatumGrid_;
+
+   // The THREADS and CPU_SET parameters, 0 and empty if not set.
+   FME_UInt32 threads_;
+   string cpuSet_;
+
    // A pointer to an IFMEGeometryTools object which is used to create and
    // manipulate geometries.
    IFMEGeometryTools* fmeGeometryTools_;
@@ -188,7 +315,82 @@ private:
    // The parameters value used for reading the dataset.
    string myFormatParameter_;
 
-   _DataTableFLUMOREArray parserResult;
+   // Set if the dataset is read by FLUMOREParser instead of the F# parser.
+   // Always set in builds without Mono. useNative_ is the parser of the
+   // dataset open, also set if the F# parser can't read it.
+   FME_Boolean nativeParser_;
+   FME_Boolean useNative_;
+
+   // The native parser and the decoded rows of its current block.
+   // columns_ keeps its capacity from block to block, blockArena_ holds
+   // the intermediates of the current block and is reset for the next.
+   FLUMOREParser parser_;
+   FLUMOREColumns columns_;
+   FLUMOREArena blockArena_;
+
+   // The directory of the binary caches, empty if none are used. The
+   // cache is either read instead of the dataset (usingCache_) or written
+   // while the parser decodes the dataset.
+   string cacheDirectory_;
+   FLUMORECache cache_;
+   FME_Boolean usingCache_;
+
+   // The PARTITION_INDEX, PARTITION_COUNT and PARTITION_BY parameters.
+   // If partitionCount_ is more than 1 only the blocks in partition_ are
+   // read, nextBlock_ counts within them.
+   FME_UInt32 partitionIndex_;
+   FME_UInt32 partitionCount_;
+   FLUMOREPartitionUnit partitionUnit_;
+   vector<size_t> partition_;
+
+   // The next block to decode and the next row of columns_ to return.
+   size_t nextBlock_;
+   size_t nextRow_;
+
+   // Set once the native parser has scanned the dataset.
+   FME_Boolean parsed_;
+
+   // Set once readSchema() returned the schema feature.
+   FME_Boolean schemaRead_;
+
+#ifndef FLUMORE_NO_MONO
+   // The rows and time of one table returned by the F# parser.
+   struct MonoTable
+   {
+      _DataRowFLUMOREValueArray rows;
+      const char* date;
+   };
+
+   // The tables of the F# parser, the next one to return and its next
+   // row. Tables before nextTable_ have been released already.
+   vector<MonoTable> monoTables_;
+   size_t nextTable_;
+   size_t nextTableRow_;
+
+   // Set once the F# parser has read the dataset.
+   FME_Boolean monoParsed_;
+#endif
+
+   // Fills the features returned by read() from the parsed rows.
+   FLUMOREFeatureBuilder featureBuilder_;
+
+   // Level controlled logging; counts features and writes the summary.
+   FLUMORELog log_;
+
+   // Timings and counters of the current dataset.
+   FLUMOREStats stats_;
+
+   // Path of the JSON file the statistics are written to at close().
+   // Empty if no file was requested.
+   string statsFile_;
+
+   // When the previous read() returned, used to measure the time spent
+   // in FME. Default constructed while no feature is outstanding.
+   FLUMOREStats::Clock::time_point lastReadEnd_;
+
+   // Set between open() and the first close(), so the statistics are
+   // only reported once even though close() is called repeatedly.
+   FME_Boolean open_;
 
    // -----------------------------------------------------------------------
    // Insert additional private data members here
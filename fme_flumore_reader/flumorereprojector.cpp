@@ -0,0 +1,477 @@
+/*=============================================================================
+
+   Name     : flumorereprojector.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREReprojector method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorereprojector.h"
+#include "flumorethreadpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+const char* const FLUMOREReprojector::kSourceCoordSys = "EPSG:31467";
+const char* const FLUMOREReprojector::kTargetCoordSys = "EPSG:25832";
+
+namespace
+{
+   const double kPi = 3.14159265358979323846;
+   const double kRadiansPerSecond = kPi / (180.0 * 3600.0);
+
+   // Points per task when a transform is split over threads.
+   const size_t kRangePoints = 4096;
+
+   //------------------------------------------------------------------------
+   // An ellipsoid and a Transverse Mercator projection on it, with the
+   // coefficients of the Krueger series to the fourth order of n.
+   struct Projection
+   {
+      double a;
+      double e2;
+      double e;
+      double scaledRadius;   // k0 times the rectifying radius
+      double falseEasting;
+      double centralMeridian;
+      double alpha[4];
+      double beta[4];
+      double delta[4];
+   };
+
+   //------------------------------------------------------------------------
+   Projection makeProjection(double a, double inverseFlattening, double k0, double falseEasting,
+                             double centralMeridian)
+   {
+      Projection p;
+      const double f = 1.0 / inverseFlattening;
+      const double n = f / (2.0 - f);
+      const double n2 = n * n;
+      const double n3 = n2 * n;
+      const double n4 = n3 * n;
+      p.a = a;
+      p.e2 = f * (2.0 - f);
+      p.e = std::sqrt(p.e2);
+      p.scaledRadius = k0 * a / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0);
+      p.falseEasting = falseEasting;
+      p.centralMeridian = centralMeridian * kPi / 180.0;
+      p.alpha[0] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0 + 41.0 * n4 / 180.0;
+      p.alpha[1] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0 + 557.0 * n4 / 1440.0;
+      p.alpha[2] = 61.0 * n3 / 240.0 - 103.0 * n4 / 140.0;
+      p.alpha[3] = 49561.0 * n4 / 161280.0;
+      p.beta[0] = n / 2.0 - 2.0 * n2 / 3.0 + 37.0 * n3 / 96.0 - n4 / 360.0;
+      p.beta[1] = n2 / 48.0 + n3 / 15.0 - 437.0 * n4 / 1440.0;
+      p.beta[2] = 17.0 * n3 / 480.0 - 37.0 * n4 / 840.0;
+      p.beta[3] = 4397.0 * n4 / 161280.0;
+      p.delta[0] = 2.0 * n - 2.0 * n2 / 3.0 - 2.0 * n3 + 116.0 * n4 / 45.0;
+      p.delta[1] = 7.0 * n2 / 3.0 - 8.0 * n3 / 5.0 - 227.0 * n4 / 45.0;
+      p.delta[2] = 56.0 * n3 / 15.0 - 136.0 * n4 / 35.0;
+      p.delta[3] = 4279.0 * n4 / 630.0;
+      return p;
+   }
+
+   //------------------------------------------------------------------------
+   // Gauss-Krueger zone 3 on Bessel 1841 and UTM zone 32N on GRS80, made on
+   // first use so transforms during static initialization see them.
+   const Projection& gaussKrueger3()
+   {
+      static const Projection projection = makeProjection(6377397.155, 299.1528128, 1.0, 3500000.0, 9.0);
+      return projection;
+   }
+
+   //------------------------------------------------------------------------
+   const Projection& utm32()
+   {
+      static const Projection projection = makeProjection(6378137.0, 298.257222101, 0.9996, 500000.0, 9.0);
+      return projection;
+   }
+
+   // DHDN to WGS 84 as position vector transformation: the translation in
+   // metres, the rotation in seconds and the scale in ppm, the parameters
+   // PROJ uses for DHDN. ETRS89 and WGS 84 are the same at this accuracy.
+   const double kHelmertTranslation[3] = { 598.1, 73.7, 418.2 };
+   const double kHelmertRotation[3] = { 0.202, 0.045, -2.455 };
+   const double kHelmertScale = 6.7;
+
+   //------------------------------------------------------------------------
+   // The Krueger series c[0] sin(2 zeta) + ... + c[3] sin(8 zeta) of the
+   // complex zeta = xi + i eta, summed by Clenshaw's recurrence from the
+   // sine and cosine of 2 xi and the hyperbolic ones of 2 eta, so no
+   // further functions are evaluated per term.
+   inline void sineSeries(const double* c, double sin2xi, double cos2xi, double sinh2eta, double cosh2eta,
+                          double& real, double& imaginary)
+   {
+      const double sinReal = sin2xi * cosh2eta;
+      const double sinImaginary = cos2xi * sinh2eta;
+      const double twoCosReal = 2.0 * cos2xi * cosh2eta;
+      const double twoCosImaginary = -2.0 * sin2xi * sinh2eta;
+      double br = 0.0, bi = 0.0, previousR = 0.0, previousI = 0.0;
+      for (int k = 3; k >= 0; --k)
+      {
+         const double r = c[k] + twoCosReal * br - twoCosImaginary * bi - previousR;
+         const double i = twoCosReal * bi + twoCosImaginary * br - previousI;
+         previousR = br;
+         previousI = bi;
+         br = r;
+         bi = i;
+      }
+      real = br * sinReal - bi * sinImaginary;
+      imaginary = br * sinImaginary + bi * sinReal;
+   }
+
+   //------------------------------------------------------------------------
+   // The hyperbolic sine and cosine of x with one exponential.
+   inline void sinhCosh(double x, double& sinhX, double& coshX)
+   {
+      const double e = std::exp(x);
+      sinhX = 0.5 * (e - 1.0 / e);
+      coshX = 0.5 * (e + 1.0 / e);
+   }
+
+   //------------------------------------------------------------------------
+   // Easting and northing to longitude and latitude in radians.
+   inline void inverse(const Projection& p, double easting, double northing,
+                       double& longitude, double& latitude)
+   {
+      const double xi = northing / p.scaledRadius;
+      const double eta = (easting - p.falseEasting) / p.scaledRadius;
+      double sinh2eta, cosh2eta;
+      sinhCosh(2.0 * eta, sinh2eta, cosh2eta);
+      double dXi, dEta;
+      sineSeries(p.beta, std::sin(2.0 * xi), std::cos(2.0 * xi), sinh2eta, cosh2eta, dXi, dEta);
+      const double xiPrime = xi - dXi;
+      const double etaPrime = eta - dEta;
+
+      double sinhEta, coshEta;
+      sinhCosh(etaPrime, sinhEta, coshEta);
+      const double chi = std::asin(std::sin(xiPrime) / coshEta);
+      longitude = p.centralMeridian + std::atan2(sinhEta, std::cos(xiPrime));
+
+      // The real series of the latitude from the conformal latitude chi.
+      const double sin2chi = std::sin(2.0 * chi);
+      const double twoCos2chi = 2.0 * std::cos(2.0 * chi);
+      double b = 0.0, previous = 0.0;
+      for (int k = 3; k >= 0; --k)
+      {
+         const double next = p.delta[k] + twoCos2chi * b - previous;
+         previous = b;
+         b = next;
+      }
+      latitude = chi + b * sin2chi;
+   }
+
+   //------------------------------------------------------------------------
+   // Longitude and latitude in radians to easting and northing.
+   inline void forward(const Projection& p, double longitude, double latitude,
+                       double& easting, double& northing)
+   {
+      // t = sinh(atanh(s) - e atanh(e s)) through its exponential.
+      const double s = std::sin(latitude);
+      const double w = std::sqrt((1.0 + s) / (1.0 - s)) * std::pow((1.0 - p.e * s) / (1.0 + p.e * s), 0.5 * p.e);
+      const double t = 0.5 * (w - 1.0 / w);
+      const double dl = longitude - p.centralMeridian;
+      const double cosDl = std::cos(dl);
+      const double xiPrime = std::atan2(t, cosDl);
+      const double etaPrime = std::atanh(std::sin(dl) / std::sqrt(1.0 + t * t));
+
+      double sinh2eta, cosh2eta;
+      sinhCosh(2.0 * etaPrime, sinh2eta, cosh2eta);
+      double dXi, dEta;
+      sineSeries(p.alpha, std::sin(2.0 * xiPrime), std::cos(2.0 * xiPrime), sinh2eta, cosh2eta, dXi, dEta);
+      easting = p.falseEasting + p.scaledRadius * (etaPrime + dEta);
+      northing = p.scaledRadius * (xiPrime + dXi);
+   }
+
+   //------------------------------------------------------------------------
+   // Shifts longitude and latitude in radians from the ellipsoid of from
+   // to that of to with the Helmert parameters, at height 0.
+   inline void helmert(const Projection& from, const Projection& to, double& longitude, double& latitude)
+   {
+      const double sinLatitude = std::sin(latitude);
+      const double cosLatitude = std::cos(latitude);
+      const double radius = from.a / std::sqrt(1.0 - from.e2 * sinLatitude * sinLatitude);
+      const double x = radius * cosLatitude * std::cos(longitude);
+      const double y = radius * cosLatitude * std::sin(longitude);
+      const double z = radius * (1.0 - from.e2) * sinLatitude;
+
+      const double rx = kHelmertRotation[0] * kRadiansPerSecond;
+      const double ry = kHelmertRotation[1] * kRadiansPerSecond;
+      const double rz = kHelmertRotation[2] * kRadiansPerSecond;
+      const double scale = 1.0 + kHelmertScale * 1e-6;
+      const double x2 = kHelmertTranslation[0] + scale * (x - rz * y + ry * z);
+      const double y2 = kHelmertTranslation[1] + scale * (rz * x + y - rx * z);
+      const double z2 = kHelmertTranslation[2] + scale * (-ry * x + rx * y + z);
+
+      // Bowring's formula, exact to far below a millimetre this close to
+      // the ellipsoid.
+      const double b = to.a * std::sqrt(1.0 - to.e2);
+      const double p = std::sqrt(x2 * x2 + y2 * y2);
+      const double tanTheta = z2 * to.a / (p * b);
+      const double cosTheta = 1.0 / std::sqrt(1.0 + tanTheta * tanTheta);
+      const double sinTheta = tanTheta * cosTheta;
+      const double secondE2 = to.e2 / (1.0 - to.e2);
+      longitude = std::atan2(y2, x2);
+      latitude = std::atan2(z2 + secondE2 * b * sinTheta * sinTheta * sinTheta,
+                            p - to.e2 * to.a * cosTheta * cosTheta * cosTheta);
+   }
+
+   //------------------------------------------------------------------------
+   // Reads the value of the 16 byte NTv2 record at offset, swapping the
+   // bytes if the file has the other byte order.
+   template <typename T>
+   T recordValue(const vector<char>& file, size_t offset, bool swap)
+   {
+      char bytes[sizeof(T)];
+      memcpy(bytes, &file[offset + 8], sizeof(T));
+      if (swap)
+      {
+         std::reverse(bytes, bytes + sizeof(T));
+      }
+      T value;
+      memcpy(&value, bytes, sizeof(T));
+      return value;
+   }
+
+   //------------------------------------------------------------------------
+   // Whether the 16 byte NTv2 record at offset is called name.
+   bool recordIs(const vector<char>& file, size_t offset, const char* name)
+   {
+      const size_t length = strlen(name);
+      return memcmp(&file[offset], name, length) == 0 &&
+             (length == 8 || file[offset + length] == ' ' || file[offset + length] == '\0');
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMOREReprojector::FLUMOREReprojector()
+:
+   grids_(),
+   error_("")
+{
+}
+
+//===========================================================================
+// Clear
+void FLUMOREReprojector::clear()
+{
+   vector<Grid>().swap(grids_);
+}
+
+//===========================================================================
+// Load Grid
+bool FLUMOREReprojector::loadGrid(const string& path)
+{
+   clear();
+   error_.clear();
+   const size_t kRecord = 16;
+
+   ifstream in(path.c_str(), ios::in | ios::binary);
+   if (!in)
+   {
+      error_ = "cannot open the NTv2 grid " + path;
+      return false;
+   }
+   vector<char> file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+   if (file.size() < 11 * kRecord || !recordIs(file, 0, "NUM_OREC"))
+   {
+      error_ = "not an NTv2 grid: " + path;
+      return false;
+   }
+   bool swap = false;
+   if (recordValue<int32_t>(file, 0, false) != 11)
+   {
+      swap = true;
+      if (recordValue<int32_t>(file, 0, true) != 11)
+      {
+         error_ = "not an NTv2 grid: " + path;
+         return false;
+      }
+   }
+   const size_t overviewRecords = size_t(recordValue<int32_t>(file, 0, swap));
+   const int32_t subRecords = recordValue<int32_t>(file, kRecord, swap);
+   const int32_t subGrids = recordValue<int32_t>(file, 2 * kRecord, swap);
+   if (subRecords < 11 || subGrids < 1)
+   {
+      error_ = "not an NTv2 grid: " + path;
+      return false;
+   }
+
+   size_t offset = overviewRecords * kRecord;
+   for (int32_t g = 0; g < subGrids; ++g)
+   {
+      if (offset + size_t(subRecords) * kRecord > file.size())
+      {
+         error_ = "truncated NTv2 grid: " + path;
+         clear();
+         return false;
+      }
+      Grid grid;
+      double* const bounds[] =
+      {
+         &grid.south, &grid.north, &grid.east, &grid.west, &grid.latitudeStep, &grid.longitudeStep
+      };
+      const char* const boundNames[] = { "S_LAT", "N_LAT", "E_LONG", "W_LONG", "LAT_INC", "LONG_INC" };
+      size_t found = 0;
+      int32_t nodes = 0;
+      for (int32_t r = 0; r < subRecords; ++r)
+      {
+         const size_t record = offset + size_t(r) * kRecord;
+         for (size_t b = 0; b < 6; ++b)
+         {
+            if (recordIs(file, record, boundNames[b]))
+            {
+               *bounds[b] = recordValue<double>(file, record, swap);
+               ++found;
+            }
+         }
+         if (recordIs(file, record, "GS_COUNT"))
+         {
+            nodes = recordValue<int32_t>(file, record, swap);
+            ++found;
+         }
+      }
+      offset += size_t(subRecords) * kRecord;
+
+      if (found != 7 || !(grid.latitudeStep > 0.0) || !(grid.longitudeStep > 0.0) ||
+          !(grid.north > grid.south) || !(grid.west > grid.east))
+      {
+         error_ = "invalid sub grid in NTv2 grid " + path;
+         clear();
+         return false;
+      }
+      grid.rows = size_t(std::floor((grid.north - grid.south) / grid.latitudeStep + 0.5)) + 1;
+      grid.columns = size_t(std::floor((grid.west - grid.east) / grid.longitudeStep + 0.5)) + 1;
+      if (nodes < 0 || size_t(nodes) != grid.rows * grid.columns ||
+          offset + size_t(nodes) * kRecord > file.size())
+      {
+         error_ = "truncated NTv2 grid: " + path;
+         clear();
+         return false;
+      }
+
+      // Only the shifts are kept, not their accuracies.
+      grid.shifts.resize(2 * size_t(nodes));
+      for (size_t i = 0; i < size_t(nodes); ++i)
+      {
+         for (size_t k = 0; k < 2; ++k)
+         {
+            char bytes[4];
+            memcpy(bytes, &file[offset + i * kRecord + 4 * k], 4);
+            if (swap)
+            {
+               std::reverse(bytes, bytes + 4);
+            }
+            memcpy(&grid.shifts[2 * i + k], bytes, 4);
+         }
+      }
+      offset += size_t(nodes) * kRecord;
+      grids_.push_back(grid);
+   }
+
+   std::stable_sort(grids_.begin(), grids_.end(), [](const Grid& a, const Grid& b)
+   {
+      return a.latitudeStep * a.longitudeStep < b.latitudeStep * b.longitudeStep;
+   });
+   return true;
+}
+
+//===========================================================================
+// Shift By Grid
+bool FLUMOREReprojector::shiftByGrid(double& latitude, double& longitude) const
+{
+   const double north = latitude / kRadiansPerSecond;
+   const double west = -longitude / kRadiansPerSecond;
+   for (size_t g = 0; g < grids_.size(); ++g)
+   {
+      const Grid& grid = grids_[g];
+      if (north < grid.south || north > grid.north || west < grid.east || west > grid.west)
+      {
+         continue;
+      }
+      const double row = (north - grid.south) / grid.latitudeStep;
+      const double column = (west - grid.east) / grid.longitudeStep;
+      const size_t r = std::min(size_t(row), grid.rows - 2);
+      const size_t c = std::min(size_t(column), grid.columns - 2);
+      const double v = row - double(r);
+      const double u = column - double(c);
+      const float* const lower = &grid.shifts[2 * (r * grid.columns + c)];
+      const float* const upper = lower + 2 * grid.columns;
+      double shifts[2];
+      for (size_t k = 0; k < 2; ++k)
+      {
+         shifts[k] = (1.0 - v) * ((1.0 - u) * lower[k] + u * lower[k + 2]) +
+                     v * ((1.0 - u) * upper[k] + u * upper[k + 2]);
+      }
+      latitude += shifts[0] * kRadiansPerSecond;
+      // The longitude shift is positive west as well.
+      longitude -= shifts[1] * kRadiansPerSecond;
+      return true;
+   }
+   return false;
+}
+
+//===========================================================================
+// Transform
+size_t FLUMOREReprojector::transform(double* x, double* y, size_t count, size_t threads) const
+{
+   if (threads == 0)
+   {
+      threads = FLUMOREThreadPool::defaultThreads();
+   }
+   const size_t ranges = (count + kRangePoints - 1) / kRangePoints;
+   if (threads <= 1 || ranges <= 1)
+   {
+      return transformRange(x, y, count);
+   }
+   vector<size_t> outside(ranges, 0);
+   FLUMOREThreadPool::forEach(ranges, threads, [&](size_t r)
+   {
+      const size_t begin = r * kRangePoints;
+      outside[r] = transformRange(x + begin, y + begin, std::min(kRangePoints, count - begin));
+      return true;
+   });
+   size_t total = 0;
+   for (size_t r = 0; r < ranges; ++r)
+   {
+      total += outside[r];
+   }
+   return total;
+}
+
+//===========================================================================
+// Transform Range
+size_t FLUMOREReprojector::transformRange(double* x, double* y, size_t count) const
+{
+   // Every stage is one pass over the columns; x and y hold the longitude
+   // and latitude in radians in between.
+   const Projection& source = gaussKrueger3();
+   const Projection& target = utm32();
+   for (size_t i = 0; i < count; ++i)
+   {
+      inverse(source, x[i], y[i], x[i], y[i]);
+   }
+
+   size_t outside = 0;
+   for (size_t i = 0; i < count; ++i)
+   {
+      if (grids_.empty() || !shiftByGrid(y[i], x[i]))
+      {
+         outside += grids_.empty() ? 0 : 1;
+         helmert(source, target, x[i], y[i]);
+      }
+   }
+
+   for (size_t i = 0; i < count; ++i)
+   {
+      forward(target, x[i], y[i], x[i], y[i]);
+   }
+   return outside;
+}
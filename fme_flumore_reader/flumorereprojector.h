@@ -0,0 +1,124 @@
+#ifndef FLUMORE_REPROJECTOR_H
+#define FLUMORE_REPROJECTOR_H
+/*=============================================================================
+
+   Name     : flumorereprojector.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREReprojector, the bulk reprojection of
+              the decoded coordinates
+
+=============================================================================*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// FLUMOREReprojector
+//
+// Reprojects the x and y columns of decoded rows from DHDN / Gauss-
+// Krueger zone 3 (EPSG:31467) to ETRS89 / UTM zone 32N (EPSG:25832),
+// whole columns at a time: the inverse Transverse Mercator on the Bessel
+// ellipsoid, the datum shift and the forward Transverse Mercator on
+// GRS80 each run as one loop over the columns. Both projections use the
+// Krueger series, exact to well below a millimetre within the zones.
+// The datum is shifted with the 7 parameter Helmert transformation PROJ
+// uses for DHDN, good to a metre or two, or with an NTv2 grid such as
+// BeTA2007 where one is loaded; points outside the grid fall back to the
+// Helmert parameters.
+// Heights are left as they are.
+// Errors are reported by the return value; error() describes them.
+class FLUMOREReprojector
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREReprojector();
+
+   // -----------------------------------------------------------------------
+   // loadGrid()
+   // Reads the NTv2 grid file at path, replacing a grid loaded before.
+   // Grid files with several sub grids use the finest one containing a
+   // point.
+   bool loadGrid(const string& path);
+
+   // -----------------------------------------------------------------------
+   // clear()
+   // Drops the grid, the Helmert parameters are used again.
+   void clear();
+
+   // -----------------------------------------------------------------------
+   // transform()
+   // Reprojects count points in place and returns the number of them
+   // which were outside the grid; without a grid it returns 0. More than
+   // a few thousand points are split into ranges transformed on up to
+   // threads threads, those of the shared pool if it is 0.
+   size_t transform(double* x, double* y, size_t count, size_t threads = 1) const;
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   bool hasGrid() const { return !grids_.empty(); }
+   const string& error() const { return error_; }
+
+   // -----------------------------------------------------------------------
+   // The coordinate systems reprojected from and to.
+   static const char* const kSourceCoordSys;
+   static const char* const kTargetCoordSys;
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREReprojector(const FLUMOREReprojector&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREReprojector &operator=(const FLUMOREReprojector&);
+
+   //=====================================================================
+   // One sub grid of an NTv2 file. The bounds and increments are in
+   // seconds with longitudes positive west, as in the file; the shifts
+   // of every node are the latitude and the longitude shift in seconds.
+   struct Grid
+   {
+      double south;
+      double north;
+      double east;
+      double west;
+      double latitudeStep;
+      double longitudeStep;
+      size_t rows;
+      size_t columns;
+      vector<float> shifts;
+   };
+
+   // -----------------------------------------------------------------------
+   // transformRange()
+   // transform() of count points on the calling thread.
+   size_t transformRange(double* x, double* y, size_t count) const;
+
+   // -----------------------------------------------------------------------
+   // shiftByGrid()
+   // Shifts the DHDN latitude and longitude in radians to ETRS89 with the
+   // finest grid containing them. Returns false outside all grids.
+   bool shiftByGrid(double& latitude, double& longitude) const;
+
+   // Data members
+
+   // The sub grids of the loaded NTv2 file, the finest ones first.
+   vector<Grid> grids_;
+
+   // Describes why the last call failed.
+   string error_;
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*=============================================================================
+
+   Name     : flumorestats.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREStats method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorestats.h"
+#include "flumorepriv.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+   // Names of the phases as used in the log summary and the JSON file.
+   const char* const kPhaseNames[kFLUMOREPhaseCount] =
+   {
+      "open", "read", "scan", "decode", "reproject", "feature_build", "fme_callback"
+   };
+
+   //------------------------------------------------------------------------
+   // Escapes a string for use inside a JSON string literal.
+   string jsonEscape(const string& value)
+   {
+      ostringstream escaped;
+      for (string::const_iterator it = value.begin(); it != value.end(); ++it)
+      {
+         const unsigned char c = static_cast<unsigned char>(*it);
+         switch (c)
+         {
+         case '"':  escaped << "\\\""; break;
+         case '\\': escaped << "\\\\"; break;
+         case '\n': escaped << "\\n"; break;
+         case '\r': escaped << "\\r"; break;
+         case '\t': escaped << "\\t"; break;
+         default:
+            if (c < 0x20)
+            {
+               escaped << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec;
+            }
+            else
+            {
+               escaped << *it;
+            }
+         }
+      }
+      return escaped.str();
+   }
+
+   //------------------------------------------------------------------------
+   // Returns count / seconds, or zero if no time was measured.
+   double perSecond(FME_UInt64 count, double seconds)
+   {
+      return (seconds > 0.0) ? double(count) / seconds : 0.0;
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMOREStats::FLUMOREStats()
+{
+   reset();
+}
+
+//===========================================================================
+// Reset
+void FLUMOREStats::reset()
+{
+   for (int i = 0; i < kFLUMOREPhaseCount; ++i)
+   {
+      phaseTimes_[i] = Clock::duration::zero();
+   }
+   rows_ = 0;
+   bytes_ = 0;
+   rowsFiltered_ = 0;
+   threads_ = 1;
+}
+
+//===========================================================================
+// Add Milliseconds
+void FLUMOREStats::addMilliseconds(FLUMOREPhase phase, FME_Int64 milliseconds)
+{
+   addTime(phase, std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(milliseconds)));
+}
+
+//===========================================================================
+// Note Threads
+void FLUMOREStats::noteThreads(FME_UInt32 threads)
+{
+   if (threads > threads_)
+   {
+      threads_ = threads;
+   }
+}
+
+//===========================================================================
+// Seconds
+double FLUMOREStats::seconds(FLUMOREPhase phase) const
+{
+   return std::chrono::duration<double>(phaseTimes_[phase]).count();
+}
+
+//===========================================================================
+// Total Seconds
+double FLUMOREStats::totalSeconds() const
+{
+   double total = 0.0;
+   for (int i = 0; i < kFLUMOREPhaseCount; ++i)
+   {
+      total += seconds(FLUMOREPhase(i));
+   }
+   return total;
+}
+
+//===========================================================================
+// Summary
+string FLUMOREStats::summary(const string& dataset) const
+{
+   const double total = totalSeconds();
+
+   ostringstream line;
+   line << fixed << setprecision(3);
+   line << kMsgStatsSummary << dataset << ":";
+   for (int i = 0; i < kFLUMOREPhaseCount; ++i)
+   {
+      line << " " << kPhaseNames[i] << " " << seconds(FLUMOREPhase(i)) << " s,";
+   }
+   line << setprecision(0)
+        << " " << rows_ << " rows (" << perSecond(rows_, total) << " rows/s),"
+        << " " << bytes_ << " bytes (" << perSecond(bytes_, total) << " bytes/s),"
+        << " " << rowsFiltered_ << " rows filtered,"
+        << " peak memory " << peakResidentBytes() << " bytes,"
+        << " " << threads_ << " threads";
+   return line.str();
+}
+
+//===========================================================================
+// Write JSON
+FME_Boolean FLUMOREStats::writeJson(const string& path, const string& dataset) const
+{
+   ofstream out(path.c_str(), ios::out | ios::trunc);
+   if (!out)
+   {
+      return FME_FALSE;
+   }
+
+   const double total = totalSeconds();
+
+   out << fixed << setprecision(6);
+   out << "{\n";
+   out << "  \"dataset\": \"" << jsonEscape(dataset) << "\",\n";
+   out << "  \"phases_seconds\": {\n";
+   for (int i = 0; i < kFLUMOREPhaseCount; ++i)
+   {
+      out << "    \"" << kPhaseNames[i] << "\": " << seconds(FLUMOREPhase(i))
+          << ((i + 1 < kFLUMOREPhaseCount) ? ",\n" : "\n");
+   }
+   out << "  },\n";
+   out << "  \"total_seconds\": " << total << ",\n";
+   out << "  \"rows\": " << rows_ << ",\n";
+   out << "  \"rows_per_second\": " << perSecond(rows_, total) << ",\n";
+   out << "  \"bytes\": " << bytes_ << ",\n";
+   out << "  \"bytes_per_second\": " << perSecond(bytes_, total) << ",\n";
+   out << "  \"rows_filtered\": " << rowsFiltered_ << ",\n";
+   out << "  \"peak_resident_bytes\": " << peakResidentBytes() << ",\n";
+   out << "  \"threads\": " << threads_ << "\n";
+   out << "}\n";
+
+   return out.good() ? FME_TRUE : FME_FALSE;
+}
+
+//===========================================================================
+// Peak Resident Bytes
+FME_UInt64 FLUMOREStats::peakResidentBytes()
+{
+#ifdef WIN32
+   PROCESS_MEMORY_COUNTERS counters;
+   if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+   {
+      return FME_UInt64(counters.PeakWorkingSetSize);
+   }
+   return 0;
+#else
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+   {
+      // ru_maxrss is reported in kilobytes on Linux.
+      return FME_UInt64(usage.ru_maxrss) * 1024;
+   }
+   return 0;
+#endif
+}
@@ -0,0 +1,160 @@
+#ifndef FLUMORE_STATS_H
+#define FLUMORE_STATS_H
+/*=============================================================================
+
+   Name     : flumorestats.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREStats
+
+=============================================================================*/
+
+#include <fmetypes.h>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+//=====================================================================
+// The phases a reader spends its time in.
+enum FLUMOREPhase
+{
+   // open() of the reader.
+   kFLUMOREPhaseOpen = 0,
+   // Reading the dataset from disk.
+   kFLUMOREPhaseRead,
+   // Finding the headers and Teilbereich blocks.
+   kFLUMOREPhaseScan,
+   // Converting the rows into numbers.
+   kFLUMOREPhaseDecode,
+   // Reprojecting the decoded coordinates.
+   kFLUMOREPhaseReproject,
+   // Filling the features inside read().
+   kFLUMOREPhaseFeatureBuild,
+   // Time spent in FME between two read() calls.
+   kFLUMOREPhaseCallback,
+   kFLUMOREPhaseCount
+};
+
+//=====================================================================
+// Order of the values returned by Parser_lastStatistics(), has to match
+// the stat* literals in Parser.fs.
+enum FLUMOREParserStatistic
+{
+   kFLUMOREParserStatReadMilliseconds = 0,
+   kFLUMOREParserStatScanMilliseconds,
+   kFLUMOREParserStatDecodeMilliseconds,
+   kFLUMOREParserStatRowsRejected,
+   kFLUMOREParserStatThreads,
+   kFLUMOREParserStatCount
+};
+
+//=====================================================================
+// FLUMOREStats
+//
+// Performance counters of one reader run: the time spent per phase,
+// the number of rows and bytes processed, and the peak memory and number
+// of threads used. The reader logs them as one summary at close() and
+// optionally writes them as JSON for job monitoring.
+class FLUMOREStats
+{
+
+public:
+
+   typedef std::chrono::steady_clock Clock;
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   FLUMOREStats();
+
+   // -----------------------------------------------------------------------
+   // reset()
+   // Clears all counters, called when a dataset is opened.
+   void reset();
+
+   // -----------------------------------------------------------------------
+   // addTime()
+   void addTime(FLUMOREPhase phase, Clock::duration duration)
+   {
+      phaseTimes_[phase] += duration;
+   }
+
+   // -----------------------------------------------------------------------
+   // addMilliseconds()
+   // For phases measured outside of C++, e.g. by the F# parser.
+   void addMilliseconds(FLUMOREPhase phase, FME_Int64 milliseconds);
+
+   // -----------------------------------------------------------------------
+   // Counters
+   void addRows(FME_UInt64 rows) { rows_ += rows; }
+   void addBytes(FME_UInt64 bytes) { bytes_ += bytes; }
+   void addRowsFiltered(FME_UInt64 rows) { rowsFiltered_ += rows; }
+   void noteThreads(FME_UInt32 threads);
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   FME_UInt64 rows() const { return rows_; }
+   FME_UInt64 bytes() const { return bytes_; }
+   FME_UInt64 rowsFiltered() const { return rowsFiltered_; }
+   FME_UInt32 threads() const { return threads_; }
+   double seconds(FLUMOREPhase phase) const;
+   double totalSeconds() const;
+
+   // -----------------------------------------------------------------------
+   // summary()
+   // One line with all counters, meant for the FME log.
+   string summary(const string& dataset) const;
+
+   // -----------------------------------------------------------------------
+   // writeJson()
+   // Writes all counters to the given file. Returns FME_FALSE if the file
+   // could not be written.
+   FME_Boolean writeJson(const string& path, const string& dataset) const;
+
+   // -----------------------------------------------------------------------
+   // peakResidentBytes()
+   // Peak resident memory of the whole process so far, zero if unknown.
+   static FME_UInt64 peakResidentBytes();
+
+   //=====================================================================
+   // Timer
+   //
+   // Adds the time between construction and destruction to a phase.
+   class Timer
+   {
+   public:
+      Timer(FLUMOREStats& stats, FLUMOREPhase phase)
+      : stats_(stats), phase_(phase), start_(Clock::now()) {}
+      ~Timer() { stats_.addTime(phase_, Clock::now() - start_); }
+   private:
+      Timer(const Timer&);
+      Timer &operator=(const Timer&);
+      FLUMOREStats& stats_;
+      FLUMOREPhase phase_;
+      Clock::time_point start_;
+   };
+
+private:
+
+   // Data members
+
+   // Accumulated time per phase.
+   Clock::duration phaseTimes_[kFLUMOREPhaseCount];
+
+   // Rows turned into features.
+   FME_UInt64 rows_;
+
+   // Bytes of input processed.
+   FME_UInt64 bytes_;
+
+   // Rows dropped, e.g. because they could not be parsed.
+   FME_UInt64 rowsFiltered_;
+
+   // The highest number of threads used by any phase.
+   FME_UInt32 threads_;
+};
+
+#endif
@@ -0,0 +1,418 @@
+/*=============================================================================
+
+   Name     : flumorethreadpool.cpp
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : FLUMOREThreadPool method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "flumorethreadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+#if defined(WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+   // The number of the thread submitting tasks, 0 until it submits the
+   // first one. Workers take over the number of the task they run.
+   thread_local size_t tSubmitter = 0;
+   atomic<size_t> gNextSubmitter(1);
+
+   //------------------------------------------------------------------------
+   // The workers and cpus of the shared pool from the environment, with
+   // threads and cpuSet taking precedence where they are set.
+   bool sharedSettings(size_t& threads, string& cpuSet, vector<size_t>& cpus)
+   {
+      if (cpuSet.empty())
+      {
+         const char* const value = getenv("FLUMORE_CPU_SET");
+         cpuSet = value != NULL ? value : "";
+      }
+      if (threads == 0)
+      {
+         const char* const value = getenv("FLUMORE_THREADS");
+         threads = value != NULL ? size_t(strtoul(value, NULL, 10)) : 0;
+      }
+      cpus.clear();
+      if (!cpuSet.empty() && !FLUMOREThreadPool::parseCpuSet(cpuSet, cpus))
+      {
+         cpus.clear();
+         return false;
+      }
+      return true;
+   }
+
+   //=====================================================================
+   // One call of forEach(). The indices are claimed from next; every
+   // claimed index below count is counted in finished once it ran or was
+   // skipped after a failure. The workers hold the job until they ran,
+   // which may be after forEach() returned, they find no index left then.
+   struct Job
+   {
+      Job(size_t count, const function<bool(size_t)>& task)
+      :
+         count(count),
+         task(task),
+         next(0),
+         ok(true),
+         finished(0)
+      {
+      }
+
+      const size_t count;
+      const function<bool(size_t)>& task;
+      atomic<size_t> next;
+      atomic<bool> ok;
+      size_t finished;
+      mutex lock;
+      condition_variable done;
+   };
+
+   //------------------------------------------------------------------------
+   // Runs indices of job until none is left.
+   void runJob(Job& job)
+   {
+      size_t finished = 0;
+      for (size_t i = job.next++; i < job.count; i = job.next++)
+      {
+         if (job.ok && !job.task(i))
+         {
+            job.ok = false;
+         }
+         ++finished;
+      }
+      if (finished > 0)
+      {
+         lock_guard<mutex> guard(job.lock);
+         job.finished += finished;
+         if (job.finished == job.count)
+         {
+            job.done.notify_all();
+         }
+      }
+   }
+}
+
+//===========================================================================
+// Constructor
+FLUMOREThreadPool::FLUMOREThreadPool(size_t threads, const vector<size_t>& cpus)
+:
+   next_(0),
+   active_(0),
+   stopping_(false)
+{
+   resize(threads, cpus);
+}
+
+//===========================================================================
+// Destructor
+FLUMOREThreadPool::~FLUMOREThreadPool()
+{
+   {
+      lock_guard<mutex> guard(lock_);
+      stopping_ = true;
+   }
+   wakeUp_.notify_all();
+   for (size_t i = 0; i < workers_.size(); ++i)
+   {
+      workers_[i].join();
+   }
+}
+
+//===========================================================================
+// Submit
+void FLUMOREThreadPool::submit(const function<void()>& task)
+{
+   if (tSubmitter == 0)
+   {
+      tSubmitter = gNextSubmitter++;
+   }
+   bool parked = false;
+   {
+      lock_guard<mutex> guard(lock_);
+      tasks_[tSubmitter].push_back(task);
+      parked = workers_.size() > active_;
+   }
+   // A parked worker would take the only wake up and go on waiting.
+   if (parked)
+   {
+      wakeUp_.notify_all();
+   }
+   else
+   {
+      wakeUp_.notify_one();
+   }
+}
+
+//===========================================================================
+// Resize
+bool FLUMOREThreadPool::resize(size_t threads, const vector<size_t>& cpus)
+{
+   if (threads == 0)
+   {
+      threads = cpus.empty() ? hardwareThreads() : cpus.size();
+   }
+   bool ok = true;
+   {
+      lock_guard<mutex> guard(lock_);
+      // The new workers wait for the lock before they look for tasks.
+      for (size_t i = workers_.size(); i < threads; ++i)
+      {
+         workers_.push_back(thread(&FLUMOREThreadPool::work, this, i));
+      }
+      active_ = threads;
+      const bool pinned = !cpus_.empty();
+      cpus_ = cpus;
+      if (pinned || !cpus_.empty())
+      {
+         ok = pin();
+      }
+   }
+   wakeUp_.notify_all();
+   return ok;
+}
+
+//===========================================================================
+// Threads
+size_t FLUMOREThreadPool::threads() const
+{
+   lock_guard<mutex> guard(lock_);
+   return active_;
+}
+
+//===========================================================================
+// Shared
+FLUMOREThreadPool& FLUMOREThreadPool::shared()
+{
+   // Never destroyed: the workers must not be joined while the plug-in is
+   // unloaded, they end with the process.
+   static FLUMOREThreadPool* const pool = []()
+   {
+      size_t threads = 0;
+      string cpuSet;
+      vector<size_t> cpus;
+      sharedSettings(threads, cpuSet, cpus);
+      return new FLUMOREThreadPool(threads, cpus);
+   }();
+   return *pool;
+}
+
+//===========================================================================
+// Configure Shared
+bool FLUMOREThreadPool::configureShared(size_t threads, const string& cpuSet, string& error)
+{
+   string set = cpuSet;
+   vector<size_t> cpus;
+   bool ok = true;
+   if (!sharedSettings(threads, set, cpus))
+   {
+      error = "Invalid cpu set " + set;
+      ok = false;
+   }
+   if (!shared().resize(threads, cpus))
+   {
+      error = "Could not pin the threads to the cpus " + set;
+      ok = false;
+   }
+   return ok;
+}
+
+//===========================================================================
+// Default Threads
+size_t FLUMOREThreadPool::defaultThreads()
+{
+   return std::max(shared().threads(), size_t(1));
+}
+
+//===========================================================================
+// Hardware Threads
+size_t FLUMOREThreadPool::hardwareThreads()
+{
+   const unsigned int hardware = thread::hardware_concurrency();
+   return hardware > 0 ? size_t(hardware) : 1;
+}
+
+//===========================================================================
+// Parse Cpu Set
+bool FLUMOREThreadPool::parseCpuSet(const string& text, vector<size_t>& cpus)
+{
+   cpus.clear();
+   const char* p = text.c_str();
+   for (;;)
+   {
+      char* end = NULL;
+      const unsigned long first = strtoul(p, &end, 10);
+      if (end == p || *p == '-' || *p == '+')
+      {
+         return false;
+      }
+      unsigned long last = first;
+      p = end;
+      if (*p == '-')
+      {
+         ++p;
+         last = strtoul(p, &end, 10);
+         if (end == p || *p == '-' || *p == '+' || last < first)
+         {
+            return false;
+         }
+         p = end;
+      }
+      for (unsigned long cpu = first; cpu <= last; ++cpu)
+      {
+         cpus.push_back(size_t(cpu));
+      }
+      if (*p == '\0')
+      {
+         break;
+      }
+      if (*p++ != ',')
+      {
+         return false;
+      }
+   }
+   sort(cpus.begin(), cpus.end());
+   cpus.erase(unique(cpus.begin(), cpus.end()), cpus.end());
+   return true;
+}
+
+//===========================================================================
+// For Each
+bool FLUMOREThreadPool::forEach(size_t count, size_t threads, const function<bool(size_t)>& task)
+{
+   threads = std::min(threads, count);
+   if (threads <= 1)
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         if (!task(i))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // The calling thread is one of the threads.
+   FLUMOREThreadPool& pool = shared();
+   const size_t helpers = std::min(threads - 1, pool.threads());
+   const shared_ptr<Job> job = make_shared<Job>(count, task);
+   for (size_t t = 0; t < helpers; ++t)
+   {
+      pool.submit([job]() { runJob(*job); });
+   }
+   runJob(*job);
+
+   unique_lock<mutex> guard(job->lock);
+   while (job->finished < count)
+   {
+      job->done.wait(guard);
+   }
+   return job->ok;
+}
+
+//===========================================================================
+// Work
+void FLUMOREThreadPool::work(size_t index)
+{
+   for (;;)
+   {
+      function<void()> task;
+      {
+         unique_lock<mutex> guard(lock_);
+         while ((tasks_.empty() || index >= active_) && !stopping_)
+         {
+            wakeUp_.wait(guard);
+         }
+         if (tasks_.empty())
+         {
+            return;
+         }
+         // The queues take turns, from the one after the last served.
+         map<size_t, deque<function<void()> > >::iterator queue = tasks_.lower_bound(next_);
+         if (queue == tasks_.end())
+         {
+            queue = tasks_.begin();
+         }
+         tSubmitter = queue->first;
+         next_ = queue->first + 1;
+         task.swap(queue->second.front());
+         queue->second.pop_front();
+         if (queue->second.empty())
+         {
+            tasks_.erase(queue);
+         }
+      }
+      task();
+   }
+}
+
+//===========================================================================
+// Pin
+bool FLUMOREThreadPool::pin()
+{
+#if defined(WIN32)
+   DWORD_PTR mask = 0;
+   if (cpus_.empty())
+   {
+      DWORD_PTR system = 0;
+      if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &system))
+      {
+         return false;
+      }
+   }
+   for (size_t i = 0; i < cpus_.size(); ++i)
+   {
+      if (cpus_[i] >= sizeof(DWORD_PTR) * 8)
+      {
+         return false;
+      }
+      mask |= DWORD_PTR(1) << cpus_[i];
+   }
+   bool ok = true;
+   for (size_t i = 0; i < workers_.size(); ++i)
+   {
+      ok = SetThreadAffinityMask(workers_[i].native_handle(), mask) != 0 && ok;
+   }
+   return ok;
+#elif defined(__linux__)
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+   {
+      if (cpus_.empty() || binary_search(cpus_.begin(), cpus_.end(), cpu))
+      {
+         CPU_SET(cpu, &set);
+      }
+   }
+   if (!cpus_.empty() && cpus_.back() >= CPU_SETSIZE)
+   {
+      return false;
+   }
+   bool ok = true;
+   for (size_t i = 0; i < workers_.size(); ++i)
+   {
+      ok = pthread_setaffinity_np(workers_[i].native_handle(), sizeof(set), &set) == 0 && ok;
+   }
+   return ok;
+#else
+   return cpus_.empty();
+#endif
+}
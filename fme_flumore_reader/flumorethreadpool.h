@@ -0,0 +1,153 @@
+#ifndef FLUMORE_THREAD_POOL_H
+#define FLUMORE_THREAD_POOL_H
+/*=============================================================================
+
+   Name     : flumorethreadpool.h
+
+   System   : FME Plug-in SDK
+
+   Language : C++
+
+   Purpose  : Declaration of FLUMOREThreadPool
+
+=============================================================================*/
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// FLUMOREThreadPool
+//
+// Worker threads running the submitted tasks. Every thread submitting
+// tasks, i.e. every reader and writer, has a queue of its own and the
+// workers take the next task from the queues in turn, so one instance
+// with many tasks does not hold up another. Tasks submitted by a task
+// go to the queue of the thread which submitted that one. The tasks
+// report their results themselves, the pool only runs them. The
+// destructor finishes the queued tasks before the threads are joined.
+//
+// All parallel work of the plug-in runs on the one shared() pool of the
+// process, so several readers and writers don't start a thread per core
+// each. Its size is set with configureShared() or the environment
+// variables FLUMORE_THREADS and FLUMORE_CPU_SET.
+class FLUMOREThreadPool
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   // Starts threads workers, all cpus if it is 0, pinned to cpus unless
+   // that is empty.
+   explicit FLUMOREThreadPool(size_t threads, const vector<size_t>& cpus = vector<size_t>());
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   ~FLUMOREThreadPool();
+
+   // -----------------------------------------------------------------------
+   // submit()
+   // Queues task to run on one of the workers.
+   void submit(const function<void()>& task);
+
+   // -----------------------------------------------------------------------
+   // resize()
+   // Runs the tasks on threads workers from now on, all cpus if it is 0,
+   // pinned to cpus unless that is empty. Surplus workers finish their
+   // task and wait until the pool grows again. Returns false if the
+   // workers could not be pinned, they run on all cpus then.
+   bool resize(size_t threads, const vector<size_t>& cpus = vector<size_t>());
+
+   // -----------------------------------------------------------------------
+   // Accessors
+   size_t threads() const;
+
+   // -----------------------------------------------------------------------
+   // shared()
+   // The pool of the process, started at the first call.
+   static FLUMOREThreadPool& shared();
+
+   // -----------------------------------------------------------------------
+   // configureShared()
+   // Sets the size of the shared pool: threads workers pinned to the cpus
+   // of cpuSet, e.g. "0-3,8". An empty cpuSet or 0 threads take the
+   // environment variables FLUMORE_CPU_SET and FLUMORE_THREADS instead,
+   // without them the pool runs on all cpus of the set, all hardware
+   // threads without a set. Returns false and the reason in error if the
+   // set can't be used; the pool is resized anyway.
+   static bool configureShared(size_t threads, const string& cpuSet, string& error);
+
+   // -----------------------------------------------------------------------
+   // defaultThreads()
+   // The number of workers of the shared pool, at least 1.
+   static size_t defaultThreads();
+
+   // -----------------------------------------------------------------------
+   // hardwareThreads()
+   // The number of hardware threads, at least 1.
+   static size_t hardwareThreads();
+
+   // -----------------------------------------------------------------------
+   // parseCpuSet()
+   // Reads a list of cpu numbers and ranges such as "0-3,8" into cpus.
+   static bool parseCpuSet(const string& text, vector<size_t>& cpus);
+
+   // -----------------------------------------------------------------------
+   // forEach()
+   // Runs task for 0 to count - 1 on up to threads threads, the calling
+   // one and workers of the shared pool. Waits for the workers, the
+   // calling thread takes on the indices no worker got to. Stops early
+   // and returns false as soon as a task fails.
+   static bool forEach(size_t count, size_t threads, const function<bool(size_t)>& task);
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   FLUMOREThreadPool(const FLUMOREThreadPool&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   FLUMOREThreadPool &operator=(const FLUMOREThreadPool&);
+
+   // -----------------------------------------------------------------------
+   // work()
+   // The loop of worker index.
+   void work(size_t index);
+
+   // -----------------------------------------------------------------------
+   // pin()
+   // Restricts the workers to cpus_, to all cpus if it is empty. lock_
+   // has to be held.
+   bool pin();
+
+   // Data members
+
+   vector<thread> workers_;
+
+   // The queued tasks of every submitting thread, by the number of the
+   // thread, guarded by lock_ like the rest. The next task is taken from
+   // the queue of thread next_ or the one after. wakeUp_ is signalled
+   // when a task is queued, the pool is resized or stops.
+   map<size_t, deque<function<void()> > > tasks_;
+   size_t next_;
+   mutable mutex lock_;
+   condition_variable wakeUp_;
+
+   // The number of workers taking tasks, the first active_ of workers_,
+   // and the cpus they run on.
+   size_t active_;
+   vector<size_t> cpus_;
+   bool stopping_;
+};
+
+#endif
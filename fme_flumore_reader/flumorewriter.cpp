@@ -35,16 +35,24 @@
 
 // Include Files
 #include "flumorewriter.h"
+#include "flumoreformat.h"
 #include "flumorepriv.h"
-#include "geometryvisitor.h"
 
 #include <ifeature.h>
-#include <igeometry.h>
 #include <igeometrytools.h>
 #include <ilogfile.h>
 #include <isession.h>
+#include <fmemap.h>
 #include <fmestring.h>
-#include <ImportSimulationData.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 // These are initialized externally when a writer object is created so all
 // methods in this file can assume they are ready to use.
@@ -53,6 +61,37 @@ IFMEMappingFile* FLUMOREWriter::gMappingFile = NULL;
 IFMECoordSysManager* FLUMOREWriter::gCoordSysMan = NULL;
 extern IFMESession* gFMESession;
 
+namespace
+{
+   // The number of rejected features which are logged individually.
+   const FME_UInt64 kMaxRejectedLogged = 10;
+
+   //------------------------------------------------------------------------
+   // Creates the dataset folder, an existing folder is fine.
+   void createFolder(const string& path)
+   {
+#ifdef WIN32
+      _mkdir(path.c_str());
+#else
+      mkdir(path.c_str(), 0777);
+#endif
+   }
+
+   //------------------------------------------------------------------------
+   // Parses a whole string as integer.
+   bool parseInteger(const string& text, FME_Int32& value)
+   {
+      char* end = NULL;
+      const long parsed = strtol(text.c_str(), &end, 10);
+      if (text.empty() || *end != '\0')
+      {
+         return false;
+      }
+      value = FME_Int32(parsed);
+      return true;
+   }
+}
+
 //===========================================================================
 // Constructor
 FLUMOREWriter::FLUMOREWriter(const char* writerTypeName, const char* writerKeyword)
@@ -61,8 +100,15 @@ FLUMOREWriter::FLUMOREWriter(const char* writerTypeName, const char* writerKeywo
    writerKeyword_(writerKeyword),
    dataset_(""),
    fmeGeometryTools_(NULL),
-   visitor_(NULL),
-   schemaFeature_(NULL)
+   schemaFeature_(NULL),
+   attrValue_(NULL),
+   lastDate_(""),
+   created_(""),
+   variant_(kDefaultVariant),
+   counter_(kDefaultCounter),
+   timeZone_(),
+   rejected_(0),
+   open_(FME_FALSE)
 {
 }
 
@@ -82,43 +128,39 @@ FME_Status FLUMOREWriter::open(const char* datasetName, const IFMEStringArray& p
    // Get geometry tools
    fmeGeometryTools_ = gFMESession->getGeometryTools();
 
-   // Set the session on FMEString[Array]s.  The session set here was retrieved
+   // Set the session on FMEStrings.  The session set here was retrieved
    // when this plug-in was loaded.  Consequently, subsequent calls to this
    // method will use the same session, so we can make multiple calls to
    // setSession without worrying.
    FMEString::setSession(gFMESession);
-   FMEStringArray::setSession(gFMESession);
-
-   Parser r;
-   // Create visitor to visit feature geometries
-   visitor_ = new GeometryVisitor(fmeGeometryTools_, gFMESession);
 
    dataset_ = datasetName;
 
    schemaFeature_ = gFMESession->createFeature();
+   attrValue_ = gFMESession->createString();
 
-   // -----------------------------------------------------------------------
-   // Add additional setup here
-   // -----------------------------------------------------------------------
+   fileWriter_.clear();
+   lastDate_.clear();
+   rejected_ = 0;
+   open_ = FME_TRUE;
 
    // Log an opening writer message
    string msgOpeningWriter = kMsgOpeningWriter + dataset_;
    gLogFile->logMessageString(msgOpeningWriter.c_str());
 
    // Fetch all the schema features and add the DEF lines.
-   FLUMOREWriter::addDefLineToSchema(parameters);
-   
+   if (parameters.entries() > 0)
+   {
+      FLUMOREWriter::addDefLineToSchema(parameters);
+   }
 
-   // Write the schema information to the file. In this template,
-   // since we are not writing to a file we will log the schema information
-   // instead.
-   //gLogFile->logFeature(*schemaFeature_, FME_INFORM, 20);
+   readParametersDialog();
 
-   // -----------------------------------------------------------------------
-   // Open the dataset here
-   // e.g. outputFile_.open(dataset_.c_str(), ios::out|ios::trunc);
-   // -----------------------------------------------------------------------
+   // The folder also receives the spill file if FME_TEMP is not set.
+   createFolder(dataset_);
 
+   // The file itself is written at close(), when the number of rows of
+   // every block is known.
    return FME_SUCCESS;
 }
 
@@ -126,11 +168,9 @@ FME_Status FLUMOREWriter::open(const char* datasetName, const IFMEStringArray& p
 // Abort
 FME_Status FLUMOREWriter::abort()
 {
-   // -----------------------------------------------------------------------
-   // Add any special actions to shut down a writer not finished writing
-   // data. For example, if your format requires a footer at the end of a
-   // file, write it here.
-   // -----------------------------------------------------------------------
+   // The rows collected so far are dropped, no incomplete file is written.
+   fileWriter_.clear();
+   open_ = FME_FALSE;
 
    close();
    return FME_SUCCESS;
@@ -140,16 +180,22 @@ FME_Status FLUMOREWriter::abort()
 // Close
 FME_Status FLUMOREWriter::close()
 {
-   // -----------------------------------------------------------------------
-   // Perform any closing operations / cleanup here; e.g. close opened files
-   // -----------------------------------------------------------------------
+   FME_Status status = FME_SUCCESS;
+   if (open_)
+   {
+      open_ = FME_FALSE;
+      status = writeFile();
+
+      // Log that the writer is done
+      gLogFile->logMessageString((kMsgClosingWriter + dataset_).c_str());
+   }
+   fileWriter_.clear();
 
-   // Delete the visitor
-   if (visitor_)
+   if (attrValue_)
    {
-      delete visitor_;
+      gFMESession->destroyString(attrValue_);
+      attrValue_ = NULL;
    }
-   visitor_ = NULL;
 
    if (schemaFeature_)
    {
@@ -157,41 +203,294 @@ FME_Status FLUMOREWriter::close()
       schemaFeature_ = NULL;
    }
 
-   // Log that the writer is done
-   gLogFile->logMessageString((kMsgClosingWriter + dataset_).c_str());
-
-   return FME_SUCCESS;
+   return status;
 }
 
 //===========================================================================
 // Write
 FME_Status FLUMOREWriter::write(const IFMEFeature& feature)
 {
-   // Log the feature
-   // gLogFile->logFeature(feature);
+   const char* problem = selectBlock(feature);
+   if (problem != NULL)
+   {
+      reject(problem);
+      return FME_SUCCESS;
+   }
 
-   // -----------------------------------------------------------------------
-   // The feature type and the attributes can be extracted from the feature
-   // at this point.
-   // -----------------------------------------------------------------------
+   FME_Int32 id = 0;
+   FME_Real64 values[6];
+   if (!feature.getAttribute(kAttrId, id) ||
+       !feature.getAttribute(kAttrX, values[0]) ||
+       !feature.getAttribute(kAttrY, values[1]) ||
+       !feature.getAttribute(kAttrZ, values[2]) ||
+       !feature.getAttribute(kAttrWsp, values[3]) ||
+       !feature.getAttribute(kAttrH, values[4]) ||
+       !feature.getAttribute(kAttrVres, values[5]))
+   {
+      reject("one of id, x, y, z, wsp, h and vres is missing");
+      return FME_SUCCESS;
+   }
+   if (!fileWriter_.addRow(id, values))
+   {
+      if (fileWriter_.failed())
+      {
+         gLogFile->logMessageString((string(kMsgWriteError) + ": " + fileWriter_.error()).c_str(), FME_ERROR);
+         return FME_FAILURE;
+      }
+      reject(fileWriter_.error().c_str());
+   }
+   return FME_SUCCESS;
+}
 
-   // Extract the geometry from the feature
-   const IFMEGeometry* geometry = (const_cast<IFMEFeature&>(feature)).getGeometry();
-   FME_Status badNews = geometry->acceptGeometryVisitorConst(*visitor_);
-   if (badNews)
+//===========================================================================
+// Select Block
+const char* FLUMOREWriter::selectBlock(const IFMEFeature& feature)
+{
+   if (!feature.getAttribute(kAttrDate, *attrValue_))
    {
-      // There was an error in writing the geometry
-      gLogFile->logMessageString(kMsgWriteError);
-      return FME_FAILURE;
+      return "the date is missing";
+   }
+   if (lastDate_ != attrValue_->data())
+   {
+      FLUMORETimestamp timestamp;
+      if (!FLUMOREFormat::flumoreDate(attrValue_->data(), timestamp.date, timestamp.fmeDate, timeZone_))
+      {
+         return "the date is neither yyyyMMddHHmmss nor dd.MM.yyyy-HH:mm";
+      }
+      lastDate_ = attrValue_->data();
+      timestamp_.date = timestamp.date;
+      timestamp_.fmeDate = timestamp.fmeDate;
+   }
+
+   timestamp_.kind = kFLUMORETimestampSimulation;
+   if (feature.getAttribute(kAttrTimestampKind, *attrValue_))
+   {
+      const char* kind = attrValue_->data();
+      if (strcmp(kind, "VHS") == 0)
+      {
+         timestamp_.kind = kFLUMORETimestampPrediction;
+      }
+      else if (strcmp(kind, "SZO") == 0)
+      {
+         timestamp_.kind = kFLUMORETimestampScenario;
+      }
+      else if (strcmp(kind, "SIM") != 0)
+      {
+         return "the timestamp kind is not one of SIM, VHS and SZO";
+      }
+   }
+
+   FLUMORESituation situation;
+   const bool hasSituation = feature.getAttribute(kAttrSituationKind, *attrValue_) == FME_TRUE;
+   if (hasSituation)
+   {
+      static const char* const kKinds[] =
+      {
+         "Ueberstr.", "Bresche", "Deichentl.", "Folgebruch", "Innere Entl.", "Linien-SM", "Punkt-SM"
+      };
+      static const int32_t kValueCounts[] = { 2, 3, 3, 3, 3, 1, 1 };
+
+      int32_t k = 0;
+      for (; k < 7 && strcmp(attrValue_->data(), kKinds[k]) != 0; ++k)
+      {
+      }
+      if (k == 7)
+      {
+         return "the situation kind is unknown";
+      }
+      situation.kind = FLUMORESituationKind(k);
+      situation.valueCount = kValueCounts[k];
+
+      FME_Int32 nlp = 0;
+      if (!feature.getAttribute(kAttrSituationNlp, nlp))
+      {
+         return "the situation has no nlp";
+      }
+      situation.nlp = nlp;
+      situation.hasLocation = (nlp == 1);
+      situation.rw = 0.0;
+      situation.hw = 0.0;
+      if (situation.hasLocation)
+      {
+         feature.getAttribute(kAttrSituationRw, situation.rw);
+         feature.getAttribute(kAttrSituationHw, situation.hw);
+      }
+
+      const char* const valueNames[] = { kAttrSituationValue1, kAttrSituationValue2, kAttrSituationValue3 };
+      for (int32_t i = 0; i < 3; ++i)
+      {
+         situation.values[i] = 0.0;
+         if (i < situation.valueCount && !feature.getAttribute(valueNames[i], situation.values[i]))
+         {
+            return "a value of the situation is missing";
+         }
+      }
+   }
+
+   FME_Int32 teilbereich = 1;
+   FME_Int32 version = 1;
+   feature.getAttribute(kAttrTeilbereich, teilbereich);
+   feature.getAttribute(kAttrTeilbereichVersion, version);
+
+   if (!fileWriter_.selectBlock(timestamp_, hasSituation ? &situation : NULL, teilbereich, version))
+   {
+      return fileWriter_.error().c_str();
+   }
+   return NULL;
+}
+
+//===========================================================================
+// Reject
+void FLUMOREWriter::reject(const char* reason)
+{
+   if (++rejected_ <= kMaxRejectedLogged)
+   {
+      gLogFile->logMessageString((string(kMsgFeatureRejected) + reason).c_str(), FME_WARN);
+   }
+}
+
+//===========================================================================
+// Write File
+FME_Status FLUMOREWriter::writeFile()
+{
+   if (rejected_ > 0)
+   {
+      ostringstream msg;
+      msg << kMsgFeaturesRejected << rejected_;
+      gLogFile->logMessageString(msg.str().c_str(), FME_WARN);
    }
 
-   // -----------------------------------------------------------------------
-   // Perform your write operations here
-   // -----------------------------------------------------------------------
+   const FLUMORETimestamp* earliest = fileWriter_.earliest();
+   if (earliest == NULL)
+   {
+      gLogFile->logMessageString((kMsgNothingWritten + dataset_).c_str(), FME_WARN);
+      return FME_SUCCESS;
+   }
+
+   FLUMOREPackageHeader header;
+   header.created = created_.empty() ? earliest->date : created_;
+   header.timesteps = FME_Int32(fileWriter_.timestamps());
+   header.variant = variant_;
+   header.counter = counter_;
+
+   // [VS]-yyyy-MM-dd-HH.Nnnn-Pnnn.txt as expected by the reader, V if the
+   // file holds a forecast.
+   const string& created = header.created;
+   string name = fileWriter_.hasKind(kFLUMORETimestampPrediction) ? "V-" : "S-";
+   name += created.substr(6, 4) + "-" + created.substr(3, 2) + "-" + created.substr(0, 2) + "-" +
+           created.substr(11, 2) + ".N";
+   char digits[8];
+   name.append(digits, FLUMOREFormat::appendDigits(digits, variant_, 3));
+   name += "-P";
+   name.append(digits, FLUMOREFormat::appendDigits(digits, counter_, 3));
+   name += ".txt";
+
+   createFolder(dataset_);
+   const string path = dataset_ + "/" + name;
+   if (!fileWriter_.write(path, header))
+   {
+      gLogFile->logMessageString((string(kMsgWriteError) + ": " + fileWriter_.error()).c_str(), FME_ERROR);
+      return FME_FAILURE;
+   }
 
+   ostringstream msg;
+   msg << kMsgWroteFile << path << ": " << fileWriter_.timestamps() << " timesteps, "
+       << fileWriter_.blocks() << " blocks, " << fileWriter_.rows() << " rows, "
+       << fileWriter_.bytesWritten() << " bytes, " << fileWriter_.threads() << " threads";
+   if (fileWriter_.bytesSpilled() > 0)
+   {
+      msg << ", " << fileWriter_.bytesSpilled() << " bytes spilled";
+   }
+   gLogFile->logMessageString(msg.str().c_str());
    return FME_SUCCESS;
 }
 
+//===========================================================================
+// readParametersDialog
+void FLUMOREWriter::readParametersDialog()
+{
+   created_.clear();
+   variant_ = kDefaultVariant;
+   counter_ = kDefaultCounter;
+   timeZone_ = FLUMORETimeZone();
+
+   string timeZone;
+   if (fetchParameter(kDestTimeZoneTag, timeZone) && !timeZone.empty() &&
+       !FLUMOREFormat::parseTimeZone(timeZone, timeZone_))
+   {
+      gLogFile->logMessageString((kMsgBadWriterParameter + timeZone).c_str(), FME_WARN);
+      timeZone_ = FLUMORETimeZone();
+   }
+
+   string created;
+   if (fetchParameter(kDestCreatedTag, created) && !created.empty())
+   {
+      string date, fmeDate;
+      if (FLUMOREFormat::flumoreDate(created, date, fmeDate, timeZone_) && date == created)
+      {
+         created_ = created;
+      }
+      else
+      {
+         gLogFile->logMessageString((kMsgBadWriterParameter + created).c_str(), FME_WARN);
+      }
+   }
+
+   FME_Int32* const numbers[] = { &variant_, &counter_ };
+   const char* const tags[] = { kDestVariantTag, kDestCounterTag };
+   for (int i = 0; i < 2; ++i)
+   {
+      string text;
+      FME_Int32 value = 0;
+      if (!fetchParameter(tags[i], text) || text.empty())
+      {
+         continue;
+      }
+      if (parseInteger(text, value) && value >= 0 && value <= 999)
+      {
+         *numbers[i] = value;
+      }
+      else
+      {
+         gLogFile->logMessageString((kMsgBadWriterParameter + text).c_str(), FME_WARN);
+      }
+   }
+
+   FME_Int32 memoryLimit = kDefaultMemoryLimit;
+   string text;
+   if (fetchParameter(kDestMemoryLimitTag, text) && !text.empty() &&
+       (!parseInteger(text, memoryLimit) || memoryLimit < 0))
+   {
+      gLogFile->logMessageString((kMsgBadWriterParameter + text).c_str(), FME_WARN);
+      memoryLimit = kDefaultMemoryLimit;
+   }
+   FME_Int32 threads = kDefaultWriterThreads;
+   if (fetchParameter(kDestThreadsTag, text) && !text.empty() &&
+       (!parseInteger(text, threads) || threads < 0))
+   {
+      gLogFile->logMessageString((kMsgBadWriterParameter + text).c_str(), FME_WARN);
+      threads = kDefaultWriterThreads;
+   }
+   fileWriter_.setThreads(size_t(threads));
+
+   const char* temp = getenv("FME_TEMP");
+   fileWriter_.setMemoryLimit(uint64_t(memoryLimit) << 20,
+                              (temp != NULL && *temp != '\0') ? string(temp) : dataset_);
+}
+
+//===========================================================================
+// fetchParameter
+FME_Boolean FLUMOREWriter::fetchParameter(const char* tag, string& value) const
+{
+   FMEString paramValue;
+   if (gMappingFile->fetchWithPrefix(writerKeyword_.c_str(), writerTypeName_.c_str(), tag, *paramValue))
+   {
+      value = paramValue->data();
+      return FME_TRUE;
+   }
+   return FME_FALSE;
+}
+
 //===========================================================================
 // Add DEF Line to the Schema Feature
 void FLUMOREWriter::addDefLineToSchema(const IFMEStringArray& parameters)
@@ -38,6 +38,7 @@
 #include <fmewrt.h>
 #include <sstream>
 #include <string>
+#include "flumorefilewriter.h"
 
 using namespace std;
 
@@ -45,7 +46,7 @@ using namespace std;
 class IFMEFeature;
 class IFMELogFile;
 class IFMEGeometryTools;
-class GeometryVisitor;
+class IFMEString;
 
 // The writer ID assigned by Safe Software for this module
 const FME_UInt32 kWriterId = 87062;
@@ -141,6 +142,40 @@ private:
    // Adding a DEF line to the schema
    void addDefLineToSchema(const IFMEStringArray& parameters);
 
+   //---------------------------------------------------------------
+   // readParametersDialog
+   //
+   // Reads the creation date, variant and counter of the file and the
+   // memory limit and threads of fileWriter_ from the mapping file.
+   void readParametersDialog();
+
+   //---------------------------------------------------------------
+   // fetchParameter
+   //
+   // Looks up a writer parameter from the mapping file using the writer
+   // keyword and type name as prefix. Returns FME_FALSE if it isn't set.
+   FME_Boolean fetchParameter(const char* tag, string& value) const;
+
+   //---------------------------------------------------------------
+   // selectBlock
+   //
+   // Selects the timestamp, situation and Teilbereich block of the
+   // feature in fileWriter_. Returns a description of the problem if the
+   // feature doesn't say where it belongs, NULL otherwise.
+   const char* selectBlock(const IFMEFeature& feature);
+
+   //---------------------------------------------------------------
+   // reject
+   //
+   // Counts a feature which could not be written and logs the first ones.
+   void reject(const char* reason);
+
+   //---------------------------------------------------------------
+   // writeFile
+   //
+   // Writes the collected rows to the dataset folder.
+   FME_Status writeFile();
+
    // -----------------------------------------------------------------------
    // Insert additional private methods here
    // -----------------------------------------------------------------------
@@ -167,12 +202,35 @@ private:
    // manipulate geometries.
    IFMEGeometryTools* fmeGeometryTools_;
 
-   // Visitor variable.
-   GeometryVisitor* visitor_;
-
    // Represents the schema feature on advanced writing.
    IFMEFeature* schemaFeature_;
 
+   // Collects the rows until close() writes the file.
+   FLUMOREFileWriter fileWriter_;
+
+   // Receive string attributes of the written features.
+   IFMEString* attrValue_;
+
+   // The date attribute of the previous feature and the timestamp it was
+   // converted to, most features share it with their predecessor.
+   string lastDate_;
+   FLUMORETimestamp timestamp_;
+
+   // The package header values from the writer parameters. The creation
+   // date is taken from the earliest timestamp if it is empty.
+   string created_;
+   FME_Int32 variant_;
+   FME_Int32 counter_;
+
+   // The time zone the dates are written in.
+   FLUMORETimeZone timeZone_;
+
+   // The number of features which could not be written.
+   FME_UInt64 rejected_;
+
+   // Set between open() and the first close() or abort().
+   FME_Boolean open_;
+
    // -----------------------------------------------------------------------
    // Insert additional private data members here
    // -----------------------------------------------------------------------
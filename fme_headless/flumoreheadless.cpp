@@ -0,0 +1,237 @@
+/*=============================================================================
+
+   Name     : flumoreheadless.cpp
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : flumore_headless, runs FLUMOREReader and optionally
+              FLUMOREWriter outside of FME and reports the throughput
+
+=============================================================================*/
+
+// Include Files
+#include "headlessfeature.h"
+#include "headlesslogfile.h"
+#include "headlessmappingfile.h"
+#include "headlesssession.h"
+#include "headlessstring.h"
+
+#include <flumorepriv.h>
+#include <flumorereader.h>
+#include <flumorewriter.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Defined by the reader, set by FME_acceptSession() in the plug-in.
+extern IFMESession* gFMESession;
+
+namespace
+{
+   typedef std::chrono::steady_clock Clock;
+
+   //------------------------------------------------------------------------
+   // Command line options.
+   struct Options
+   {
+      Options() : keyword("FLUMORE"), repeat(1), quiet(false) {}
+
+      string dataset;
+      string keyword;
+      // If set the features read are passed to FLUMOREWriter writing into
+      // this folder.
+      string destination;
+      // Reader parameters as NAME=VALUE, e.g. SOURCE_LOG_LEVEL=FULL.
+      vector<string> parameters;
+      int32_t repeat;
+      bool quiet;
+   };
+
+   //------------------------------------------------------------------------
+   void usage()
+   {
+      cerr << "usage: flumore_headless [options] <dataset>\n"
+              "\n"
+              "Opens the dataset with FLUMOREReader, reads all features and reports\n"
+              "the throughput, without FME or Mono. Parameters apply to the reader and\n"
+              "the writer, e.g. -p DEST_VARIANT=2.\n"
+              "\n"
+              "  -p <NAME=VALUE>  reader parameter, e.g. -p SOURCE_LOG_LEVEL=FULL\n"
+              "  --keyword <kw>   reader keyword and type name (FLUMORE)\n"
+              "  --repeat <n>     open, read and close the dataset n times (1)\n"
+              "  --write <folder> write the features with FLUMOREWriter into folder\n"
+              "  --quiet          do not print the reader log\n";
+   }
+
+   //------------------------------------------------------------------------
+   bool parseArguments(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         const string arg(argv[i]);
+         if (arg == "-p" && i + 1 < argc)
+         {
+            options.parameters.push_back(argv[++i]);
+         }
+         else if (arg == "--keyword" && i + 1 < argc)
+         {
+            options.keyword = argv[++i];
+         }
+         else if (arg == "--repeat" && i + 1 < argc)
+         {
+            options.repeat = atoi(argv[++i]);
+            if (options.repeat < 1)
+            {
+               return false;
+            }
+         }
+         else if (arg == "--write" && i + 1 < argc)
+         {
+            options.destination = argv[++i];
+         }
+         else if (arg == "--quiet")
+         {
+            options.quiet = true;
+         }
+         else if (!arg.empty() && arg[0] != '-' && options.dataset.empty())
+         {
+            options.dataset = arg;
+         }
+         else
+         {
+            return false;
+         }
+      }
+      return !options.dataset.empty();
+   }
+}
+
+//===========================================================================
+// Main
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!parseArguments(argc, argv, options))
+   {
+      usage();
+      return 2;
+   }
+
+   HeadlessSession session;
+   HeadlessLogFile logFile(options.quiet ? NULL : stderr);
+   HeadlessMappingFile mappingFile;
+   for (size_t i = 0; i < options.parameters.size(); ++i)
+   {
+      const string& parameter = options.parameters[i];
+      const size_t equals = parameter.find('=');
+      if (equals == string::npos)
+      {
+         usage();
+         return 2;
+      }
+      mappingFile.set(options.keyword + "_" + parameter.substr(0, equals), parameter.substr(equals + 1));
+   }
+
+   gFMESession = &session;
+   FLUMOREReader::gLogFile = &logFile;
+   FLUMOREReader::gMappingFile = &mappingFile;
+   FLUMOREWriter::gLogFile = &logFile;
+   FLUMOREWriter::gMappingFile = &mappingFile;
+
+   ifstream input(options.dataset.c_str(), ios::in | ios::binary | ios::ate);
+   const double bytes = input ? double(input.tellg()) : 0.0;
+   input.close();
+
+   IFMEFeature* feature = session.createFeature();
+   HeadlessStringArray parameters;
+   HeadlessStringArray writerParameters;
+   writerParameters.append(kFeatureTypeFLUMORE);
+   double bestSeconds = 0.0;
+   FME_UInt64 features = 0;
+   int status = 0;
+
+   for (int32_t run = 0; run < options.repeat && status == 0; ++run)
+   {
+      FLUMOREReader reader(options.keyword.c_str(), options.keyword.c_str());
+      const Clock::time_point start = Clock::now();
+
+      if (reader.open(options.dataset.c_str(), parameters) != FME_SUCCESS)
+      {
+         cerr << "flumore_headless: could not open " << options.dataset << "\n";
+         status = 1;
+         break;
+      }
+
+      FLUMOREWriter writer(options.keyword.c_str(), options.keyword.c_str());
+      const bool writing = !options.destination.empty();
+      if (writing && writer.open(options.destination.c_str(), writerParameters) != FME_SUCCESS)
+      {
+         cerr << "flumore_headless: could not open " << options.destination << "\n";
+         status = 1;
+         break;
+      }
+
+      features = 0;
+      FME_Boolean endOfFile = FME_FALSE;
+      for (;;)
+      {
+         feature->resetFeature();
+         if (reader.read(*feature, endOfFile) != FME_SUCCESS)
+         {
+            cerr << "flumore_headless: read failed after " << features << " features\n";
+            status = 1;
+            break;
+         }
+         if (endOfFile)
+         {
+            break;
+         }
+         if (writing && writer.write(*feature) != FME_SUCCESS)
+         {
+            cerr << "flumore_headless: write failed after " << features << " features\n";
+            status = 1;
+            break;
+         }
+         ++features;
+      }
+      reader.close();
+      if (writing && writer.close() != FME_SUCCESS)
+      {
+         cerr << "flumore_headless: could not write into " << options.destination << "\n";
+         status = 1;
+      }
+
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (run == 0 || seconds < bestSeconds)
+      {
+         bestSeconds = seconds;
+      }
+   }
+   session.destroyFeature(feature);
+
+   if (status == 0)
+   {
+      char line[256];
+      snprintf(line, sizeof(line),
+               "%s: %llu features in %.4f s (best of %d), %.0f features/s, %.1f MB/s, "
+               "%llu warnings, peak memory %llu bytes\n",
+               options.dataset.c_str(), (unsigned long long)features, bestSeconds, options.repeat,
+               bestSeconds > 0.0 ? double(features) / bestSeconds : 0.0,
+               bestSeconds > 0.0 ? bytes / bestSeconds / 1e6 : 0.0,
+               (unsigned long long)logFile.warnings(),
+               (unsigned long long)FLUMOREStats::peakResidentBytes());
+      cout << line;
+   }
+   if (session.liveFeatures() != 0)
+   {
+      cerr << "flumore_headless: " << session.liveFeatures() << " features were not destroyed\n";
+      status = 1;
+   }
+   return status;
+}
@@ -0,0 +1,270 @@
+/*=============================================================================
+
+   Name     : headlessfeature.cpp
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : HeadlessFeature method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "headlessfeature.h"
+
+#include <fmestring.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+//===========================================================================
+// Constructor
+HeadlessFeature::HeadlessFeature()
+:
+   count_(0)
+{
+}
+
+//===========================================================================
+// Destructor
+HeadlessFeature::~HeadlessFeature()
+{
+}
+
+//===========================================================================
+// Set Feature Type
+void HeadlessFeature::setFeatureType(const char* featureType)
+{
+   featureType_ = featureType;
+}
+
+//===========================================================================
+// Get Feature Type
+const char* HeadlessFeature::getFeatureType() const
+{
+   return featureType_.c_str();
+}
+
+//===========================================================================
+// Set Coord Sys
+void HeadlessFeature::setCoordSys(const char* coordSys)
+{
+   coordSys_ = coordSys ? coordSys : "";
+}
+
+//===========================================================================
+// Get Coord Sys
+const char* HeadlessFeature::getCoordSys() const
+{
+   return coordSys_.c_str();
+}
+
+//===========================================================================
+// Set Attribute
+void HeadlessFeature::setAttribute(const char* attrName, const char* attrValue)
+{
+   Attribute& attribute = slot(attrName);
+   attribute.type = Attribute::kString;
+   attribute.stringValue = attrValue;
+}
+
+//===========================================================================
+// Set Attribute
+void HeadlessFeature::setAttribute(const char* attrName, FME_Int32 attrValue)
+{
+   Attribute& attribute = slot(attrName);
+   attribute.type = Attribute::kInt32;
+   attribute.int32Value = attrValue;
+}
+
+//===========================================================================
+// Set Attribute
+void HeadlessFeature::setAttribute(const char* attrName, FME_Real64 attrValue)
+{
+   Attribute& attribute = slot(attrName);
+   attribute.type = Attribute::kReal64;
+   attribute.real64Value = attrValue;
+}
+
+//===========================================================================
+// Set Sequenced Attribute
+void HeadlessFeature::setSequencedAttribute(const char* attrName, const char* attrValue)
+{
+   // Attributes are always kept in order.
+   setAttribute(attrName, attrValue);
+}
+
+//===========================================================================
+// Get Attribute
+FME_Boolean HeadlessFeature::getAttribute(const char* attrName, FME_Int32& attrValue) const
+{
+   const Attribute* attribute = find(attrName);
+   if (attribute == NULL)
+   {
+      return FME_FALSE;
+   }
+   switch (attribute->type)
+   {
+   case Attribute::kInt32:  attrValue = attribute->int32Value; break;
+   case Attribute::kReal64: attrValue = FME_Int32(attribute->real64Value); break;
+   default:                 attrValue = FME_Int32(atol(attribute->stringValue.c_str()));
+   }
+   return FME_TRUE;
+}
+
+//===========================================================================
+// Get Attribute
+FME_Boolean HeadlessFeature::getAttribute(const char* attrName, FME_Real64& attrValue) const
+{
+   const Attribute* attribute = find(attrName);
+   if (attribute == NULL)
+   {
+      return FME_FALSE;
+   }
+   switch (attribute->type)
+   {
+   case Attribute::kInt32:  attrValue = attribute->int32Value; break;
+   case Attribute::kReal64: attrValue = attribute->real64Value; break;
+   default:                 attrValue = atof(attribute->stringValue.c_str());
+   }
+   return FME_TRUE;
+}
+
+//===========================================================================
+// Get Attribute
+FME_Boolean HeadlessFeature::getAttribute(const char* attrName, IFMEString& attrValue) const
+{
+   const Attribute* attribute = find(attrName);
+   if (attribute == NULL)
+   {
+      return FME_FALSE;
+   }
+   if (attribute->type == Attribute::kString)
+   {
+      attrValue.set(attribute->stringValue.c_str(), FME_UInt32(attribute->stringValue.size()));
+      return FME_TRUE;
+   }
+   ostringstream value;
+   value.precision(17);
+   if (attribute->type == Attribute::kInt32)
+   {
+      value << attribute->int32Value;
+   }
+   else
+   {
+      value << attribute->real64Value;
+   }
+   const string text = value.str();
+   attrValue.set(text.c_str(), FME_UInt32(text.size()));
+   return FME_TRUE;
+}
+
+//===========================================================================
+// Num Attributes
+FME_UInt32 HeadlessFeature::numAttributes() const
+{
+   return FME_UInt32(count_);
+}
+
+//===========================================================================
+// Clone
+void HeadlessFeature::clone(IFMEFeature& destFeature) const
+{
+   // The stand-in session only ever creates HeadlessFeatures.
+   HeadlessFeature& dest = static_cast<HeadlessFeature&>(destFeature);
+   if (&dest == this)
+   {
+      return;
+   }
+
+   dest.featureType_ = featureType_;
+   dest.coordSys_ = coordSys_;
+   if (dest.attributes_.size() < count_)
+   {
+      dest.attributes_.resize(count_);
+   }
+   for (size_t i = 0; i < count_; ++i)
+   {
+      const Attribute& source = attributes_[i];
+      Attribute& target = dest.attributes_[i];
+      target.name = source.name;
+      target.type = source.type;
+      target.int32Value = source.int32Value;
+      target.real64Value = source.real64Value;
+      if (source.type == Attribute::kString)
+      {
+         target.stringValue = source.stringValue;
+      }
+   }
+   dest.count_ = count_;
+}
+
+//===========================================================================
+// Reset Feature
+void HeadlessFeature::resetFeature()
+{
+   featureType_.clear();
+   coordSys_.clear();
+   count_ = 0;
+}
+
+//===========================================================================
+// To String
+string HeadlessFeature::toString() const
+{
+   ostringstream line;
+   line.precision(17);
+   line << "Feature Type: `" << featureType_ << "'";
+   if (!coordSys_.empty())
+   {
+      line << " Coordinate System: `" << coordSys_ << "'";
+   }
+   for (size_t i = 0; i < count_; ++i)
+   {
+      const Attribute& attribute = attributes_[i];
+      line << " " << attribute.name << "=";
+      switch (attribute.type)
+      {
+      case Attribute::kInt32:  line << attribute.int32Value; break;
+      case Attribute::kReal64: line << attribute.real64Value; break;
+      default:                 line << "`" << attribute.stringValue << "'";
+      }
+   }
+   return line.str();
+}
+
+//===========================================================================
+// Slot
+HeadlessFeature::Attribute& HeadlessFeature::slot(const char* attrName)
+{
+   for (size_t i = 0; i < count_; ++i)
+   {
+      if (strcmp(attributes_[i].name.c_str(), attrName) == 0)
+      {
+         return attributes_[i];
+      }
+   }
+   if (count_ == attributes_.size())
+   {
+      attributes_.resize(count_ + 1);
+   }
+   Attribute& attribute = attributes_[count_++];
+   attribute.name = attrName;
+   return attribute;
+}
+
+//===========================================================================
+// Find
+const HeadlessFeature::Attribute* HeadlessFeature::find(const char* attrName) const
+{
+   for (size_t i = 0; i < count_; ++i)
+   {
+      if (strcmp(attributes_[i].name.c_str(), attrName) == 0)
+      {
+         return &attributes_[i];
+      }
+   }
+   return NULL;
+}
@@ -0,0 +1,106 @@
+#ifndef HEADLESS_FEATURE_H
+#define HEADLESS_FEATURE_H
+/*=============================================================================
+
+   Name     : headlessfeature.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : Declaration of HeadlessFeature
+
+=============================================================================*/
+
+#include <ifeature.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// HeadlessFeature
+//
+// In-memory IFMEFeature. Attributes are kept in a small vector in the
+// order they were set. Slots and their strings are reused after
+// resetFeature() and clone(), so a feature which is filled over and over
+// again stops allocating once it has seen the largest attribute set.
+class HeadlessFeature : public IFMEFeature
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   HeadlessFeature();
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   virtual ~HeadlessFeature();
+
+   // -----------------------------------------------------------------------
+   // IFMEFeature
+   virtual void setFeatureType(const char* featureType);
+   virtual const char* getFeatureType() const;
+   virtual void setCoordSys(const char* coordSys);
+   virtual const char* getCoordSys() const;
+   virtual void setAttribute(const char* attrName, const char* attrValue = "");
+   virtual void setAttribute(const char* attrName, FME_Int32 attrValue);
+   virtual void setAttribute(const char* attrName, FME_Real64 attrValue);
+   virtual void setSequencedAttribute(const char* attrName, const char* attrValue);
+   virtual FME_Boolean getAttribute(const char* attrName, FME_Int32& attrValue) const;
+   virtual FME_Boolean getAttribute(const char* attrName, FME_Real64& attrValue) const;
+   virtual FME_Boolean getAttribute(const char* attrName, IFMEString& attrValue) const;
+   virtual FME_UInt32 numAttributes() const;
+   virtual void clone(IFMEFeature& destFeature) const;
+   virtual void resetFeature();
+
+   // -----------------------------------------------------------------------
+   // toString()
+   // One line with the feature type and all attributes, used for logging.
+   string toString() const;
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   HeadlessFeature(const HeadlessFeature&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   HeadlessFeature &operator=(const HeadlessFeature&);
+
+   //=====================================================================
+   // One attribute, only the member matching the type is valid.
+   struct Attribute
+   {
+      enum Type { kString, kInt32, kReal64 };
+      string name;
+      Type type;
+      FME_Int32 int32Value;
+      FME_Real64 real64Value;
+      string stringValue;
+   };
+
+   // -----------------------------------------------------------------------
+   // slot()
+   // Returns the attribute of that name, appending a new one if needed.
+   Attribute& slot(const char* attrName);
+
+   // -----------------------------------------------------------------------
+   // find()
+   // Returns the attribute of that name or NULL.
+   const Attribute* find(const char* attrName) const;
+
+   // Data members
+
+   string featureType_;
+   string coordSys_;
+
+   // The first count_ entries are the attributes, the rest are kept for
+   // reuse.
+   vector<Attribute> attributes_;
+   size_t count_;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/*=============================================================================
+
+   Name     : headlesslogfile.cpp
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : HeadlessLogFile method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "headlesslogfile.h"
+#include "headlessfeature.h"
+
+namespace
+{
+   //------------------------------------------------------------------------
+   const char* severityName(FME_MsgLevel severity)
+   {
+      switch (severity)
+      {
+      case FME_WARN:         return "WARN";
+      case FME_ERROR:        return "ERROR";
+      case FME_FATAL:        return "FATAL";
+      case FME_STATISTIC:    return "STATS";
+      case FME_STATUSREPORT: return "STATUS";
+      default:               return "INFORM";
+      }
+   }
+}
+
+//===========================================================================
+// Constructor
+HeadlessLogFile::HeadlessLogFile(FILE* out)
+:
+   out_(out),
+   messages_(0),
+   warnings_(0),
+   features_(0)
+{
+}
+
+//===========================================================================
+// Destructor
+HeadlessLogFile::~HeadlessLogFile()
+{
+   if (out_)
+   {
+      fflush(out_);
+   }
+}
+
+//===========================================================================
+// Log Message String
+void HeadlessLogFile::logMessageString(const char* message, FME_MsgLevel severity)
+{
+   ++messages_;
+   if (severity != FME_INFORM && severity != FME_STATISTIC && severity != FME_STATUSREPORT)
+   {
+      ++warnings_;
+   }
+   if (out_)
+   {
+      fprintf(out_, "%-6s|%s\n", severityName(severity), message);
+   }
+}
+
+//===========================================================================
+// Log Feature
+void HeadlessLogFile::logFeature(const IFMEFeature& feature, FME_MsgLevel severity,
+                                 FME_Int32 /*maxCoords*/)
+{
+   ++features_;
+   if (out_)
+   {
+      // The stand-in session only ever creates HeadlessFeatures.
+      const HeadlessFeature& headless = static_cast<const HeadlessFeature&>(feature);
+      fprintf(out_, "%-6s|%s\n", severityName(severity), headless.toString().c_str());
+   }
+}
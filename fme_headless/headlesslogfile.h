@@ -0,0 +1,68 @@
+#ifndef HEADLESS_LOGFILE_H
+#define HEADLESS_LOGFILE_H
+/*=============================================================================
+
+   Name     : headlesslogfile.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : Declaration of HeadlessLogFile
+
+=============================================================================*/
+
+#include <ilogfile.h>
+#include <cstdio>
+
+//=====================================================================
+// HeadlessLogFile
+//
+// Writes log messages to a stdio stream, prefixed with their severity
+// like the FME log does. Every message is counted, so a run can check
+// what the reader would have logged even with the output switched off.
+class HeadlessLogFile : public IFMELogFile
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   // Messages go to out, nothing is written if out is NULL.
+   explicit HeadlessLogFile(FILE* out);
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   virtual ~HeadlessLogFile();
+
+   // -----------------------------------------------------------------------
+   // IFMELogFile
+   virtual void logMessageString(const char* message, FME_MsgLevel severity = FME_INFORM);
+   virtual void logFeature(const IFMEFeature& feature, FME_MsgLevel severity = FME_INFORM,
+                           FME_Int32 maxCoords = -1);
+
+   // -----------------------------------------------------------------------
+   // Counters
+   FME_UInt64 messages() const { return messages_; }
+   FME_UInt64 warnings() const { return warnings_; }
+   FME_UInt64 features() const { return features_; }
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   HeadlessLogFile(const HeadlessLogFile&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   HeadlessLogFile &operator=(const HeadlessLogFile&);
+
+   // Data members
+
+   FILE* out_;
+   FME_UInt64 messages_;
+   FME_UInt64 warnings_;
+   FME_UInt64 features_;
+};
+
+#endif
@@ -0,0 +1,57 @@
+/*=============================================================================
+
+   Name     : headlessmappingfile.cpp
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : HeadlessMappingFile method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "headlessmappingfile.h"
+
+#include <fmestring.h>
+
+//===========================================================================
+// Constructor
+HeadlessMappingFile::HeadlessMappingFile()
+{
+}
+
+//===========================================================================
+// Destructor
+HeadlessMappingFile::~HeadlessMappingFile()
+{
+}
+
+//===========================================================================
+// Fetch With Prefix
+FME_Boolean HeadlessMappingFile::fetchWithPrefix(const char* prefix1, const char* prefix2,
+                                                 const char* keyword, IFMEString& value)
+{
+   const char* const prefixes[] = { prefix1, prefix2 };
+   for (int i = 0; i < 2; ++i)
+   {
+      if (prefixes[i] == NULL)
+      {
+         continue;
+      }
+      map<string, string>::const_iterator it = values_.find(string(prefixes[i]) + keyword);
+      if (it != values_.end())
+      {
+         value.set(it->second.c_str(), FME_UInt32(it->second.size()));
+         return FME_TRUE;
+      }
+   }
+   return FME_FALSE;
+}
+
+//===========================================================================
+// Set
+void HeadlessMappingFile::set(const string& keyword, const string& value)
+{
+   values_[keyword] = value;
+}
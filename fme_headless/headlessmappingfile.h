@@ -0,0 +1,63 @@
+#ifndef HEADLESS_MAPPINGFILE_H
+#define HEADLESS_MAPPINGFILE_H
+/*=============================================================================
+
+   Name     : headlessmappingfile.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : Declaration of HeadlessMappingFile
+
+=============================================================================*/
+
+#include <fmemap.h>
+#include <map>
+#include <string>
+
+using namespace std;
+
+//=====================================================================
+// HeadlessMappingFile
+//
+// The mapping file is a plain map from keyword to value, e.g.
+// FLUMORE_SOURCE_LOG_LEVEL to FULL.
+class HeadlessMappingFile : public IFMEMappingFile
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   HeadlessMappingFile();
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   virtual ~HeadlessMappingFile();
+
+   // -----------------------------------------------------------------------
+   // IFMEMappingFile
+   virtual FME_Boolean fetchWithPrefix(const char* prefix1, const char* prefix2,
+                                       const char* keyword, IFMEString& value);
+
+   // -----------------------------------------------------------------------
+   // set()
+   void set(const string& keyword, const string& value);
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   HeadlessMappingFile(const HeadlessMappingFile&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   HeadlessMappingFile &operator=(const HeadlessMappingFile&);
+
+   // Data members
+
+   map<string, string> values_;
+};
+
+#endif
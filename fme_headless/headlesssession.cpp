@@ -0,0 +1,87 @@
+/*=============================================================================
+
+   Name     : headlesssession.cpp
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : HeadlessSession method implementations
+
+=============================================================================*/
+
+// Include Files
+#include "headlesssession.h"
+#include "headlessfeature.h"
+#include "headlessstring.h"
+
+//===========================================================================
+// Constructor
+HeadlessSession::HeadlessSession()
+:
+   liveFeatures_(0)
+{
+}
+
+//===========================================================================
+// Destructor
+HeadlessSession::~HeadlessSession()
+{
+}
+
+//===========================================================================
+// Create Feature
+IFMEFeature* HeadlessSession::createFeature()
+{
+   ++liveFeatures_;
+   return new HeadlessFeature();
+}
+
+//===========================================================================
+// Destroy Feature
+void HeadlessSession::destroyFeature(IFMEFeature*& feature)
+{
+   if (feature)
+   {
+      --liveFeatures_;
+      delete feature;
+      feature = NULL;
+   }
+}
+
+//===========================================================================
+// Create String
+IFMEString* HeadlessSession::createString()
+{
+   return new HeadlessString();
+}
+
+//===========================================================================
+// Destroy String
+void HeadlessSession::destroyString(IFMEString*& string)
+{
+   delete string;
+   string = NULL;
+}
+
+//===========================================================================
+// Create String Array
+IFMEStringArray* HeadlessSession::createStringArray()
+{
+   return new HeadlessStringArray();
+}
+
+//===========================================================================
+// Destroy String Array
+void HeadlessSession::destroyStringArray(IFMEStringArray*& stringArray)
+{
+   delete stringArray;
+   stringArray = NULL;
+}
+
+//===========================================================================
+// Get Geometry Tools
+IFMEGeometryTools* HeadlessSession::getGeometryTools()
+{
+   return &geometryTools_;
+}
@@ -0,0 +1,68 @@
+#ifndef HEADLESS_SESSION_H
+#define HEADLESS_SESSION_H
+/*=============================================================================
+
+   Name     : headlesssession.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : Declaration of HeadlessSession
+
+=============================================================================*/
+
+#include <igeometrytools.h>
+#include <isession.h>
+
+//=====================================================================
+// HeadlessSession
+//
+// IFMESession handing out HeadlessFeatures and HeadlessStrings.
+class HeadlessSession : public IFMESession
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Constructor
+   HeadlessSession();
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   virtual ~HeadlessSession();
+
+   // -----------------------------------------------------------------------
+   // IFMESession
+   virtual IFMEFeature* createFeature();
+   virtual void destroyFeature(IFMEFeature*& feature);
+   virtual IFMEString* createString();
+   virtual void destroyString(IFMEString*& string);
+   virtual IFMEStringArray* createStringArray();
+   virtual void destroyStringArray(IFMEStringArray*& stringArray);
+   virtual IFMEGeometryTools* getGeometryTools();
+
+   // -----------------------------------------------------------------------
+   // liveFeatures()
+   // Features created but not destroyed yet, to spot leaks.
+   FME_Int64 liveFeatures() const { return liveFeatures_; }
+
+private:
+
+   // -----------------------------------------------------------------------
+   // Copy constructor
+   HeadlessSession(const HeadlessSession&);
+
+   // -----------------------------------------------------------------------
+   // Assignment operator
+   HeadlessSession &operator=(const HeadlessSession&);
+
+   // Data members
+
+   FME_Int64 liveFeatures_;
+
+   // The reader only keeps a pointer to the geometry tools.
+   IFMEGeometryTools geometryTools_;
+};
+
+#endif
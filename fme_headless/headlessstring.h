@@ -0,0 +1,79 @@
+#ifndef HEADLESS_STRING_H
+#define HEADLESS_STRING_H
+/*=============================================================================
+
+   Name     : headlessstring.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : Declaration of HeadlessString and HeadlessStringArray
+
+=============================================================================*/
+
+#include <fmestring.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//=====================================================================
+// HeadlessString
+class HeadlessString : public IFMEString
+{
+
+public:
+
+   HeadlessString() {}
+   virtual ~HeadlessString() {}
+
+   virtual const char* data() const { return value_.c_str(); }
+   virtual FME_UInt32 length() const { return FME_UInt32(value_.size()); }
+   virtual void set(const char* value, FME_UInt32 length) { value_.assign(value, length); }
+
+private:
+
+   HeadlessString(const HeadlessString&);
+   HeadlessString &operator=(const HeadlessString&);
+
+   string value_;
+};
+
+//=====================================================================
+// HeadlessStringArray
+class HeadlessStringArray : public IFMEStringArray
+{
+
+public:
+
+   HeadlessStringArray() {}
+   virtual ~HeadlessStringArray() { clear(); }
+
+   virtual FME_UInt32 entries() const { return FME_UInt32(values_.size()); }
+   virtual const IFMEString* elementAt(FME_UInt32 index) const { return values_[index]; }
+   virtual void append(const char* value)
+   {
+      HeadlessString* entry = new HeadlessString;
+      entry->set(value, FME_UInt32(strlen(value)));
+      values_.push_back(entry);
+   }
+   virtual void clear()
+   {
+      for (size_t i = 0; i < values_.size(); ++i)
+      {
+         delete values_[i];
+      }
+      values_.clear();
+   }
+
+private:
+
+   HeadlessStringArray(const HeadlessStringArray&);
+   HeadlessStringArray &operator=(const HeadlessStringArray&);
+
+   vector<HeadlessString*> values_;
+};
+
+#endif
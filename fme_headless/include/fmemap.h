@@ -0,0 +1,38 @@
+#ifndef FME_HEADLESS_FMEMAP_H
+#define FME_HEADLESS_FMEMAP_H
+/*=============================================================================
+
+   Name     : fmemap.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMEMappingFile, reduced to the methods the FLUMORE plug-in
+              uses
+
+=============================================================================*/
+
+#include "fmetypes.h"
+
+// Forward declarations
+class IFMEString;
+
+//=====================================================================
+// IFMEMappingFile
+class IFMEMappingFile
+{
+
+public:
+
+   virtual ~IFMEMappingFile() {}
+
+   // -----------------------------------------------------------------------
+   // fetchWithPrefix()
+   // Looks up prefix1 + keyword, then prefix2 + keyword. Returns FME_FALSE
+   // if neither is set.
+   virtual FME_Boolean fetchWithPrefix(const char* prefix1, const char* prefix2,
+                                       const char* keyword, IFMEString& value) = 0;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FME_HEADLESS_FMEREAD_H
+#define FME_HEADLESS_FMEREAD_H
+/*=============================================================================
+
+   Name     : fmeread.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMEReader
+
+=============================================================================*/
+
+#include "fmetypes.h"
+#include "fmestring.h"
+
+// Forward declarations
+class IFMECoordSysManager;
+class IFMEFeature;
+class IFMEMappingFile;
+
+//=====================================================================
+// IFMEReader
+class IFMEReader
+{
+
+public:
+
+   virtual ~IFMEReader() {}
+
+   virtual FME_Status open(const char* datasetName, const IFMEStringArray& parameters) = 0;
+   virtual FME_Status abort() = 0;
+   virtual FME_Status close() = 0;
+   virtual FME_UInt32 id() const = 0;
+   virtual FME_Status read(IFMEFeature& feature, FME_Boolean& endOfFile) = 0;
+   virtual FME_Status readSchema(IFMEFeature& feature, FME_Boolean& endOfSchema) = 0;
+   virtual FME_Boolean getProperties(const char* propertyCategory, IFMEStringArray& values) = 0;
+};
+
+#endif
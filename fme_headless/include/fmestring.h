@@ -0,0 +1,81 @@
+#ifndef FME_HEADLESS_FMESTRING_H
+#define FME_HEADLESS_FMESTRING_H
+/*=============================================================================
+
+   Name     : fmestring.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMEString and the FMEString helper owning one
+
+=============================================================================*/
+
+#include "fmetypes.h"
+#include "isession.h"
+
+#include <cstddef>
+
+//=====================================================================
+// IFMEString
+class IFMEString
+{
+
+public:
+
+   virtual ~IFMEString() {}
+
+   virtual const char* data() const = 0;
+   virtual FME_UInt32 length() const = 0;
+   virtual void set(const char* value, FME_UInt32 length) = 0;
+};
+
+//=====================================================================
+// IFMEStringArray
+class IFMEStringArray
+{
+
+public:
+
+   virtual ~IFMEStringArray() {}
+
+   virtual FME_UInt32 entries() const = 0;
+   virtual const IFMEString* elementAt(FME_UInt32 index) const = 0;
+   virtual void append(const char* value) = 0;
+   virtual void clear() = 0;
+};
+
+//=====================================================================
+// FMEString
+//
+// Creates an IFMEString from the session set with setSession() and
+// destroys it again when going out of scope.
+class FMEString
+{
+
+public:
+
+   FMEString() : string_(session() ? session()->createString() : NULL) {}
+   ~FMEString() { if (string_) session()->destroyString(string_); }
+
+   IFMEString& operator*() { return *string_; }
+   IFMEString* operator->() { return string_; }
+
+   static void setSession(IFMESession* fmeSession) { session() = fmeSession; }
+
+private:
+
+   FMEString(const FMEString&);
+   FMEString &operator=(const FMEString&);
+
+   static IFMESession*& session()
+   {
+      static IFMESession* fmeSession = NULL;
+      return fmeSession;
+   }
+
+   IFMEString* string_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef FME_HEADLESS_FMETYPES_H
+#define FME_HEADLESS_FMETYPES_H
+/*=============================================================================
+
+   Name     : fmetypes.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : The basic FME SDK types, just enough to build the FLUMORE
+              plug-in sources without an FME installation
+
+=============================================================================*/
+
+#include <cstdint>
+
+typedef int8_t   FME_Int8;
+typedef uint8_t  FME_UInt8;
+typedef int16_t  FME_Int16;
+typedef uint16_t FME_UInt16;
+typedef int32_t  FME_Int32;
+typedef uint32_t FME_UInt32;
+typedef int64_t  FME_Int64;
+typedef uint64_t FME_UInt64;
+typedef float    FME_Real32;
+typedef double   FME_Real64;
+
+typedef FME_Int32 FME_MsgNum;
+
+enum FME_Boolean
+{
+   FME_FALSE = 0,
+   FME_TRUE  = 1
+};
+
+enum FME_Status
+{
+   FME_SUCCESS = 0,
+   FME_FAILURE = 1
+};
+
+enum FME_MsgLevel
+{
+   FME_INFORM = 0,
+   FME_WARN,
+   FME_ERROR,
+   FME_FATAL,
+   FME_STATISTIC,
+   FME_STATUSREPORT
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FME_HEADLESS_FMEWRT_H
+#define FME_HEADLESS_FMEWRT_H
+/*=============================================================================
+
+   Name     : fmewrt.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMEWriter, reduced to the methods the FLUMORE plug-in
+              implements
+
+=============================================================================*/
+
+#include "fmetypes.h"
+#include "fmestring.h"
+
+// Forward declarations
+class IFMECoordSysManager;
+class IFMEFeature;
+class IFMEMappingFile;
+
+//=====================================================================
+// IFMEWriter
+class IFMEWriter
+{
+
+public:
+
+   virtual ~IFMEWriter() {}
+
+   virtual FME_Status open(const char* datasetName, const IFMEStringArray& parameters) = 0;
+   virtual FME_Status abort() = 0;
+   virtual FME_Status close() = 0;
+   virtual FME_UInt32 id() const = 0;
+   virtual FME_Status write(const IFMEFeature& feature) = 0;
+   virtual FME_Boolean multiFileWriter() const = 0;
+};
+
+#endif
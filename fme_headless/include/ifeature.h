@@ -0,0 +1,67 @@
+#ifndef FME_HEADLESS_IFEATURE_H
+#define FME_HEADLESS_IFEATURE_H
+/*=============================================================================
+
+   Name     : ifeature.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMEFeature, reduced to the methods the FLUMORE plug-in uses
+
+=============================================================================*/
+
+#include "fmetypes.h"
+
+class IFMEString;
+
+//=====================================================================
+// IFMEFeature
+//
+// A feature is a feature type and a list of attributes. Only the calls
+// made by the FLUMORE reader and writer are declared here.
+class IFMEFeature
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   virtual ~IFMEFeature() {}
+
+   // -----------------------------------------------------------------------
+   // Feature type
+   virtual void setFeatureType(const char* featureType) = 0;
+   virtual const char* getFeatureType() const = 0;
+
+   // -----------------------------------------------------------------------
+   // Coordinate system, the empty string if there is none.
+   virtual void setCoordSys(const char* coordSys) = 0;
+   virtual const char* getCoordSys() const = 0;
+
+   // -----------------------------------------------------------------------
+   // Attributes. Setting an attribute replaces a previous value of the
+   // same name; without a value the attribute is set to the empty string.
+   virtual void setAttribute(const char* attrName, const char* attrValue = "") = 0;
+   virtual void setAttribute(const char* attrName, FME_Int32 attrValue) = 0;
+   virtual void setAttribute(const char* attrName, FME_Real64 attrValue) = 0;
+   virtual void setSequencedAttribute(const char* attrName, const char* attrValue) = 0;
+
+   virtual FME_Boolean getAttribute(const char* attrName, FME_Int32& attrValue) const = 0;
+   virtual FME_Boolean getAttribute(const char* attrName, FME_Real64& attrValue) const = 0;
+   virtual FME_Boolean getAttribute(const char* attrName, IFMEString& attrValue) const = 0;
+   virtual FME_UInt32 numAttributes() const = 0;
+
+   // -----------------------------------------------------------------------
+   // clone()
+   // Replaces the content of destFeature with a copy of this feature.
+   virtual void clone(IFMEFeature& destFeature) const = 0;
+
+   // -----------------------------------------------------------------------
+   // resetFeature()
+   // Removes the feature type and all attributes.
+   virtual void resetFeature() = 0;
+};
+
+#endif
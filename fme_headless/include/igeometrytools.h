@@ -0,0 +1,27 @@
+#ifndef FME_HEADLESS_IGEOMETRYTOOLS_H
+#define FME_HEADLESS_IGEOMETRYTOOLS_H
+/*=============================================================================
+
+   Name     : igeometrytools.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMEGeometryTools, the reader only keeps a pointer to it
+
+=============================================================================*/
+
+#include "fmetypes.h"
+
+//=====================================================================
+// IFMEGeometryTools
+class IFMEGeometryTools
+{
+
+public:
+
+   virtual ~IFMEGeometryTools() {}
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef FME_HEADLESS_ILOGFILE_H
+#define FME_HEADLESS_ILOGFILE_H
+/*=============================================================================
+
+   Name     : ilogfile.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMELogFile, reduced to the methods the FLUMORE plug-in uses
+
+=============================================================================*/
+
+#include "fmetypes.h"
+
+// Forward declarations
+class IFMEFeature;
+
+//=====================================================================
+// IFMELogFile
+class IFMELogFile
+{
+
+public:
+
+   virtual ~IFMELogFile() {}
+
+   virtual void logMessageString(const char* message, FME_MsgLevel severity = FME_INFORM) = 0;
+   virtual void logFeature(const IFMEFeature& feature, FME_MsgLevel severity = FME_INFORM,
+                           FME_Int32 maxCoords = -1) = 0;
+};
+
+#endif
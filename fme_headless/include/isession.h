@@ -0,0 +1,53 @@
+#ifndef FME_HEADLESS_ISESSION_H
+#define FME_HEADLESS_ISESSION_H
+/*=============================================================================
+
+   Name     : isession.h
+
+   System   : FME Plug-in SDK (headless stand-in)
+
+   Language : C++
+
+   Purpose  : IFMESession, reduced to the methods the FLUMORE plug-in uses
+
+=============================================================================*/
+
+#include "fmetypes.h"
+
+// Forward declarations
+class IFMEFeature;
+class IFMEGeometryTools;
+class IFMEString;
+class IFMEStringArray;
+
+//=====================================================================
+// IFMESession
+//
+// Creates and destroys the objects handed to the plug-in.
+class IFMESession
+{
+
+public:
+
+   // -----------------------------------------------------------------------
+   // Destructor
+   virtual ~IFMESession() {}
+
+   // -----------------------------------------------------------------------
+   // Features
+   virtual IFMEFeature* createFeature() = 0;
+   virtual void destroyFeature(IFMEFeature*& feature) = 0;
+
+   // -----------------------------------------------------------------------
+   // Strings
+   virtual IFMEString* createString() = 0;
+   virtual void destroyString(IFMEString*& string) = 0;
+   virtual IFMEStringArray* createStringArray() = 0;
+   virtual void destroyStringArray(IFMEStringArray*& stringArray) = 0;
+
+   // -----------------------------------------------------------------------
+   // getGeometryTools()
+   virtual IFMEGeometryTools* getGeometryTools() = 0;
+};
+
+#endif
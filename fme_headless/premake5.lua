@@ -0,0 +1,61 @@
+-- Compressed FLUMORE input needs the libraries, e.g.
+-- premake5 --with-zlib --with-zstd gmake2
+newoption { trigger = "with-zlib", description = "Read gzip compressed FLUMORE files, links zlib" }
+newoption { trigger = "with-zstd", description = "Read zstd compressed FLUMORE files, links libzstd" }
+newoption { trigger = "with-uring", description = "Read large FLUMORE files through io_uring on Linux" }
+
+workspace "FlumoreHeadless"
+
+    configurations { "Debug", "Release" }
+    platforms { "x64" }
+
+    filter "configurations:Release"
+        symbols "On"
+        optimize "Speed"
+        defines { "NDEBUG" }
+
+    filter "configurations:Debug"
+        symbols "On"
+
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "options:with-zlib"
+        defines { "FLUMORE_WITH_ZLIB" }
+        links { "z" }
+
+    filter "options:with-zstd"
+        defines { "FLUMORE_WITH_ZSTD" }
+        links { "zstd" }
+
+    filter { "options:with-uring", "system:linux" }
+        defines { "FLUMORE_WITH_URING" }
+
+    filter {}
+
+    project("flumore_headless")
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++14"
+        -- The reader is built without the Mono bridge and reads with the
+        -- native parser only.
+        defines { "FLUMORE_NO_MONO" }
+        includedirs { "include", ".", "../fme_flumore_reader" }
+        files {
+            "include/*.h", "headless*.h", "headless*.cpp", "flumoreheadless.cpp",
+            "../fme_flumore_reader/flumorereader.h", "../fme_flumore_reader/flumorereader.cpp",
+            "../fme_flumore_reader/flumorewriter.h", "../fme_flumore_reader/flumorewriter.cpp",
+            "../fme_flumore_reader/flumorefilewriter.h", "../fme_flumore_reader/flumorefilewriter.cpp",
+            "../fme_flumore_reader/flumorecompactrows.h", "../fme_flumore_reader/flumorecompactrows.cpp",
+            "../fme_flumore_reader/flumorereprojector.h", "../fme_flumore_reader/flumorereprojector.cpp",
+            "../fme_flumore_reader/flumorethreadpool.h", "../fme_flumore_reader/flumorethreadpool.cpp",
+            "../fme_flumore_reader/flumoreparser.h", "../fme_flumore_reader/flumoreparser.cpp",
+            "../fme_flumore_reader/flumorefilereader.h", "../fme_flumore_reader/flumorefilereader.cpp",
+            "../fme_flumore_reader/flumoredecompressor.h", "../fme_flumore_reader/flumoredecompressor.cpp",
+            "../fme_flumore_reader/flumorecache.h", "../fme_flumore_reader/flumorecache.cpp",
+            "../fme_flumore_reader/flumorearena.h", "../fme_flumore_reader/flumorearena.cpp",
+            "../fme_flumore_reader/flumoreformat.h", "../fme_flumore_reader/flumoreformat.cpp",
+            "../fme_flumore_reader/flumorefeaturebuilder.h", "../fme_flumore_reader/flumorefeaturebuilder.cpp",
+            "../fme_flumore_reader/flumorelog.h", "../fme_flumore_reader/flumorelog.cpp",
+            "../fme_flumore_reader/flumorestats.h", "../fme_flumore_reader/flumorestats.cpp"
+        }